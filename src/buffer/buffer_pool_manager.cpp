@@ -1,258 +1,547 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-static const char EMPTY_PAGE_DATA[PAGE_SIZE] = {0};
-
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager) {
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size_);
-  for (size_t i = 0; i < pool_size_; i++) {
-    free_list_.emplace_back(i);
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances,
+                                     ReplacerType replacer_type, bool use_huge_pages, size_t max_pool_size)
+    : pool_size_(pool_size), max_pool_size_(std::max(pool_size, max_pool_size)), disk_manager_(disk_manager) {
+  ASSERT(num_instances > 0 && num_instances <= pool_size, "Invalid number of buffer pool instances.");
+  // Spread the frames evenly, the first pool_size % num_instances instances get one extra frame.
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_.emplace_back(new BufferPoolManagerInstance(InstanceShare(pool_size, i, num_instances), disk_manager_,
+                                                          replacer_type, use_huge_pages,
+                                                          InstanceShare(max_pool_size_, i, num_instances)));
   }
+  if (disk_manager_->IsMapped()) {
+    num_views_ = disk_manager_->GetMappedPageCount();
+    views_ = std::make_unique<std::atomic<Page *>[]>(num_views_);
+  }
+  prefetch_thread_ = std::thread(&BufferPoolManager::RunPrefetch, this);
 }
 
 BufferPoolManager::~BufferPoolManager() {
-  for (auto page : page_table_) {
-    FlushPage(page.first);
+  DisableBackgroundFlush();
+  warm_up_stop_ = true;
+  WaitForWarmUp();
+  if (!hot_pages_file_.empty()) {
+    SaveHotPages(hot_pages_file_);
+  }
+  {
+    std::scoped_lock<std::mutex> lock(prefetch_latch_);
+    prefetch_stop_ = true;
+  }
+  prefetch_cv_.notify_all();
+  prefetch_thread_.join();
+  FlushAllPages();
+  for (auto instance : instances_) {
+    delete instance;
+  }
+  for (size_t i = 0; i < num_views_; i++) {
+    delete views_[i].load(std::memory_order_relaxed);
   }
-  delete[] pages_;
-  delete replacer_;
 }
 
-/**
- * TODO: Student Implement
- */
 Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-  std::scoped_lock<std::recursive_mutex> lock(latch_);
-
-  // 1. Search the page table for the requested page (P).
-  auto it = page_table_.find(page_id);
-  if (it != page_table_.end()) {
-    // 1.1 If P exists, pin it and return it immediately.
-    frame_id_t frame_id = it->second;
-    Page *page = &pages_[frame_id];
-    page->pin_count_++;
-    replacer_->Pin(frame_id);
-    return page;
-  }
-
-  // 1.2 If P does not exist, find a replacement page (R) from either the free list or the replacer.
-  frame_id_t frame_id;
-  if (!TryToFindFreePage(&frame_id)) {
+  if (page_id < 0) {
     return nullptr;
   }
-
-  Page *replacement_page = &pages_[frame_id];
-
-  // 2. If R is dirty, write it back to the disk.
-  if (replacement_page->IsDirty()) {
-    disk_manager_->WritePage(replacement_page->GetPageId(), replacement_page->GetData());
-    replacement_page->is_dirty_ = false;
+  if (views_ != nullptr) {
+    return FetchView(page_id);
   }
+  return GetInstance(page_id)->FetchPage(page_id);
+}
 
-  // 3. Delete R from the page table and insert P.
-  if (replacement_page->GetPageId() != INVALID_PAGE_ID) {
-    page_table_.erase(replacement_page->GetPageId());
+Page *BufferPoolManager::FetchView(page_id_t page_id) {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= num_views_) {
+    return nullptr;
   }
+  Page *page = views_[page_id].load(std::memory_order_acquire);
+  if (page == nullptr) {
+    const char *data = disk_manager_->GetPageView(page_id);
+    if (data == nullptr) {
+      return nullptr;
+    }
+    // the mapping is PROT_READ, the data of a view can be read and latched but writing to it faults
+    std::unique_ptr<Page> view(new Page(const_cast<char *>(data)));
+    view->page_id_.store(page_id, std::memory_order_relaxed);
+    // the loser of a race to create the view uses the winner's
+    if (views_[page_id].compare_exchange_strong(page, view.get(), std::memory_order_acq_rel)) {
+      page = view.release();
+    }
+  }
+  page->pin_count_.fetch_add(1, std::memory_order_relaxed);
+  stats_.Add(BufferPoolStats::HITS, 1);
+  return page;
+}
 
-  // Insert P into the page table
-  page_table_[page_id] = frame_id;
-
-  // 4. Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  replacement_page->ResetMemory();
-  replacement_page->page_id_ = page_id;
-  replacement_page->pin_count_ = 1;
-  replacement_page->is_dirty_ = false;
-
-  disk_manager_->ReadPage(page_id, replacement_page->GetData());
-
-  return replacement_page;
+bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  if (page_id < 0) {
+    return false;
+  }
+  if (is_dirty && IsReadOnly()) {
+    LOG(ERROR) << "Page " << page_id << " was changed in a read-only database, the change is dropped";
+    UnpinPage(page_id, false);
+    return false;
+  }
+  if (views_ != nullptr) {
+    Page *page = page_id >= 0 && static_cast<size_t>(page_id) < num_views_
+                     ? views_[page_id].load(std::memory_order_acquire)
+                     : nullptr;
+    if (page == nullptr || page->GetPinCount() <= 0) {
+      return false;
+    }
+    page->pin_count_.fetch_sub(1, std::memory_order_release);
+    return true;
+  }
+  return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
 }
 
-/**
- * TODO: Student Implement
- */
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-  
-  std::scoped_lock<std::recursive_mutex> lock(latch_);
+bool BufferPoolManager::FlushPage(page_id_t page_id) {
+  // views have nothing to write back
+  if (page_id == INVALID_PAGE_ID || views_ != nullptr) {
+    return false;
+  }
+  return GetInstance(page_id)->FlushPage(page_id);
+}
 
-  // 1. If all the pages in the buffer pool are pinned, return nullptr.
-  frame_id_t frame_id;
-  if (!TryToFindFreePage(&frame_id)) {
-    return nullptr;
+size_t BufferPoolManager::FlushAllPages() {
+  vector<pair<page_id_t, Page *>> pages;
+  for (auto instance : instances_) {
+    instance->PinDirtyPages(&pages);
+  }
+  vector<pair<page_id_t, const char *>> writes;
+  writes.reserve(pages.size());
+  for (auto &page : pages) {
+    writes.emplace_back(page.first, page.second->GetData());
   }
+  auto start = std::chrono::steady_clock::now();
+  disk_manager_->WritePages(std::move(writes));
+  disk_manager_->Checkpoint();
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  for (auto &page : pages) {
+    GetInstance(page.first)->UnpinPage(page.first, false);
+  }
+  stats_.Add(BufferPoolStats::FLUSHES, pages.size());
+  stats_.Add(BufferPoolStats::DISK_WRITES, pages.size());
+  stats_.Add(BufferPoolStats::DISK_WRITE_NS, elapsed.count());
+  return pages.size();
+}
 
-  // 0. Allocate a new page
-  page_id = AllocatePage();
+Page *BufferPoolManager::NewPage(page_id_t &page_id, segment_id_t segment) {
+  // The disk manager decides the page id, which in turn decides the instance that has to hold the page.
+  page_id = AllocatePage(segment);
   if (page_id == INVALID_PAGE_ID) {
     return nullptr;
   }
-
-  Page *new_page = &pages_[frame_id];
-
-  // 2. If R is dirty, write it back to the disk.
-  if (new_page->IsDirty()) {
-    disk_manager_->WritePage(new_page->GetPageId(), new_page->GetData());
-  }
-
-  // 3. Delete R from the page table and insert P.
-  if (new_page->GetPageId() != INVALID_PAGE_ID) {
-    page_table_.erase(new_page->GetPageId());
+  Page *page = GetInstance(page_id)->NewPage(page_id);
+  if (page == nullptr) {
+    // All frames of that instance are pinned, give the page id back.
+    DeallocatePage(page_id);
   }
-
-  // Insert new page into the page table
-  page_table_[page_id] = frame_id;
-
-  // 4. Update P's metadata, zero out memory and add P to the page table.
-  new_page->ResetMemory();
-  memcpy(new_page->GetData(), EMPTY_PAGE_DATA, PAGE_SIZE);
-  new_page->page_id_ = page_id;
-  new_page->pin_count_ = 1;
-  new_page->is_dirty_ = false;
-
-  // 5. Return a pointer to P.
-  return new_page;
-  
- 
+  return page;
 }
 
-/**
- * TODO: Student Implement
- */
 bool BufferPoolManager::DeletePage(page_id_t page_id) {
-  std::scoped_lock<std::recursive_mutex> lock(latch_);
-
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end()) {
-    // 1. If P does not exist, return true.
-    return true;
+  if (IsReadOnly()) {
+    LOG(ERROR) << "Cannot delete page " << page_id << " of a read-only database";
+    return false;
   }
-
-  frame_id_t frame_id = it->second;
-  Page *page = &pages_[frame_id];
-
-  // 2. If P exists, but has a non-zero pin-count, return false. Someone is using the page.
-  if (page->pin_count_ > 0) {
+  if (!GetInstance(page_id)->DeletePage(page_id)) {
     return false;
   }
+  DeallocatePage(page_id);
+  return true;
+}
 
-  // 3. Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  page_table_.erase(page_id);
-  replacer_->Unpin(frame_id); // Remove from replacer
+page_id_t BufferPoolManager::AllocatePage(segment_id_t segment) {
+  int next_page_id = disk_manager_->AllocatePage(segment);
+  return next_page_id;
+}
 
-  page->ResetMemory();
-  page->page_id_ = INVALID_PAGE_ID;
-  page->pin_count_ = 0;
-  page->is_dirty_ = false;
+void BufferPoolManager::DeallocatePage(page_id_t page_id) { disk_manager_->DeAllocatePage(page_id); }
 
-  free_list_.push_back(frame_id);
+bool BufferPoolManager::IsPageFree(page_id_t page_id) { return disk_manager_->IsPageFree(page_id); }
 
-  // Deallocate the page
-  DeallocatePage(page_id);
+void BufferPoolManager::ReleaseSegment(segment_id_t segment) { disk_manager_->ReleaseSegment(segment); }
 
-  return true;
+void BufferPoolManager::EnableBackgroundFlush(double clean_fraction, std::chrono::milliseconds interval) {
+  ASSERT(clean_fraction >= 0 && clean_fraction <= 1, "Invalid clean fraction.");
+  std::scoped_lock<std::mutex> lock(flush_latch_);
+  clean_fraction_ = clean_fraction;
+  flush_interval_ = interval;
+  if (!flush_thread_.joinable()) {
+    flush_stop_ = false;
+    flush_thread_ = std::thread(&BufferPoolManager::RunBackgroundFlush, this);
+  }
+  // A running writer picks the new settings up right away.
+  flush_cv_.notify_all();
 }
 
-/**
- * TODO: Student Implement
- */
-bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-  std::scoped_lock<std::recursive_mutex> lock(latch_);
+void BufferPoolManager::DisableBackgroundFlush() {
+  {
+    std::scoped_lock<std::mutex> lock(flush_latch_);
+    flush_stop_ = true;
+  }
+  flush_cv_.notify_all();
+  if (flush_thread_.joinable()) {
+    flush_thread_.join();
+  }
+}
 
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end()) {
-    return false;
+size_t BufferPoolManager::FlushAhead(PageIOQueue *io) {
+  double clean_fraction;
+  {
+    std::scoped_lock<std::mutex> lock(flush_latch_);
+    clean_fraction = clean_fraction_;
+  }
+  vector<page_id_t> page_ids;
+  for (auto instance : instances_) {
+    auto min_clean = static_cast<size_t>(clean_fraction * instance->GetPoolSize());
+    instance->CollectFlushCandidates(min_clean, &page_ids);
   }
+  // The disk manager maps logical page ids to physical pages monotonically, so this makes the writes sequential.
+  std::sort(page_ids.begin(), page_ids.end());
+  std::unique_ptr<PageIOQueue> own_io;
+  if (io == nullptr) {
+    own_io = disk_manager_->CreateIOQueue();
+    io = own_io.get();
+  }
+  size_t flushed = 0;
+  RunTransfers(
+      io, page_ids.size(),
+      [&](size_t i, PageIORequest *request, bool *) {
+        Page *page = GetInstance(page_ids[i])->StartFlush(page_ids[i]);
+        if (page == nullptr) {
+          return false;
+        }
+        *request = {PageIORequest::WRITE, page_ids[i], page->GetData(), page};
+        return true;
+      },
+      [&](PageIORequest *request, uint64_t write_ns) {
+        GetInstance(request->page_id_)->FinishFlush(static_cast<Page *>(request->user_data_), write_ns);
+        flushed++;
+      });
+  return flushed;
+}
 
-  frame_id_t frame_id = page_table_[page_id];
-  Page *page = &pages_[frame_id];
+void BufferPoolManager::RunTransfers(PageIOQueue *io, size_t count,
+                                     const std::function<bool(size_t, PageIORequest *, bool *)> &start,
+                                     const std::function<void(PageIORequest *, uint64_t)> &finish) {
+  struct Transfer : PageIORequest {
+    std::chrono::steady_clock::time_point start_;
+  };
+  vector<Transfer> transfers(io->GetDepth());
+  vector<Transfer *> idle;
+  for (auto &transfer : transfers) {
+    idle.push_back(&transfer);
+  }
+  vector<PageIORequest *> batch;
+  vector<PageIORequest *> done;
+  auto reap = [&](size_t min_complete) {
+    done.clear();
+    io->Reap(&done, min_complete);
+    auto now = std::chrono::steady_clock::now();
+    for (auto request : done) {
+      auto *transfer = static_cast<Transfer *>(request);
+      finish(transfer, std::chrono::duration_cast<std::chrono::nanoseconds>(now - transfer->start_).count());
+      idle.push_back(transfer);
+    }
+  };
+  bool stop = false;
+  for (size_t i = 0; i < count && !stop; i++) {
+    if (idle.empty()) {
+      io->Submit(batch);
+      batch.clear();
+      reap(1);
+    }
+    Transfer *transfer = idle.back();
+    if (!start(i, transfer, &stop)) {
+      continue;
+    }
+    idle.pop_back();
+    transfer->start_ = std::chrono::steady_clock::now();
+    batch.push_back(transfer);
+  }
+  io->Submit(batch);
+  while (io->InFlight() > 0) {
+    reap(io->InFlight());
+  }
+}
 
-  //if (page->pin_count_ <= 0) {
-  //  return false;
-  //}
-  if (page->GetPinCount() == 0) {
-    return true; // 页面未被固定
+bool BufferPoolManager::LoadPages(const vector<page_id_t> &page_ids, PageIOQueue *io) {
+  bool full = false;
+  RunTransfers(
+      io, page_ids.size(),
+      [&](size_t i, PageIORequest *request, bool *stop) {
+        Page *page = GetInstance(page_ids[i])->StartLoad(page_ids[i], &full);
+        if (page == nullptr) {
+          // reading further ahead would only evict what was just read
+          *stop = full;
+          return false;
+        }
+        *request = {PageIORequest::READ, page_ids[i], page->GetData(), page};
+        return true;
+      },
+      [&](PageIORequest *request, uint64_t read_ns) {
+        GetInstance(request->page_id_)->FinishLoad(static_cast<Page *>(request->user_data_), read_ns);
+      });
+  return !full;
+}
+
+void BufferPoolManager::RunBackgroundFlush() {
+  auto io = disk_manager_->CreateIOQueue();
+  std::unique_lock<std::mutex> lock(flush_latch_);
+  auto last_save = std::chrono::steady_clock::now();
+  while (!flush_stop_) {
+    flush_cv_.wait_for(lock, flush_interval_);
+    if (flush_stop_) {
+      break;
+    }
+    std::string hot_pages_file = hot_pages_file_;
+    lock.unlock();
+    FlushAhead(io.get());
+    auto now = std::chrono::steady_clock::now();
+    if (!hot_pages_file.empty() && now - last_save >= std::chrono::milliseconds(HOT_PAGES_SAVE_INTERVAL_MS)) {
+      SaveHotPages(hot_pages_file);
+      last_save = now;
+    }
+    lock.lock();
   }
+}
 
-  page->pin_count_--;
-  if (page->pin_count_ == 0) {
-    replacer_->Unpin(frame_id);
+bool BufferPoolManager::SaveHotPages(const std::string &path) {
+  vector<vector<page_id_t>> hot_pages(instances_.size());
+  size_t count = 0;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    instances_[i]->GetHotPages(&hot_pages[i]);
+    count += hot_pages[i].size();
+  }
+  // Hotness is only known within an instance, interleave the instances rank by rank.
+  vector<page_id_t> page_ids;
+  page_ids.reserve(count);
+  for (size_t rank = 0; page_ids.size() < count; rank++) {
+    for (auto &instance_pages : hot_pages) {
+      if (rank < instance_pages.size()) {
+        page_ids.push_back(instance_pages[rank]);
+      }
+    }
   }
 
-  if (is_dirty) {
-    page->is_dirty_ = true;
+  std::string tmp_path = path + ".tmp";
+  std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+  uint32_t header[3] = {HOT_PAGES_MAGIC, HOT_PAGES_VERSION, static_cast<uint32_t>(page_ids.size())};
+  out.write(reinterpret_cast<const char *>(header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(page_ids.data()), page_ids.size() * sizeof(page_id_t));
+  out.close();
+  if (!out || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Failed to save the hot pages of the buffer pool to " << path;
+    remove(tmp_path.c_str());
+    return false;
   }
+  return true;
+}
 
+bool BufferPoolManager::LoadHotPages(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open()) {
+    return false;
+  }
+  uint32_t header[3];
+  in.read(reinterpret_cast<char *>(header), sizeof(header));
+  if (!in || header[0] != HOT_PAGES_MAGIC || header[1] != HOT_PAGES_VERSION) {
+    LOG(WARNING) << path << " is not a hot page file, skipping the buffer pool warm-up";
+    return false;
+  }
+  // Only the hottest pages that fit into the pool are worth reading.
+  vector<page_id_t> page_ids(std::min<size_t>(header[2], pool_size_));
+  in.read(reinterpret_cast<char *>(page_ids.data()), page_ids.size() * sizeof(page_id_t));
+  page_ids.resize(in.gcount() / sizeof(page_id_t));
+  // The disk manager maps logical page ids to physical pages monotonically, so this reads the file front to back.
+  std::sort(page_ids.begin(), page_ids.end());
+
+  WaitForWarmUp();
+  warm_up_stop_ = false;
+  warm_up_loaded_ = 0;
+  warm_up_total_ = page_ids.size();
+  warm_up_running_ = true;
+  warm_up_thread_ = std::thread(&BufferPoolManager::RunWarmUp, this, std::move(page_ids));
   return true;
 }
 
-/**
- * TODO: Student Implement
- */
-bool BufferPoolManager::FlushPage(page_id_t page_id) {
-  std::scoped_lock<std::recursive_mutex> lock(latch_);
+void BufferPoolManager::RunWarmUp(vector<page_id_t> page_ids) {
+  LOG(INFO) << "Buffer pool warm-up started, " << page_ids.size() << " pages to load";
+  auto start = std::chrono::steady_clock::now();
+  auto io = disk_manager_->CreateIOQueue();
+  // Load in chunks of a few queue depths, so that progress and a stop request are seen along the way.
+  size_t chunk_size = 4 * io->GetDepth();
+  vector<page_id_t> chunk;
+  for (size_t i = 0; i < page_ids.size() && !warm_up_stop_; i += chunk_size) {
+    size_t end = std::min(page_ids.size(), i + chunk_size);
+    chunk.clear();
+    for (size_t j = i; j < end; j++) {
+      // The file may be older than the last de-allocations.
+      if (!IsPageFree(page_ids[j])) {
+        chunk.push_back(page_ids[j]);
+      }
+    }
+    LoadPages(chunk, io.get());
+    warm_up_loaded_ += end - i;
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  LOG(INFO) << "Buffer pool warm-up " << (warm_up_stop_ ? "stopped" : "done") << ", loaded " << warm_up_loaded_
+            << " of " << page_ids.size() << " pages in " << elapsed.count() << " ms";
+  warm_up_running_ = false;
+}
 
-  if (page_id == INVALID_PAGE_ID) {
-    return false;
+void BufferPoolManager::EnableWarmStart(const std::string &path) {
+  {
+    std::scoped_lock<std::mutex> lock(flush_latch_);
+    hot_pages_file_ = path;
   }
+  LoadHotPages(path);
+}
 
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end()) {
-    return false;
+void BufferPoolManager::WaitForWarmUp() {
+  if (warm_up_thread_.joinable()) {
+    warm_up_thread_.join();
   }
+}
 
-  frame_id_t frame_id = it->second;
-  Page *page = &pages_[frame_id];
+WarmUpProgress BufferPoolManager::GetWarmUpProgress() const {
+  WarmUpProgress progress;
+  progress.loaded_ = warm_up_loaded_;
+  progress.total_ = warm_up_total_;
+  progress.running_ = warm_up_running_;
+  return progress;
+}
 
-  disk_manager_->WritePage(page_id, page->GetData());
-  page->is_dirty_ = false;
+void BufferPoolManager::PrefetchPage(page_id_t page_id) { EnqueuePrefetch({page_id, 1, nullptr}); }
 
-  return true;
+void BufferPoolManager::PrefetchRange(page_id_t first_page_id, size_t count) {
+  EnqueuePrefetch({first_page_id, count, nullptr});
 }
 
-bool BufferPoolManager::TryToFindFreePage(frame_id_t *frame_id) {
-  // First, try to find a page from the free list
-  if (!free_list_.empty()) {
-    *frame_id = free_list_.front();
-    free_list_.pop_front();
-    return true;
+void BufferPoolManager::PrefetchChain(page_id_t page_id, size_t count, NextPageIdReader next_page) {
+  EnqueuePrefetch({page_id, count, next_page});
+}
+
+void BufferPoolManager::EnqueuePrefetch(const PrefetchRequest &request) {
+  if (request.page_id == INVALID_PAGE_ID || request.count == 0) {
+    return;
+  }
+  // The kernel reads mapped pages in, ask it to start now. Chains are not followed, that would fault their pages in
+  // one by one on this thread; the pages of a table heap or an index are mostly contiguous, see SEGMENT_RUN_PAGES.
+  if (views_ != nullptr) {
+    disk_manager_->AdviseWillNeed(request.page_id, request.count);
+    return;
   }
+  {
+    std::scoped_lock<std::mutex> lock(prefetch_latch_);
+    if (prefetch_queue_.size() >= MAX_PENDING_PREFETCHES) {
+      return;
+    }
+    prefetch_queue_.push_back(request);
+  }
+  prefetch_cv_.notify_one();
+}
 
-  // If free list is empty, try to find a victim from the replacer
-  if (replacer_->Size() > 0) {
-    if (replacer_->Victim(frame_id)) {
-      return true;
+void BufferPoolManager::RunPrefetch() {
+  auto io = disk_manager_->CreateIOQueue();
+  vector<page_id_t> page_ids;
+  std::unique_lock<std::mutex> lock(prefetch_latch_);
+  while (true) {
+    prefetch_cv_.wait(lock, [this] { return prefetch_stop_ || !prefetch_queue_.empty(); });
+    if (prefetch_stop_) {
+      break;
+    }
+    PrefetchRequest request = prefetch_queue_.front();
+    prefetch_queue_.pop_front();
+    prefetch_busy_ = true;
+    lock.unlock();
+
+    page_id_t page_id = request.page_id;
+    if (request.next_page == nullptr) {
+      // Ranges may run past the allocated pages, never read those.
+      page_ids.clear();
+      for (size_t i = 0; i < request.count; i++) {
+        if (!IsPageFree(page_id + i)) {
+          page_ids.push_back(page_id + i);
+        }
+      }
+      LoadPages(page_ids, io.get());
+    } else {
+      for (size_t i = 0; i < request.count && page_id != INVALID_PAGE_ID; i++) {
+        page_id_t next_page_id = INVALID_PAGE_ID;
+        if (!GetInstance(page_id)->PrefetchPage(page_id, request.next_page, &next_page_id)) {
+          break;  // the instance is fully pinned, reading further ahead would only evict what we just read
+        }
+        page_id = next_page_id;
+      }
+    }
+    lock.lock();
+    prefetch_busy_ = false;
+    if (prefetch_queue_.empty()) {
+      prefetch_idle_cv_.notify_all();
     }
   }
-  //LOG(INFO) << "Free frame id: " << *frame_id << endl;
-  // No available page
-  return false;
-}    
+}
 
-page_id_t BufferPoolManager::AllocatePage() {
-  int next_page_id = disk_manager_->AllocatePage();
-  //LOG(INFO) << "Allocated page_id: " << next_page_id << endl;
-  return next_page_id;
+void BufferPoolManager::WaitForPrefetches() {
+  std::unique_lock<std::mutex> lock(prefetch_latch_);
+  prefetch_idle_cv_.wait(lock, [this] { return prefetch_queue_.empty() && !prefetch_busy_; });
+}
+
+size_t BufferPoolManager::Resize(size_t pool_size) {
+  std::scoped_lock<std::mutex> lock(resize_latch_);
+  size_t num_instances = instances_.size();
+  pool_size = std::max(num_instances, std::min(pool_size, max_pool_size_));
+  size_t resized = 0;
+  for (size_t i = 0; i < num_instances; i++) {
+    resized += instances_[i]->Resize(InstanceShare(pool_size, i, num_instances));
+  }
+  pool_size_ = resized;
+  return resized;
 }
 
-void BufferPoolManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-  disk_manager_->DeAllocatePage(page_id);
+// Only used for debug
+bool BufferPoolManager::IsResident(page_id_t page_id) {
+  if (views_ != nullptr) {
+    return page_id >= 0 && static_cast<size_t>(page_id) < num_views_ &&
+           views_[page_id].load(std::memory_order_acquire) != nullptr;
+  }
+  return GetInstance(page_id)->IsResident(page_id);
 }
 
-bool BufferPoolManager::IsPageFree(page_id_t page_id) {
-  return disk_manager_->IsPageFree(page_id);
+BufferPoolCounters BufferPoolManager::GetStats() const {
+  BufferPoolCounters counters = stats_.Snapshot();
+  for (auto instance : instances_) {
+    counters += instance->GetStats();
+  }
+  return counters;
+}
+
+void BufferPoolManager::ResetStats() {
+  stats_.Reset();
+  for (auto instance : instances_) {
+    instance->ResetStats();
+  }
 }
 
 // Only used for debug
 bool BufferPoolManager::CheckAllUnpinned() {
   bool res = true;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].pin_count_ != 0) {
+  for (auto instance : instances_) {
+    res = instance->CheckAllUnpinned() && res;
+  }
+  for (size_t i = 0; i < num_views_; i++) {
+    Page *page = views_[i].load(std::memory_order_acquire);
+    if (page != nullptr && page->GetPinCount() != 0) {
       res = false;
-      LOG(ERROR) << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << endl;
     }
   }
   return res;
@@ -0,0 +1,573 @@
+#include "buffer/buffer_pool_manager_instance.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "glog/logging.h"
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                                                     ReplacerType replacer_type, bool use_huge_pages,
+                                                     size_t max_pool_size)
+    : pool_size_(pool_size),
+      max_pool_size_(std::max(pool_size, max_pool_size)),
+      frames_(max_pool_size_, use_huge_pages),
+      disk_manager_(disk_manager),
+      page_table_(max_pool_size_) {
+  // Page has no default constructor for frames, construct the metadata array in place.
+  pages_ = static_cast<Page *>(::operator new[](max_pool_size_ * sizeof(Page)));
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    new (&pages_[i]) Page(frames_.GetFrameData(i));
+  }
+  switch (replacer_type) {
+    case ReplacerType::CLOCK:
+      replacer_ = new CLOCKReplacer(max_pool_size_);
+      break;
+    case ReplacerType::LRU_K:
+      replacer_ = new LRUKReplacer(max_pool_size_);
+      break;
+    case ReplacerType::LRU:
+    default:
+      replacer_ = new LRUReplacer(max_pool_size_);
+      break;
+  }
+  for (size_t i = 0; i < pool_size; i++) {
+    free_list_.emplace_back(i);
+  }
+  // Frames above the initial size start out retired, lowest frame id at the back so that Resize grows in order.
+  for (size_t i = max_pool_size_; i > pool_size; i--) {
+    pages_[i - 1].pin_count_.store(FRAME_LOCKED, std::memory_order_relaxed);
+    retired_list_.push_back(i - 1);
+  }
+}
+
+BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    if (pages_[i].GetPageId() != INVALID_PAGE_ID && pages_[i].IsDirty()) {
+      FlushPage(pages_[i].GetPageId());
+    }
+  }
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    pages_[i].~Page();
+  }
+  ::operator delete[](pages_);
+  delete replacer_;
+}
+
+Page *BufferPoolManagerInstance::FetchPage(page_id_t page_id) {
+  // 1. Resident pages are pinned without the latch.
+  Page *page = TryPinResident(page_id);
+  if (page != nullptr) {
+    stats_.Add(BufferPoolStats::HITS);
+    return page;
+  }
+  return PinPage(page_id, true);
+}
+
+Page *BufferPoolManagerInstance::PinPage(page_id_t page_id, bool record_access) {
+  auto lock = AcquireLatch();
+  Page *page;
+  while (true) {
+    // 1.1 Search the page table again, nobody can remap a frame while we hold the latch.
+    frame_id_t frame_id = page_table_.Find(page_id);
+    if (frame_id != INVALID_FRAME_ID) {
+      page = &pages_[frame_id];
+      if (page->io_state_.load(std::memory_order_acquire) == Page::IOState::WRITING_BACK) {
+        // The frame is being evicted, look again once it is remapped or given back.
+        io_cv_.wait(lock);
+        continue;
+      }
+      // If another thread is still reading P in, wait for that read instead of issuing a second one.
+      page->pin_count_.fetch_add(1, std::memory_order_acq_rel);
+      if (record_access) {
+        replacer_->Pin(frame_id);
+        stats_.Add(BufferPoolStats::HITS);
+      }
+      io_cv_.wait(lock, [page] { return page->io_state_.load(std::memory_order_acquire) != Page::IOState::LOADING; });
+      return page;
+    }
+
+    // 1.2 If P does not exist, find a replacement page (R) from either the free list or the replacer.
+    if (!TryToFindFreePage(&frame_id)) {
+      return nullptr;
+    }
+    Page *replacement_page = &pages_[frame_id];
+
+    // 2. If R is dirty, write it back to the disk.
+    if (replacement_page->IsDirty()) {
+      WriteBackVictim(lock, frame_id);
+      if (page_table_.Find(page_id) != INVALID_FRAME_ID) {
+        // P was brought in while the latch was dropped, keep R and use that copy of P.
+        replacement_page->pin_count_.fetch_sub(FRAME_LOCKED, std::memory_order_acq_rel);
+        replacer_->Unpin(frame_id);
+        continue;
+      }
+    }
+
+    // 3. Delete R from the page table and insert P.
+    MapLoadingFrame(frame_id, page_id);
+    if (record_access) {
+      replacer_->Pin(frame_id);
+      stats_.Add(BufferPoolStats::MISSES);
+    }
+
+    // 4. Read in the page content from disk without the latch, and then return a pointer to P.
+    lock.unlock();
+    replacement_page->ResetMemory();
+    ReadFromDisk(page_id, replacement_page->GetData());
+    LockLatch(lock);
+    replacement_page->io_state_.store(Page::IOState::READY, std::memory_order_release);
+    io_cv_.notify_all();
+    return replacement_page;
+  }
+}
+
+Page *BufferPoolManagerInstance::NewPage(page_id_t page_id) {
+  auto lock = AcquireLatch();
+
+  // 1. If all the pages in the buffer pool are pinned, return nullptr.
+  frame_id_t frame_id;
+  if (!TryToFindFreePage(&frame_id)) {
+    return nullptr;
+  }
+
+  Page *new_page = &pages_[frame_id];
+
+  // 2. If R is dirty, write it back to the disk. Nobody else can ask for P, it has just been allocated.
+  if (new_page->IsDirty()) {
+    WriteBackVictim(lock, frame_id);
+  }
+
+  // 3. Delete R from the page table and insert P.
+  if (new_page->GetPageId() != INVALID_PAGE_ID) {
+    page_table_.Erase(new_page->GetPageId());
+    stats_.Add(BufferPoolStats::EVICTIONS);
+  }
+
+  // 4. Update P's metadata, zero out memory and add P to the page table.
+  new_page->ResetMemory();
+  new_page->page_id_.store(page_id, std::memory_order_release);
+  new_page->is_dirty_.store(false, std::memory_order_release);
+
+  page_table_.Insert(page_id, frame_id);
+  UnlockFramePinned(new_page);
+  replacer_->Pin(frame_id);
+  stats_.Add(BufferPoolStats::NEW_PAGES);
+  return new_page;
+}
+
+bool BufferPoolManagerInstance::DeletePage(page_id_t page_id) {
+  auto lock = AcquireLatch();
+
+  frame_id_t frame_id;
+  Page *page;
+  while (true) {
+    frame_id = page_table_.Find(page_id);
+    if (frame_id == INVALID_FRAME_ID) {
+      // 1. If P does not exist, return true.
+      return true;
+    }
+    page = &pages_[frame_id];
+    if (page->io_state_.load(std::memory_order_acquire) != Page::IOState::WRITING_BACK) {
+      break;
+    }
+    io_cv_.wait(lock);
+  }
+
+  // 2. If P exists, but has a non-zero pin-count, return false. Someone is using the page.
+  if (!LockFrame(page)) {
+    return false;
+  }
+
+  // 3. Otherwise, P can be deleted. Remove P from the page table and the replacer, reset its metadata and return it
+  // to the free list.
+  page_table_.Erase(page_id);
+  replacer_->Remove(frame_id);
+
+  page->ResetMemory();
+  page->page_id_.store(INVALID_PAGE_ID, std::memory_order_release);
+  page->is_dirty_.store(false, std::memory_order_release);
+  page->pin_count_.fetch_sub(FRAME_LOCKED, std::memory_order_acq_rel);
+
+  free_list_.push_back(frame_id);
+  stats_.Add(BufferPoolStats::DELETED_PAGES);
+  return true;
+}
+
+bool BufferPoolManagerInstance::UnpinPage(page_id_t page_id, bool is_dirty) {
+  frame_id_t frame_id = page_table_.Find(page_id);
+  if (frame_id == INVALID_FRAME_ID) {
+    // The lock-free lookup may miss an entry while the table is rebuilt, ask again under the latch.
+    auto lock = AcquireLatch();
+    frame_id = page_table_.Find(page_id);
+    if (frame_id == INVALID_FRAME_ID) {
+      return false;
+    }
+  }
+
+  Page *page = &pages_[frame_id];
+  int pin_count = page->pin_count_.load(std::memory_order_acquire);
+  if (pin_count <= 0 || page->GetPageId() != page_id) {
+    return true;  // 页面未被固定
+  }
+
+  // The dirty flag has to be visible before the pin is dropped, an evictor checks it right after locking the frame.
+  if (is_dirty) {
+    page->is_dirty_.store(true, std::memory_order_release);
+  }
+  while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1, std::memory_order_acq_rel)) {
+    if (pin_count <= 0) {
+      return true;
+    }
+  }
+  if (pin_count == 1) {
+    replacer_->Unpin(frame_id);
+  }
+  return true;
+}
+
+bool BufferPoolManagerInstance::FlushPage(page_id_t page_id) {
+  Page *page = StartFlush(page_id);
+  if (page == nullptr) {
+    return false;
+  }
+  WriteToDisk(page_id, page->GetData());
+  stats_.Add(BufferPoolStats::FLUSHES);
+  ReleaseFrame(static_cast<frame_id_t>(page - pages_));
+  return true;
+}
+
+Page *BufferPoolManagerInstance::StartFlush(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+
+  auto lock = AcquireLatch();
+  frame_id_t frame_id;
+  Page *page;
+  while (true) {
+    frame_id = page_table_.Find(page_id);
+    if (frame_id == INVALID_FRAME_ID) {
+      return nullptr;
+    }
+    page = &pages_[frame_id];
+    if (page->io_state_.load(std::memory_order_acquire) != Page::IOState::WRITING_BACK) {
+      break;
+    }
+    io_cv_.wait(lock);
+  }
+
+  // Pin the page so it stays in its frame while it is written without the latch.
+  page->pin_count_.fetch_add(1, std::memory_order_acq_rel);
+  io_cv_.wait(lock, [page] { return page->io_state_.load(std::memory_order_acquire) != Page::IOState::LOADING; });
+  lock.unlock();
+
+  // Clear the flag before writing, an UnpinPage(dirty) racing with the write keeps the page dirty.
+  page->is_dirty_.store(false, std::memory_order_release);
+  return page;
+}
+
+void BufferPoolManagerInstance::FinishFlush(Page *page, uint64_t write_ns) {
+  stats_.Add(BufferPoolStats::FLUSHES);
+  stats_.Add(BufferPoolStats::DISK_WRITES);
+  stats_.Add(BufferPoolStats::DISK_WRITE_NS, write_ns);
+  ReleaseFrame(static_cast<frame_id_t>(page - pages_));
+}
+
+Page *BufferPoolManagerInstance::StartLoad(page_id_t page_id, bool *full) {
+  auto lock = AcquireLatch();
+  *full = false;
+  if (page_table_.Find(page_id) != INVALID_FRAME_ID) {
+    return nullptr;
+  }
+  frame_id_t frame_id;
+  if (!TryToFindFreePage(&frame_id)) {
+    *full = true;
+    return nullptr;
+  }
+  Page *page = &pages_[frame_id];
+  if (page->IsDirty()) {
+    WriteBackVictim(lock, frame_id);
+    if (page_table_.Find(page_id) != INVALID_FRAME_ID) {
+      // Somebody else read the page in while the latch was dropped.
+      page->pin_count_.fetch_sub(FRAME_LOCKED, std::memory_order_acq_rel);
+      replacer_->Unpin(frame_id);
+      return nullptr;
+    }
+  }
+  MapLoadingFrame(frame_id, page_id);
+  lock.unlock();
+  page->ResetMemory();
+  return page;
+}
+
+void BufferPoolManagerInstance::FinishLoad(Page *page, uint64_t read_ns) {
+  {
+    auto lock = AcquireLatch();
+    page->io_state_.store(Page::IOState::READY, std::memory_order_release);
+    io_cv_.notify_all();
+  }
+  stats_.Add(BufferPoolStats::DISK_READS);
+  stats_.Add(BufferPoolStats::DISK_READ_NS, read_ns);
+  ReleaseFrame(static_cast<frame_id_t>(page - pages_));
+}
+
+void BufferPoolManagerInstance::MapLoadingFrame(frame_id_t frame_id, page_id_t page_id) {
+  Page *page = &pages_[frame_id];
+  if (page->GetPageId() != INVALID_PAGE_ID) {
+    page_table_.Erase(page->GetPageId());
+    stats_.Add(BufferPoolStats::EVICTIONS);
+  }
+  page->page_id_.store(page_id, std::memory_order_release);
+  page->is_dirty_.store(false, std::memory_order_release);
+  page->io_state_.store(Page::IOState::LOADING, std::memory_order_release);
+  page_table_.Insert(page_id, frame_id);
+  UnlockFramePinned(page);
+}
+
+Page *BufferPoolManagerInstance::TryPinResident(page_id_t page_id) {
+  frame_id_t frame_id = page_table_.Find(page_id);
+  if (frame_id == INVALID_FRAME_ID) {
+    return nullptr;
+  }
+  Page *page = &pages_[frame_id];
+  if (page->pin_count_.fetch_add(1, std::memory_order_acq_rel) < 0) {
+    // The frame is being remapped under the latch.
+    page->pin_count_.fetch_sub(1, std::memory_order_acq_rel);
+    return nullptr;
+  }
+  // Our pin keeps the frame from being remapped from now on, but it may have been remapped between the lookup and
+  // the pin. A page that is still being read in is waited for on the latched path.
+  if (page->GetPageId() != page_id ||
+      page->io_state_.load(std::memory_order_acquire) != Page::IOState::READY) {
+    ReleaseFrame(frame_id);
+    return nullptr;
+  }
+  replacer_->Pin(frame_id);
+  return page;
+}
+
+void BufferPoolManagerInstance::ReleaseFrame(frame_id_t frame_id) {
+  if (pages_[frame_id].pin_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    // May hand the replacer a frame that was pinned or freed again meanwhile, TryToFindFreePage skips those.
+    replacer_->Unpin(frame_id);
+  }
+}
+
+bool BufferPoolManagerInstance::LockFrame(Page *page) {
+  int expected = 0;
+  return page->pin_count_.compare_exchange_strong(expected, FRAME_LOCKED, std::memory_order_acq_rel);
+}
+
+void BufferPoolManagerInstance::UnlockFramePinned(Page *page) {
+  // Optimistic pinners may still be backing off, so add instead of storing.
+  page->pin_count_.fetch_add(1 - FRAME_LOCKED, std::memory_order_acq_rel);
+}
+
+bool BufferPoolManagerInstance::TryToFindFreePage(frame_id_t *frame_id) {
+  // First, try to find a page from the free list. A stale optimistic pin may briefly hold a free frame, such a frame
+  // goes to the back of the list.
+  for (size_t i = free_list_.size(); i > 0; i--) {
+    frame_id_t candidate = free_list_.front();
+    free_list_.pop_front();
+    if (LockFrame(&pages_[candidate])) {
+      *frame_id = candidate;
+      return true;
+    }
+    free_list_.push_back(candidate);
+  }
+
+  // If free list is empty, try to find a victim from the replacer. Entries of frames that were pinned lock-free or
+  // went back to the free list after entering the replacer are dropped here.
+  frame_id_t candidate;
+  while (replacer_->Victim(&candidate)) {
+    Page *page = &pages_[candidate];
+    if (page->GetPageId() != INVALID_PAGE_ID && LockFrame(page)) {
+      *frame_id = candidate;
+      return true;
+    }
+  }
+  // No available page
+  return false;
+}
+
+void BufferPoolManagerInstance::WriteBackVictim(std::unique_lock<std::recursive_mutex> &lock, frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  page->io_state_.store(Page::IOState::WRITING_BACK, std::memory_order_release);
+  page->is_dirty_.store(false, std::memory_order_release);
+  lock.unlock();
+  WriteToDisk(page->GetPageId(), page->GetData());
+  stats_.Add(BufferPoolStats::DIRTY_WRITEBACKS);
+  LockLatch(lock);
+  page->io_state_.store(Page::IOState::READY, std::memory_order_release);
+  io_cv_.notify_all();
+}
+
+size_t BufferPoolManagerInstance::Resize(size_t pool_size) {
+  pool_size = std::max<size_t>(1, std::min(pool_size, max_pool_size_));
+  auto lock = AcquireLatch();
+
+  // Grow: unlock retired frames and hand them to the free list.
+  while (pool_size_ < pool_size && !retired_list_.empty()) {
+    frame_id_t frame_id = retired_list_.back();
+    retired_list_.pop_back();
+    pages_[frame_id].pin_count_.fetch_sub(FRAME_LOCKED, std::memory_order_acq_rel);
+    free_list_.push_back(frame_id);
+    pool_size_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Shrink: take frames the same way a page miss does, free ones first and then victims of the replacer.
+  while (pool_size_ > pool_size) {
+    frame_id_t frame_id;
+    if (!TryToFindFreePage(&frame_id)) {
+      LOG(WARNING) << "Buffer pool instance can only shrink to " << pool_size_ << " frames, the others are pinned";
+      break;
+    }
+    Page *page = &pages_[frame_id];
+    if (page->IsDirty()) {
+      WriteBackVictim(lock, frame_id);
+    }
+    if (page->GetPageId() != INVALID_PAGE_ID) {
+      page_table_.Erase(page->GetPageId());
+      stats_.Add(BufferPoolStats::EVICTIONS);
+    }
+    RetireFrame(frame_id);
+  }
+  return pool_size_;
+}
+
+void BufferPoolManagerInstance::RetireFrame(frame_id_t frame_id) {
+  // The frame keeps its FRAME_LOCKED pin count, so neither lock-free pins nor TryToFindFreePage can take it.
+  Page *page = &pages_[frame_id];
+  page->page_id_.store(INVALID_PAGE_ID, std::memory_order_release);
+  page->is_dirty_.store(false, std::memory_order_release);
+  frames_.Release(frame_id);
+  retired_list_.push_back(frame_id);
+  pool_size_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void BufferPoolManagerInstance::LockLatch(std::unique_lock<std::recursive_mutex> &lock) {
+  if (lock.try_lock()) {
+    return;
+  }
+  // Only a contended acquisition reads the clock, the uncontended path stays a single try_lock.
+  auto start = std::chrono::steady_clock::now();
+  lock.lock();
+  auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  stats_.Add(BufferPoolStats::LATCH_WAITS);
+  stats_.Add(BufferPoolStats::LATCH_WAIT_NS, waited.count());
+}
+
+void BufferPoolManagerInstance::ReadFromDisk(page_id_t page_id, char *page_data) {
+  auto start = std::chrono::steady_clock::now();
+  disk_manager_->ReadPage(page_id, page_data);
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  stats_.Add(BufferPoolStats::DISK_READS);
+  stats_.Add(BufferPoolStats::DISK_READ_NS, elapsed.count());
+}
+
+void BufferPoolManagerInstance::WriteToDisk(page_id_t page_id, const char *page_data) {
+  auto start = std::chrono::steady_clock::now();
+  disk_manager_->WritePage(page_id, page_data);
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  stats_.Add(BufferPoolStats::DISK_WRITES);
+  stats_.Add(BufferPoolStats::DISK_WRITE_NS, elapsed.count());
+}
+
+void BufferPoolManagerInstance::CollectFlushCandidates(size_t min_clean, vector<page_id_t> *page_ids) {
+  size_t clean;
+  {
+    std::scoped_lock<std::recursive_mutex> lock(latch_);
+    clean = free_list_.size();
+  }
+  // Frame states are read without the latch, the counts only steer how much to write.
+  vector<page_id_t> dirty;
+  for (size_t i = 0; i < max_pool_size_ && clean < min_clean; i++) {
+    Page *page = &pages_[i];
+    page_id_t page_id = page->GetPageId();
+    if (page_id == INVALID_PAGE_ID || page->GetPinCount() != 0) {
+      continue;
+    }
+    if (page->IsDirty()) {
+      dirty.push_back(page_id);
+    } else {
+      clean++;
+    }
+  }
+  if (clean >= min_clean) {
+    return;
+  }
+  size_t missing = min(min_clean - clean, dirty.size());
+  page_ids->insert(page_ids->end(), dirty.begin(), dirty.begin() + missing);
+}
+
+void BufferPoolManagerInstance::GetHotPages(vector<page_id_t> *page_ids) {
+  auto lock = AcquireLatch();
+  vector<bool> listed(max_pool_size_, false);
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    if (pages_[i].GetPageId() != INVALID_PAGE_ID && pages_[i].GetPinCount() > 0) {
+      page_ids->push_back(pages_[i].GetPageId());
+      listed[i] = true;
+    }
+  }
+  // The replacer may still list frames that were pinned lock-free or freed meanwhile.
+  vector<frame_id_t> frames;
+  replacer_->GetHotFrames(&frames);
+  for (auto frame_id : frames) {
+    if (!listed[frame_id] && pages_[frame_id].GetPageId() != INVALID_PAGE_ID) {
+      page_ids->push_back(pages_[frame_id].GetPageId());
+      listed[frame_id] = true;
+    }
+  }
+}
+
+void BufferPoolManagerInstance::PinDirtyPages(vector<pair<page_id_t, Page *>> *pages) {
+  auto lock = AcquireLatch();
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    Page *page = &pages_[i];
+    // Under the latch only frames in WRITING_BACK (or retired ones) are locked, their writer owns them.
+    if (page->GetPageId() == INVALID_PAGE_ID || !page->IsDirty() ||
+        page->io_state_.load(std::memory_order_acquire) != Page::IOState::READY ||
+        page->pin_count_.load(std::memory_order_acquire) < 0) {
+      continue;
+    }
+    page->pin_count_.fetch_add(1, std::memory_order_acq_rel);
+    // Same as FlushPage, an UnpinPage(dirty) racing with the write keeps the page dirty.
+    page->is_dirty_.store(false, std::memory_order_release);
+    pages->emplace_back(page->GetPageId(), page);
+  }
+}
+
+bool BufferPoolManagerInstance::PrefetchPage(page_id_t page_id, NextPageIdReader next_page, page_id_t *next_page_id) {
+  if (next_page == nullptr && page_table_.Find(page_id) != INVALID_FRAME_ID) {
+    return true;
+  }
+  Page *page = PinPage(page_id, false);
+  if (page == nullptr) {
+    return false;
+  }
+  if (next_page != nullptr) {
+    page->RLatch();
+    *next_page_id = next_page(page->GetData());
+    page->RUnlatch();
+  }
+  ReleaseFrame(static_cast<frame_id_t>(page - pages_));
+  return true;
+}
+
+// Only used for debug
+bool BufferPoolManagerInstance::IsResident(page_id_t page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  return page_table_.Find(page_id) != INVALID_FRAME_ID;
+}
+
+// Only used for debug
+bool BufferPoolManagerInstance::CheckAllUnpinned() {
+  bool res = true;
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    if (pages_[i].GetPageId() != INVALID_PAGE_ID && pages_[i].GetPinCount() != 0) {
+      res = false;
+      LOG(ERROR) << "page " << pages_[i].GetPageId() << " pin count:" << pages_[i].GetPinCount() << endl;
+    }
+  }
+  return res;
+}
@@ -0,0 +1,68 @@
+#include "buffer/clock_replacer.h"
+
+#include "common/macros.h"
+
+CLOCKReplacer::CLOCKReplacer(size_t num_pages)
+    : capacity_(num_pages), in_clock_(num_pages, 0), reference_(num_pages, 0) {}
+
+CLOCKReplacer::~CLOCKReplacer() = default;
+
+bool CLOCKReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  if (size_ == 0) {
+    return false;
+  }
+  // Every frame passed loses its reference bit, so the hand stops within two turns.
+  while (true) {
+    size_t current = hand_;
+    hand_ = (hand_ + 1 == capacity_) ? 0 : hand_ + 1;
+    if (!in_clock_[current]) {
+      continue;
+    }
+    if (reference_[current]) {
+      reference_[current] = 0;
+      continue;
+    }
+    in_clock_[current] = 0;
+    size_--;
+    *frame_id = static_cast<frame_id_t>(current);
+    return true;
+  }
+}
+
+void CLOCKReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  ASSERT(static_cast<size_t>(frame_id) < capacity_, "Invalid frame id.");
+  if (in_clock_[frame_id]) {
+    in_clock_[frame_id] = 0;
+    size_--;
+  }
+}
+
+void CLOCKReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  ASSERT(static_cast<size_t>(frame_id) < capacity_, "Invalid frame id.");
+  reference_[frame_id] = 1;
+  if (!in_clock_[frame_id]) {
+    in_clock_[frame_id] = 1;
+    size_++;
+  }
+}
+
+void CLOCKReplacer::GetHotFrames(vector<frame_id_t> *frames) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  // The hand takes unreferenced frames first, and the frames it has just passed last.
+  for (uint8_t referenced : {1, 0}) {
+    for (size_t i = 1; i <= capacity_; i++) {
+      size_t current = (hand_ + capacity_ - i) % capacity_;
+      if (in_clock_[current] && reference_[current] == referenced) {
+        frames->push_back(static_cast<frame_id_t>(current));
+      }
+    }
+  }
+}
+
+size_t CLOCKReplacer::Size() {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  return size_;
+}
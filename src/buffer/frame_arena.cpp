@@ -0,0 +1,39 @@
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+
+#include <new>
+
+#include "glog/logging.h"
+
+FrameArena::FrameArena(size_t num_frames, bool use_huge_pages) {
+  size_t size = num_frames * PAGE_SIZE;
+  void *base = MAP_FAILED;
+  if (use_huge_pages) {
+    mapped_size_ = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    base = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    huge_tlb_ = base != MAP_FAILED;
+  }
+  if (base == MAP_FAILED) {
+    mapped_size_ = size;
+    base = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+      LOG(ERROR) << "Failed to map a frame arena of " << mapped_size_ << " bytes";
+      throw std::bad_alloc();
+    }
+    if (use_huge_pages) {
+      // No reserved huge pages, let the kernel back the arena with transparent huge pages where it can.
+      madvise(base, mapped_size_, MADV_HUGEPAGE);
+    }
+  }
+  base_ = static_cast<char *>(base);
+}
+
+FrameArena::~FrameArena() { munmap(base_, mapped_size_); }
+
+void FrameArena::Release(size_t frame_id) {
+  // Huge TLB mappings can only be released in huge page units, their frames just stay resident.
+  if (!huge_tlb_) {
+    madvise(GetFrameData(frame_id), PAGE_SIZE, MADV_DONTNEED);
+  }
+}
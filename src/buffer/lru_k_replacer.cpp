@@ -0,0 +1,103 @@
+#include "buffer/lru_k_replacer.h"
+
+#include "common/macros.h"
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k)
+    : max_size_(num_pages),
+      k_(k),
+      history_(static_cast<frame_id_t>(num_pages)),
+      cache_(static_cast<frame_id_t>(num_pages + 1)),
+      prev_(num_pages + 2),
+      next_(num_pages + 2),
+      in_list_(num_pages, false),
+      access_count_(num_pages, 0),
+      access_epoch_(num_pages, 0) {
+  ASSERT(k_ > 0, "k must be positive.");
+  prev_[history_] = next_[history_] = history_;
+  prev_[cache_] = next_[cache_] = cache_;
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  if (size_ == 0) {
+    return false;
+  }
+  // The back of a list is its least recently unpinned frame.
+  frame_id_t list = (next_[history_] != history_) ? history_ : cache_;
+  *frame_id = prev_[list];
+  Unlink(*frame_id);
+  access_count_[*frame_id] = 0;
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  ASSERT(static_cast<size_t>(frame_id) < max_size_, "Invalid frame id.");
+  if (in_list_[frame_id]) {
+    Unlink(frame_id);
+  }
+  RecordAccess(frame_id);
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  ASSERT(static_cast<size_t>(frame_id) < max_size_, "Invalid frame id.");
+  if (in_list_[frame_id]) {
+    return;
+  }
+  // A frame that was never pinned since its page was loaded (read-ahead) stays on the history list.
+  PushFront(access_count_[frame_id] >= k_ ? cache_ : history_, frame_id);
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  ASSERT(static_cast<size_t>(frame_id) < max_size_, "Invalid frame id.");
+  if (in_list_[frame_id]) {
+    Unlink(frame_id);
+  }
+  access_count_[frame_id] = 0;
+}
+
+void LRUKReplacer::GetHotFrames(vector<frame_id_t> *frames) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  // Frames with k accesses outrank the history list, which Victim empties first.
+  for (frame_id_t list : {cache_, history_}) {
+    for (frame_id_t frame_id = next_[list]; frame_id != list; frame_id = next_[frame_id]) {
+      frames->push_back(frame_id);
+    }
+  }
+}
+
+size_t LRUKReplacer::Size() {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  return size_;
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  if (access_count_[frame_id] == 0) {
+    load_epoch_++;
+    access_count_[frame_id] = 1;
+    access_epoch_[frame_id] = load_epoch_;
+  } else if (access_count_[frame_id] < k_ && access_epoch_[frame_id] != load_epoch_) {
+    access_count_[frame_id]++;
+    access_epoch_[frame_id] = load_epoch_;
+  }
+}
+
+void LRUKReplacer::PushFront(frame_id_t list, frame_id_t frame_id) {
+  prev_[frame_id] = list;
+  next_[frame_id] = next_[list];
+  prev_[next_[list]] = frame_id;
+  next_[list] = frame_id;
+  in_list_[frame_id] = true;
+  size_++;
+}
+
+void LRUKReplacer::Unlink(frame_id_t frame_id) {
+  next_[prev_[frame_id]] = next_[frame_id];
+  prev_[next_[frame_id]] = prev_[frame_id];
+  in_list_[frame_id] = false;
+  size_--;
+}
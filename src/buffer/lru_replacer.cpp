@@ -1,12 +1,16 @@
 #include "buffer/lru_replacer.h"
 
-LRUReplacer::LRUReplacer(size_t num_pages) : size_(0), max_size_(num_pages){}
+#include "common/macros.h"
+
+LRUReplacer::LRUReplacer(size_t num_pages)
+    : prev_(num_pages + 1), next_(num_pages + 1), in_list_(num_pages, false), size_(0), max_size_(num_pages) {
+  frame_id_t sentinel = static_cast<frame_id_t>(max_size_);
+  prev_[sentinel] = sentinel;
+  next_[sentinel] = sentinel;
+}
 
 LRUReplacer::~LRUReplacer() = default;
 
-/**
- * TODO: Student Implement
- */
 bool LRUReplacer::Victim(frame_id_t *frame_id) {
   std::scoped_lock<std::mutex> lock(mutex_);
 
@@ -16,67 +20,64 @@ bool LRUReplacer::Victim(frame_id_t *frame_id) {
   }
 
   // 选择链表尾部的节点（最久未使用的页面）
-  *frame_id = free_list_.back();
-
-  // 从链表中移除
-  free_list_.pop_back();
-
-  // 删除节点
-  free_set_.erase(*frame_id);
-
-  // 减少当前可替换页面数
-  --size_;
-
+  *frame_id = prev_[max_size_];
+  Unlink(*frame_id);
   return true;
 }
 
-/**
- * TODO: Student Implement
- */
 void LRUReplacer::Pin(frame_id_t frame_id) {
   std::scoped_lock<std::mutex> lock(mutex_);
+  ASSERT(static_cast<size_t>(frame_id) < max_size_, "Invalid frame id.");
 
   // 如果页面没有在链表中，说明它没有被 Unpin 或已经被 Pin，不需要处理
-  if (free_set_.find(frame_id) == free_set_.end()) {
-    return;
-  }
-  else {
-    // 如果页面在链表中，将其移除
-    free_list_.remove(frame_id);
-    free_set_.erase(frame_id);
-
-  // 减少当前可替换页面数
-  --size_;
+  if (in_list_[frame_id]) {
+    Unlink(frame_id);
   }
-  
 }
 
-/**
- * TODO: Student Implement
- */
 void LRUReplacer::Unpin(frame_id_t frame_id) {
   std::scoped_lock<std::mutex> lock(mutex_);
+  ASSERT(static_cast<size_t>(frame_id) < max_size_, "Invalid frame id.");
 
   // 如果页面已经存在于链表中，不需要处理
-  if (free_set_.find(frame_id) != free_set_.end()) {
+  if (in_list_[frame_id]) {
     return;
   }
-  else if (size_ >= max_size_) {
-    return;
+
+  // 将页面添加到链表头部
+  frame_id_t sentinel = static_cast<frame_id_t>(max_size_);
+  prev_[frame_id] = sentinel;
+  next_[frame_id] = next_[sentinel];
+  prev_[next_[sentinel]] = frame_id;
+  next_[sentinel] = frame_id;
+  in_list_[frame_id] = true;
+  size_++;
+}
+
+void LRUReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  ASSERT(static_cast<size_t>(frame_id) < max_size_, "Invalid frame id.");
+  if (in_list_[frame_id]) {
+    Unlink(frame_id);
   }
-  else {
-    // 如果链表未满，将页面添加到链表头部
-    free_list_.push_front(frame_id);
-    free_set_.insert(frame_id);
-    size_++;
+}
+
+void LRUReplacer::GetHotFrames(vector<frame_id_t> *frames) {
+  std::scoped_lock<std::mutex> lock(mutex_);
+  frame_id_t sentinel = static_cast<frame_id_t>(max_size_);
+  for (frame_id_t frame_id = next_[sentinel]; frame_id != sentinel; frame_id = next_[frame_id]) {
+    frames->push_back(frame_id);
   }
 }
 
-/**
- * TODO: Student Implement
- */
 size_t LRUReplacer::Size() {
   std::scoped_lock<std::mutex> lock(mutex_);
   return size_;
 }
 
+void LRUReplacer::Unlink(frame_id_t frame_id) {
+  next_[prev_[frame_id]] = next_[frame_id];
+  prev_[next_[frame_id]] = prev_[frame_id];
+  in_list_[frame_id] = false;
+  size_--;
+}
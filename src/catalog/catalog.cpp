@@ -122,14 +122,15 @@ dberr_t CatalogManager::CreateTable(const string &name, TableSchema *schema, Txn
   auto meta_page = buffer_pool_manager_->NewPage(meta_pid);
   TablePage *heap_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(heap_pid));
   heap_page->Init(heap_pid, INVALID_PAGE_ID, log_manager_, txn);
+  page_id_t fsm_pid = FreeSpaceMap::Create(buffer_pool_manager_, heap_pid);
 
   table_id_t tid = next_table_id_;
   catalog_meta_->table_meta_pages_[tid] = meta_pid;
   next_table_id_ = catalog_meta_->GetNextTableId();
 
   auto deep_schema = TableSchema::DeepCopySchema(schema);
-  auto heap = TableHeap::Create(buffer_pool_manager_, heap_pid, deep_schema, log_manager_, lock_manager_);
-  auto meta = TableMetadata::Create(tid, name, heap_pid, deep_schema);
+  auto heap = TableHeap::Create(buffer_pool_manager_, heap_pid, deep_schema, log_manager_, lock_manager_, fsm_pid);
+  auto meta = TableMetadata::Create(tid, name, heap_pid, deep_schema, fsm_pid);
   meta->SerializeTo(meta_page->GetData());
 
   buffer_pool_manager_->UnpinPage(meta_pid, true);
@@ -335,6 +336,10 @@ dberr_t CatalogManager::DropIndex(const string &tbl_name, const string &idx_name
  */
 // 刷新 CatalogMeta 页面
 dberr_t CatalogManager::FlushCatalogMetaPage() const {
+  // nothing can have changed in a read-only database
+  if (buffer_pool_manager_->IsReadOnly()) {
+    return DB_SUCCESS;
+  }
   auto page = buffer_pool_manager_->FetchPage(CATALOG_META_PAGE_ID);
   catalog_meta_->SerializeTo(page->GetData());
   buffer_pool_manager_->UnpinPage(CATALOG_META_PAGE_ID, true);
@@ -358,15 +363,28 @@ dberr_t CatalogManager::LoadTable(const table_id_t tid, const page_id_t pid) {
   TableMetadata *meta;
   TableMetadata::DeserializeFrom(page->GetData(), meta);
 
+  // 旧格式的表没有空闲空间表，扫描页链表建一个并写回元数据
+  bool upgraded = false;
+  if (meta->GetFreeSpaceMapPageId() == INVALID_PAGE_ID && !buffer_pool_manager_->IsReadOnly() &&
+      meta->GetSerializedSize() <= PAGE_SIZE) {
+    page_id_t fsm_pid = FreeSpaceMap::Build(buffer_pool_manager_, meta->GetFirstPageId());
+    if (fsm_pid != INVALID_PAGE_ID) {
+      meta->SetFreeSpaceMapPageId(fsm_pid);
+      meta->SerializeTo(page->GetData());
+      upgraded = true;
+    }
+  }
+
   auto schema = TableSchema::DeepCopySchema(meta->GetSchema());
-  auto heap = TableHeap::Create(buffer_pool_manager_, meta->GetFirstPageId(), schema, log_manager_, lock_manager_);
+  auto heap = TableHeap::Create(buffer_pool_manager_, meta->GetFirstPageId(), schema, log_manager_, lock_manager_,
+                                meta->GetFreeSpaceMapPageId());
 
   auto info = TableInfo::Create();
   info->Init(meta, heap);
   table_names_[meta->GetTableName()] = tid;
   tables_[tid] = info;
 
-  buffer_pool_manager_->UnpinPage(pid, false);
+  buffer_pool_manager_->UnpinPage(pid, upgraded);
   return DB_SUCCESS;
 }
 
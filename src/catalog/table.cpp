@@ -7,7 +7,7 @@ uint32_t TableMetadata::SerializeTo(char *buf) const {
   uint32_t ofs = GetSerializedSize();
   ASSERT(ofs <= PAGE_SIZE, "Failed to serialize table info.");
   // 写入魔数标识
-  MACH_WRITE_UINT32(buf, TABLE_METADATA_MAGIC_NUM);
+  MACH_WRITE_UINT32(buf, TABLE_METADATA_MAGIC_NUM_V2);
   buf += 4;
   // 写入表 ID
   MACH_WRITE_TO(table_id_t, buf, table_id_);
@@ -20,6 +20,9 @@ uint32_t TableMetadata::SerializeTo(char *buf) const {
   // 写入表的根页 ID
   MACH_WRITE_TO(page_id_t, buf, root_page_id_);
   buf += 4;
+  // 写入空闲空间表的首页 ID
+  MACH_WRITE_TO(page_id_t, buf, free_space_map_page_id_);
+  buf += 4;
   // 写入表模式（Schema）
   buf += schema_->SerializeTo(buf);
   ASSERT(buf - p == ofs, "Unexpected serialize size.");
@@ -31,7 +34,7 @@ uint32_t TableMetadata::SerializeTo(char *buf) const {
  */
 // 计算序列化后表元数据的大小
 uint32_t TableMetadata::GetSerializedSize() const {
-  return 4 * 4 + table_name_.length() + schema_->GetSerializedSize();
+  return 5 * 4 + table_name_.length() + schema_->GetSerializedSize();
 }
 
 /**
@@ -45,7 +48,8 @@ uint32_t TableMetadata::DeserializeFrom(char *buf, TableMetadata *&table_meta) {
   // 读取魔数标识
   uint32_t magic_num = MACH_READ_UINT32(buf);
   buf += 4;
-  ASSERT(magic_num == TABLE_METADATA_MAGIC_NUM, "Failed to deserialize table info.");
+  ASSERT(magic_num == TABLE_METADATA_MAGIC_NUM || magic_num == TABLE_METADATA_MAGIC_NUM_V2,
+         "Failed to deserialize table info.");
   // 读取表 ID
   table_id_t table_id = MACH_READ_FROM(table_id_t, buf);
   buf += 4;
@@ -57,11 +61,17 @@ uint32_t TableMetadata::DeserializeFrom(char *buf, TableMetadata *&table_meta) {
   // 读取表的根页 ID
   page_id_t root_page_id = MACH_READ_FROM(page_id_t, buf);
   buf += 4;
+  // 读取空闲空间表的首页 ID，旧格式没有
+  page_id_t free_space_map_page_id = INVALID_PAGE_ID;
+  if (magic_num == TABLE_METADATA_MAGIC_NUM_V2) {
+    free_space_map_page_id = MACH_READ_FROM(page_id_t, buf);
+    buf += 4;
+  }
   // 读取表的模式（Schema）
   TableSchema *schema = nullptr;
   buf += TableSchema::DeserializeFrom(buf, schema);
   // 为表元数据分配空间
-  table_meta = new TableMetadata(table_id, table_name, root_page_id, schema);
+  table_meta = new TableMetadata(table_id, table_name, root_page_id, schema, free_space_map_page_id);
   return buf - p;
 }
 
@@ -72,11 +82,16 @@ uint32_t TableMetadata::DeserializeFrom(char *buf, TableMetadata *&table_meta) {
  */
 // 创建一个新的 TableMetadata 实例
 TableMetadata *TableMetadata::Create(table_id_t table_id, std::string table_name, page_id_t root_page_id,
-                                     TableSchema *schema) {
+                                     TableSchema *schema, page_id_t free_space_map_page_id) {
   // 为表元数据分配空间
-  return new TableMetadata(table_id, table_name, root_page_id, schema);
+  return new TableMetadata(table_id, table_name, root_page_id, schema, free_space_map_page_id);
 }
 
 // 表元数据构造函数，初始化表的元数据信息
-TableMetadata::TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema)
-    : table_id_(table_id), table_name_(table_name), root_page_id_(root_page_id), schema_(schema) {}
+TableMetadata::TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema,
+                             page_id_t free_space_map_page_id)
+    : table_id_(table_id),
+      table_name_(table_name),
+      root_page_id_(root_page_id),
+      schema_(schema),
+      free_space_map_page_id_(free_space_map_page_id) {}
@@ -3,16 +3,31 @@
 //
 #include "common/instance.h"
 
-DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size)
+#include <filesystem>
+
+DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size,
+                                 uint32_t buffer_pool_instances, ReplacerType replacer_type, DurabilityMode durability,
+                                 bool compress, bool read_only)
     : db_file_name_(std::move(db_name)), init_(init) {
+  if (read_only && init) {
+    throw logic_error("A database opened read-only cannot be initialized.");
+  }
   // Init database file if needed
   db_file_name_ = "./databases/" + db_file_name_;
   if (init_) {
     remove(db_file_name_.c_str());
+    remove(GetHotPagesFileName(db_file_name_).c_str());
+    remove(DiskManager::GetSlotFileName(db_file_name_).c_str());
   }
   // Initialize components
-  disk_mgr_ = new DiskManager(db_file_name_);
-  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
+  disk_mgr_ = new DiskManager(db_file_name_, DEFAULT_DIRECT_IO, durability,
+                              std::chrono::milliseconds(DEFAULT_SYNC_INTERVAL_MS), compress, read_only);
+  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_, buffer_pool_instances, replacer_type,
+                               DEFAULT_USE_HUGE_PAGES, buffer_pool_size * BUFFER_POOL_MAX_GROWTH);
+  if (!read_only) {
+    bpm_->EnableBackgroundFlush(DEFAULT_BG_FLUSH_CLEAN_FRACTION,
+                                std::chrono::milliseconds(DEFAULT_BG_FLUSH_INTERVAL_MS));
+  }
 
   // Allocate static page for db storage engine
   if (init) {
@@ -39,6 +54,10 @@ DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer
     ASSERT(!bpm_->IsPageFree(INDEX_ROOTS_PAGE_ID), "Invalid header page.");
   }
   catalog_mgr_ = new CatalogManager(bpm_, nullptr, nullptr, init);
+  // a mapped database is cached by the OS, and the hot page file could not be kept up to date anyway
+  if (!read_only) {
+    bpm_->EnableWarmStart(GetHotPagesFileName(db_file_name_));
+  }
 }
 
 DBStorageEngine::~DBStorageEngine() {
@@ -47,6 +66,18 @@ DBStorageEngine::~DBStorageEngine() {
   delete disk_mgr_;
 }
 
+std::string DBStorageEngine::GetHotPagesFileName(const std::string &db_file_name) {
+  std::filesystem::path path(db_file_name);
+  path.replace_filename("." + path.filename().string() + ".hot");
+  return path.string();
+}
+
+void DBStorageEngine::Commit() {
+  if (disk_mgr_->GetDurability() == DurabilityMode::STRICT) {
+    bpm_->FlushAllPages();
+  }
+}
+
 std::unique_ptr<ExecuteContext> DBStorageEngine::MakeExecuteContext(Txn *txn) {
   return std::make_unique<ExecuteContext>(txn, catalog_mgr_, bpm_);
 }
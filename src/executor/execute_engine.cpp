@@ -4,7 +4,12 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
 
 #include "common/result_writer.h"
 #include "executor/executors/delete_executor.h"
@@ -102,10 +107,30 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
   if (ast == nullptr) {
     return DB_FAILED;
   }
+  std::lock_guard<std::recursive_mutex> statement_guard(statement_latch_);
   auto start_time = std::chrono::system_clock::now();
   unique_ptr<ExecuteContext> context(nullptr);
   if(!current_db_.empty())
     context = dbs_[current_db_]->MakeExecuteContext(nullptr);
+  // the pages of a read-only database are mapped read-only, statements that change them must not get to run
+  if (!current_db_.empty() && dbs_[current_db_]->IsReadOnly()) {
+    switch (ast->type_) {
+      case kNodeCreateTable:
+      case kNodeDropTable:
+      case kNodeCreateIndex:
+      case kNodeDropIndex:
+      case kNodeInsert:
+      case kNodeDelete:
+      case kNodeUpdate:
+      case kNodeSetDurability:
+      case kNodeVacuumFile:
+      case kNodeVacuumTable:
+      case kNodeLoadData:
+        return DB_READ_ONLY;
+      default:
+        break;
+    }
+  }
   switch (ast->type_) {
     case kNodeCreateDB:
       return ExecuteCreateDatabase(ast, context.get());
@@ -118,15 +143,15 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
     case kNodeShowTables:
       return ExecuteShowTables(ast, context.get());
     case kNodeCreateTable:
-      return ExecuteCreateTable(ast, context.get());
+      return EndStatement(ExecuteCreateTable(ast, context.get()));
     case kNodeDropTable:
-      return ExecuteDropTable(ast, context.get());
+      return EndStatement(ExecuteDropTable(ast, context.get()));
     case kNodeShowIndexes:
       return ExecuteShowIndexes(ast, context.get());
     case kNodeCreateIndex:
-      return ExecuteCreateIndex(ast, context.get());
+      return EndStatement(ExecuteCreateIndex(ast, context.get()));
     case kNodeDropIndex:
-      return ExecuteDropIndex(ast, context.get());
+      return EndStatement(ExecuteDropIndex(ast, context.get()));
     case kNodeTrxBegin:
       return ExecuteTrxBegin(ast, context.get());
     case kNodeTrxCommit:
@@ -137,6 +162,20 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
       return ExecuteExecfile(ast, context.get());
     case kNodeQuit:
       return ExecuteQuit(ast, context.get());
+    case kNodeShowBufferPoolStatus:
+      return ExecuteShowBufferPoolStatus(ast, context.get());
+    case kNodeSetBufferPoolSize:
+      return ExecuteSetBufferPoolSize(ast, context.get());
+    case kNodeSetDurability:
+      return ExecuteSetDurability(ast, context.get());
+    case kNodeVacuumFile:
+      return ExecuteVacuumFile(ast, context.get());
+    case kNodeVacuumTable:
+      return ExecuteVacuumTable(ast, context.get());
+    case kNodeSetAutoVacuum:
+      return ExecuteSetAutoVacuum(ast, context.get());
+    case kNodeLoadData:
+      return ExecuteLoadData(ast, context.get());
     default:
       break;
   }
@@ -146,7 +185,12 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
   try {
     planner.PlanQuery(ast);
     // Execute the query.
-    ExecutePlan(planner.plan_, &result_set, nullptr, context.get());
+    if (ExecutePlan(planner.plan_, &result_set, nullptr, context.get()) == DB_SUCCESS) {
+      auto type = planner.plan_->GetType();
+      if (type == PlanType::Insert || type == PlanType::Update || type == PlanType::Delete) {
+        EndStatement(DB_SUCCESS);
+      }
+    }
   } catch (const exception &ex) {
     std::cout << "Error Encountered in Planner: " << ex.what() << std::endl;
     return DB_FAILED;
@@ -228,6 +272,9 @@ void ExecuteEngine::ExecuteInformation(dberr_t result) {
     case DB_KEY_NOT_FOUND:
       cout << "Key not exists." << endl;
       break;
+    case DB_READ_ONLY:
+      cout << "Database is read-only." << endl;
+      break;
     case DB_QUIT:
       cout << "Bye." << endl;
       break;
@@ -275,6 +322,8 @@ dberr_t ExecuteEngine::ExecuteDropDatabase(pSyntaxNode ast, ExecuteContext *cont
   }
   db_file.close();
   remove(db_file_name.c_str());
+  remove(DBStorageEngine::GetHotPagesFileName(db_file_name).c_str());
+  remove(DiskManager::GetSlotFileName(db_file_name).c_str());
   std::ifstream check_db_file(db_file_name, std::ios::in);
   if (db_file.is_open()) {
     std::cout << "Failed to delete database " << db_name << "." << std::endl;
@@ -690,4 +739,525 @@ dberr_t ExecuteEngine::ExecuteQuit(pSyntaxNode ast, ExecuteContext *context) {
   LOG(INFO) << "ExecuteQuit" << std::endl;
 #endif
  return DB_QUIT;
-}
\ No newline at end of file
+}
+
+dberr_t ExecuteEngine::ExecuteShowBufferPoolStatus(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteShowBufferPoolStatus" << std::endl;
+#endif
+  if (current_db_.empty()) {
+    std::cout << "Please use a database." << std::endl;
+    return DB_FAILED;
+  }
+  BufferPoolManager *bpm = dbs_[current_db_]->bpm_;
+  BufferPoolCounters stats = bpm->GetStats();
+  auto ms = [](uint64_t ns) {
+    std::stringstream ss;
+    ss << fixed << setprecision(3) << static_cast<double>(ns) / 1e6;
+    return ss.str();
+  };
+  std::stringstream hit_rate;
+  hit_rate << fixed << setprecision(4) << stats.HitRate();
+  const char *durability_names[] = {"none", "periodic", "strict"};
+  WarmUpProgress warm_up = bpm->GetWarmUpProgress();
+  string warm_up_str = std::to_string(warm_up.loaded_) + "/" + std::to_string(warm_up.total_) +
+                       (warm_up.running_ ? " (running)" : "");
+  vector<pair<string, string>> rows = {
+      {"pool_size", std::to_string(bpm->GetPoolSize())},
+      {"max_pool_size", std::to_string(bpm->GetMaxPoolSize())},
+      {"instances", std::to_string(bpm->GetNumInstances())},
+      {"hits", std::to_string(stats.hits_)},
+      {"misses", std::to_string(stats.misses_)},
+      {"hit_rate", hit_rate.str()},
+      {"evictions", std::to_string(stats.evictions_)},
+      {"dirty_writebacks", std::to_string(stats.dirty_writebacks_)},
+      {"flushes", std::to_string(stats.flushes_)},
+      {"new_pages", std::to_string(stats.new_pages_)},
+      {"deleted_pages", std::to_string(stats.deleted_pages_)},
+      {"latch_waits", std::to_string(stats.latch_waits_)},
+      {"latch_wait_ms", ms(stats.latch_wait_ns_)},
+      {"disk_reads", std::to_string(stats.disk_reads_)},
+      {"disk_read_ms", ms(stats.disk_read_ns_)},
+      {"disk_writes", std::to_string(stats.disk_writes_)},
+      {"disk_write_ms", ms(stats.disk_write_ns_)},
+      {"warm_up_pages", warm_up_str},
+      {"durability", durability_names[static_cast<int>(dbs_[current_db_]->disk_mgr_->GetDurability())]},
+  };
+  vector<int> data_width = {int(strlen("Variable_name")), int(strlen("Value"))};
+  for (const auto &row : rows) {
+    data_width[0] = max(data_width[0], int(row.first.size()));
+    data_width[1] = max(data_width[1], int(row.second.size()));
+  }
+  std::stringstream ss;
+  ResultWriter writer(ss);
+  writer.Divider(data_width);
+  writer.BeginRow();
+  writer.WriteHeaderCell("Variable_name", data_width[0]);
+  writer.WriteHeaderCell("Value", data_width[1]);
+  writer.EndRow();
+  writer.Divider(data_width);
+  for (const auto &row : rows) {
+    writer.BeginRow();
+    writer.WriteCell(row.first, data_width[0]);
+    writer.WriteCell(row.second, data_width[1]);
+    writer.EndRow();
+  }
+  writer.Divider(data_width);
+  std::cout << writer.stream_.rdbuf();
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ExecuteSetBufferPoolSize(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteSetBufferPoolSize" << std::endl;
+#endif
+  if (current_db_.empty()) {
+    std::cout << "Please use a database." << std::endl;
+    return DB_FAILED;
+  }
+  string size_str = ast->child_->val_;
+  if (size_str.find_first_not_of("0123456789") != string::npos || size_str.size() > 12) {
+    std::cout << "Buffer pool size must be a positive number of frames." << std::endl;
+    return DB_FAILED;
+  }
+  BufferPoolManager *bpm = dbs_[current_db_]->bpm_;
+  size_t requested = std::stoull(size_str);
+  size_t resized = bpm->Resize(requested);
+  std::cout << "Buffer pool resized to " << resized << " frames." << std::endl;
+  if (resized > requested) {
+    std::cout << "The pool could not shrink further, the remaining frames are pinned or at the lower limit." << std::endl;
+  } else if (resized < requested) {
+    std::cout << "The pool is limited to " << bpm->GetMaxPoolSize() << " frames." << std::endl;
+  }
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ExecuteSetDurability(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteSetDurability" << std::endl;
+#endif
+  if (current_db_.empty()) {
+    std::cout << "Please use a database." << std::endl;
+    return DB_FAILED;
+  }
+  string mode_str = ast->child_->val_;
+  DurabilityMode mode;
+  if (mode_str == "none") {
+    mode = DurabilityMode::NONE;
+  } else if (mode_str == "periodic") {
+    mode = DurabilityMode::PERIODIC;
+  } else if (mode_str == "strict") {
+    mode = DurabilityMode::STRICT;
+  } else {
+    std::cout << "Durability must be none, periodic or strict." << std::endl;
+    return DB_FAILED;
+  }
+  DBStorageEngine *db = dbs_[current_db_];
+  db->disk_mgr_->SetDurability(mode);
+  // pages written under the previous mode are covered from now on as well
+  db->bpm_->FlushAllPages();
+  std::cout << "Durability of " << current_db_ << " set to " << mode_str << "." << std::endl;
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ExecuteVacuumFile(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteVacuumFile" << std::endl;
+#endif
+  if (current_db_.empty()) {
+    std::cout << "Please use a database." << std::endl;
+    return DB_FAILED;
+  }
+  DBStorageEngine *db = dbs_[current_db_];
+  DiskManager *disk_mgr = db->disk_mgr_;
+  db->bpm_->FlushAllPages();
+  size_t file_size = disk_mgr->GetDbFileSize();
+  size_t disk_usage = disk_mgr->GetDiskUsage();
+  if (!disk_mgr->Vacuum()) {
+    std::cout << "The file of a compressed database cannot be vacuumed." << std::endl;
+    return DB_FAILED;
+  }
+  std::cout << "File of " << current_db_ << " vacuumed: size " << file_size / 1024 << " KB -> "
+            << disk_mgr->GetDbFileSize() / 1024 << " KB, disk usage " << disk_usage / 1024 << " KB -> "
+            << disk_mgr->GetDiskUsage() / 1024 << " KB." << std::endl;
+  return EndStatement(DB_SUCCESS);
+}
+
+dberr_t ExecuteEngine::ExecuteVacuumTable(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteVacuumTable" << std::endl;
+#endif
+  if (current_db_.empty()) {
+    std::cout << "Please use a database." << std::endl;
+    return DB_FAILED;
+  }
+  string table_name = ast->child_->val_;
+  DBStorageEngine *db = dbs_[current_db_];
+  TableInfo *table_info = nullptr;
+  if (db->catalog_mgr_->GetTable(table_name, table_info) != DB_SUCCESS) {
+    return DB_TABLE_NOT_EXIST;
+  }
+  auto stats = VacuumTable(db, table_info);
+  std::cout << "Table " << table_name << " vacuumed: " << stats.applied_deletes << " deletes applied, "
+            << stats.moved_tuples << " rows moved, " << stats.freed_pages << " pages freed." << std::endl;
+  return EndStatement(DB_SUCCESS);
+}
+
+dberr_t ExecuteEngine::ExecuteSetAutoVacuum(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteSetAutoVacuum" << std::endl;
+#endif
+  string interval_str = ast->child_->val_;
+  if (interval_str.find_first_not_of("0123456789") != string::npos || interval_str.size() > 9) {
+    std::cout << "Autovacuum interval must be a number of seconds, 0 turns it off." << std::endl;
+    return DB_FAILED;
+  }
+  StopAutoVacuum();
+  autovacuum_interval_ = std::chrono::seconds(std::stoul(interval_str));
+  if (autovacuum_interval_.count() == 0) {
+    std::cout << "Autovacuum off." << std::endl;
+    return DB_SUCCESS;
+  }
+  autovacuum_stop_ = false;
+  autovacuum_thread_ = std::thread(&ExecuteEngine::RunAutoVacuum, this);
+  std::cout << "Autovacuum every " << autovacuum_interval_.count() << " seconds." << std::endl;
+  return DB_SUCCESS;
+}
+
+/**
+ * Read the next record of a CSV file. Fields are separated by commas, a field in double quotes may hold commas, line
+ * breaks and double quotes written twice. Blank lines are skipped.
+ * @param[out] quoted whether each field was in quotes, which tells an empty string from a missing value
+ * @param[in/out] line number of the last line read
+ * @return false at the end of the file, or with error set on a record that is not valid CSV
+ */
+static bool ReadCsvRecord(std::istream &in, std::vector<string> &fields, std::vector<bool> &quoted, uint32_t &line,
+                          string &error) {
+  string text;
+  do {
+    if (!std::getline(in, text)) {
+      return false;
+    }
+    line++;
+    if (!text.empty() && text.back() == '\r') {
+      text.pop_back();
+    }
+  } while (text.empty());
+  fields.assign(1, string());
+  quoted.assign(1, false);
+  bool in_quotes = false;
+  while (true) {
+    for (size_t i = 0; i < text.size(); i++) {
+      char ch = text[i];
+      if (in_quotes) {
+        if (ch != '"') {
+          fields.back().push_back(ch);
+        } else if (i + 1 < text.size() && text[i + 1] == '"') {
+          fields.back().push_back('"');
+          i++;
+        } else {
+          in_quotes = false;
+        }
+      } else if (ch == ',') {
+        fields.emplace_back();
+        quoted.push_back(false);
+      } else if (ch == '"' && fields.back().empty() && !quoted.back()) {
+        in_quotes = true;
+        quoted.back() = true;
+      } else if (quoted.back()) {
+        error = "unexpected character after a quoted field";
+        return false;
+      } else {
+        fields.back().push_back(ch);
+      }
+    }
+    if (!in_quotes) {
+      return true;
+    }
+    // 引号里的换行属于字段本身，接着读下一行
+    if (!std::getline(in, text)) {
+      error = "unterminated quoted field";
+      return false;
+    }
+    line++;
+    if (!text.empty() && text.back() == '\r') {
+      text.pop_back();
+    }
+    fields.back().push_back('\n');
+  }
+}
+
+/**
+ * Convert the text of a CSV field to a field of the column, an empty field without quotes is null.
+ * @return false with error set if the text does not fit the column
+ */
+static bool ParseCsvField(const Column *column, const string &text, bool quoted, std::vector<Field> &fields,
+                          string &error) {
+  if (text.empty() && !(quoted && column->GetType() == kTypeChar)) {
+    if (!column->IsNullable()) {
+      error = "column " + column->GetName() + " can not be null";
+      return false;
+    }
+    fields.emplace_back(column->GetType());
+    return true;
+  }
+  char *end = nullptr;
+  errno = 0;
+  switch (column->GetType()) {
+    case kTypeInt: {
+      long value = std::strtol(text.c_str(), &end, 10);
+      if (*end != '\0' || errno == ERANGE || value < INT32_MIN || value > INT32_MAX) {
+        error = "invalid int \"" + text + "\" for column " + column->GetName();
+        return false;
+      }
+      fields.emplace_back(kTypeInt, static_cast<int32_t>(value));
+      return true;
+    }
+    case kTypeFloat: {
+      float value = std::strtof(text.c_str(), &end);
+      if (*end != '\0' || errno == ERANGE) {
+        error = "invalid float \"" + text + "\" for column " + column->GetName();
+        return false;
+      }
+      fields.emplace_back(kTypeFloat, value);
+      return true;
+    }
+    case kTypeChar: {
+      if (text.size() > column->GetLength()) {
+        error = "value longer than " + std::to_string(column->GetLength()) + " for column " + column->GetName();
+        return false;
+      }
+      fields.emplace_back(kTypeChar, const_cast<char *>(text.data()), text.size(), true);
+      return true;
+    }
+    default:
+      error = "column " + column->GetName() + " has an invalid type";
+      return false;
+  }
+}
+
+/** Orders key rows field by field, nulls first. */
+static bool KeyLessThan(const Row &a, const Row &b) {
+  for (uint32_t i = 0; i < a.GetFieldCount(); i++) {
+    const Field *x = a.GetField(i);
+    const Field *y = b.GetField(i);
+    if (x->IsNull() || y->IsNull()) {
+      if (x->IsNull() != y->IsNull()) {
+        return x->IsNull();
+      }
+      continue;
+    }
+    if (x->CompareLessThan(*y) == CmpBool::kTrue) {
+      return true;
+    }
+    if (x->CompareGreaterThan(*y) == CmpBool::kTrue) {
+      return false;
+    }
+  }
+  return false;
+}
+
+/**
+ * Insert the keys of a batch of loaded rows into the indexes, each index in key order. A row whose key an index
+ * already holds is taken out of the heap and of the indexes it went into.
+ * @param keys keys[i][r] is the key of rids[r] in indexes[i]
+ * @return the number of rows taken out
+ */
+static uint32_t FlushLoadBatch(TableHeap *table_heap, const std::vector<IndexInfo *> &indexes,
+                               std::vector<std::vector<Row>> &keys, std::vector<RowId> &rids) {
+  std::vector<bool> rejected(rids.size(), false);
+  std::vector<std::vector<bool>> inserted(indexes.size(), std::vector<bool>(rids.size(), false));
+  std::vector<uint32_t> order(rids.size());
+  for (uint32_t i = 0; i < indexes.size(); i++) {
+    std::iota(order.begin(), order.end(), 0);
+    auto &index_keys = keys[i];
+    std::sort(order.begin(), order.end(),
+              [&](uint32_t a, uint32_t b) { return KeyLessThan(index_keys[a], index_keys[b]); });
+    for (uint32_t r : order) {
+      if (rejected[r]) {
+        continue;
+      }
+      if (indexes[i]->GetIndex()->InsertEntry(index_keys[r], rids[r], nullptr) == DB_SUCCESS) {
+        inserted[i][r] = true;
+      } else {
+        rejected[r] = true;
+      }
+    }
+  }
+  uint32_t rejected_count = 0;
+  for (uint32_t r = 0; r < rids.size(); r++) {
+    if (!rejected[r]) {
+      continue;
+    }
+    for (uint32_t i = 0; i < indexes.size(); i++) {
+      if (inserted[i][r]) {
+        indexes[i]->GetIndex()->RemoveEntry(keys[i][r], rids[r], nullptr);
+      }
+    }
+    table_heap->ApplyDelete(rids[r], nullptr);
+    rejected_count++;
+  }
+  for (auto &index_keys : keys) {
+    index_keys.clear();
+  }
+  rids.clear();
+  return rejected_count;
+}
+
+dberr_t ExecuteEngine::ExecuteLoadData(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteLoadData" << std::endl;
+#endif
+  if (current_db_.empty()) {
+    std::cout << "Please use a database." << std::endl;
+    return DB_FAILED;
+  }
+  string file_name = ast->child_->val_;
+  string table_name = ast->child_->next_->val_;
+  DBStorageEngine *db = dbs_[current_db_];
+  TableInfo *table_info = nullptr;
+  if (db->catalog_mgr_->GetTable(table_name, table_info) != DB_SUCCESS) {
+    return DB_TABLE_NOT_EXIST;
+  }
+  std::ifstream in(file_name);
+  if (!in.is_open()) {
+    std::cout << "File " << file_name << " not found!" << std::endl;
+    return DB_FAILED;
+  }
+  auto start_time = std::chrono::steady_clock::now();
+  Schema *schema = table_info->GetSchema();
+  TableHeap *table_heap = table_info->GetTableHeap();
+  std::vector<IndexInfo *> indexes;
+  db->catalog_mgr_->GetTableIndexes(table_name, indexes);
+
+  // 行直接追加到堆尾，索引项攒成一批，排好序再插
+  TableHeap::Appender appender(table_heap, nullptr);
+  std::vector<std::vector<Row>> keys(indexes.size());
+  std::vector<RowId> rids;
+  for (auto &index_keys : keys) {
+    index_keys.reserve(BULK_LOAD_INDEX_BATCH);
+  }
+  std::vector<string> texts;
+  std::vector<bool> quoted;
+  std::vector<Field> fields;
+  fields.reserve(schema->GetColumnCount());
+  uint32_t line = 0;
+  uint64_t appended = 0;
+  uint64_t rejected = 0;
+  string error;
+  while (ReadCsvRecord(in, texts, quoted, line, error)) {
+    if (texts.size() != schema->GetColumnCount()) {
+      error = std::to_string(texts.size()) + " fields, table " + table_name + " has " +
+              std::to_string(schema->GetColumnCount()) + " columns";
+      break;
+    }
+    fields.clear();
+    uint32_t parsed = 0;
+    while (parsed < texts.size() && ParseCsvField(schema->GetColumn(parsed), texts[parsed], quoted[parsed], fields,
+                                                  error)) {
+      parsed++;
+    }
+    if (parsed < texts.size()) {
+      break;
+    }
+    Row row(fields);
+    if (!appender.Append(row)) {
+      error = "row does not fit in a page";
+      break;
+    }
+    appended++;
+    if (indexes.empty()) {
+      continue;
+    }
+    rids.push_back(row.GetRowId());
+    for (uint32_t i = 0; i < indexes.size(); i++) {
+      keys[i].emplace_back();
+      row.GetKeyFromRow(schema, indexes[i]->GetIndexKeySchema(), keys[i].back());
+    }
+    if (rids.size() >= BULK_LOAD_INDEX_BATCH) {
+      rejected += FlushLoadBatch(table_heap, indexes, keys, rids);
+    }
+  }
+  appender.Finish();
+  rejected += FlushLoadBatch(table_heap, indexes, keys, rids);
+
+  // 出错前载入的行留在表中，索引也已补齐
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  uint64_t loaded = appended - rejected;
+  std::cout << loaded << " rows loaded into " << table_name << " (" << rejected << " skipped for duplicate keys) in "
+            << std::fixed << std::setprecision(4) << seconds << " sec, " << std::setprecision(0)
+            << (seconds > 0 ? loaded / seconds : 0) << " rows/sec." << std::defaultfloat << std::endl;
+  EndStatement(DB_SUCCESS);
+  if (!error.empty()) {
+    std::cout << "Load of " << file_name << " stopped at line " << line << ": " << error << "." << std::endl;
+    return DB_FAILED;
+  }
+  return DB_SUCCESS;
+}
+
+TableHeap::VacuumStats ExecuteEngine::VacuumTable(DBStorageEngine *db, TableInfo *table_info) {
+  std::vector<IndexInfo *> indexes;
+  db->catalog_mgr_->GetTableIndexes(table_info->GetTableName(), indexes);
+  Schema *schema = table_info->GetSchema();
+  // 搬动的行换了 row id，索引项跟着改
+  auto relocate = [&](Row &row, const RowId &old_rid) {
+    Row key_row;
+    for (auto index_info : indexes) {
+      row.GetKeyFromRow(schema, index_info->GetIndexKeySchema(), key_row);
+      index_info->GetIndex()->RemoveEntry(key_row, old_rid, nullptr);
+      index_info->GetIndex()->InsertEntry(key_row, row.GetRowId(), nullptr);
+    }
+  };
+  return table_info->GetTableHeap()->Vacuum(VACUUM_MERGE_FILL, relocate, nullptr);
+}
+
+void ExecuteEngine::RunAutoVacuum() {
+  std::unique_lock<std::mutex> lock(autovacuum_latch_);
+  while (!autovacuum_cv_.wait_for(lock, autovacuum_interval_, [this] { return autovacuum_stop_; })) {
+    // a statement is running, the next round will come back to it
+    std::unique_lock<std::recursive_mutex> statement_guard(statement_latch_, std::try_to_lock);
+    if (!statement_guard.owns_lock()) {
+      continue;
+    }
+    for (auto &it : dbs_) {
+      DBStorageEngine *db = it.second;
+      if (db->IsReadOnly()) {
+        continue;
+      }
+      std::vector<TableInfo *> tables;
+      db->catalog_mgr_->GetTables(tables);
+      bool vacuumed = false;
+      for (auto table_info : tables) {
+        if (table_info->GetTableHeap()->GetDeadTupleCount() >= AUTOVACUUM_MIN_DEAD_TUPLES) {
+          auto stats = VacuumTable(db, table_info);
+          LOG(INFO) << "Autovacuum of " << it.first << "." << table_info->GetTableName() << ": "
+                    << stats.applied_deletes << " deletes applied, " << stats.moved_tuples << " rows moved, "
+                    << stats.freed_pages << " pages freed";
+          vacuumed = true;
+        }
+      }
+      if (vacuumed) {
+        db->Commit();
+      }
+    }
+  }
+}
+
+void ExecuteEngine::StopAutoVacuum() {
+  if (!autovacuum_thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(autovacuum_latch_);
+    autovacuum_stop_ = true;
+  }
+  autovacuum_cv_.notify_all();
+  autovacuum_thread_.join();
+}
+
+dberr_t ExecuteEngine::EndStatement(dberr_t result) {
+  if (result == DB_SUCCESS && !current_db_.empty()) {
+    dbs_[current_db_]->Commit();
+  }
+  return result;
+}
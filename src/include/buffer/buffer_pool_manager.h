@@ -1,20 +1,62 @@
 #ifndef MINISQL_BUFFER_POOL_MANAGER_H
 #define MINISQL_BUFFER_POOL_MANAGER_H
 
-#include <list>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
-#include <unordered_map>
+#include <string>
+#include <thread>
+#include <vector>
 
-#include "buffer/lru_replacer.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "page/disk_file_meta_page.h"
 #include "page/page.h"
 #include "storage/disk_manager.h"
 
 using namespace std;
 
+/** Progress of a buffer pool warm-up, see BufferPoolManager::LoadHotPages. */
+struct WarmUpProgress {
+  size_t loaded_{0};  // pages read so far
+  size_t total_{0};   // pages to read
+  bool running_{false};
+};
+
+/**
+ * BufferPoolManager splits its frames into num_instances independent BufferPoolManagerInstance partitions and routes
+ * every page to the instance page_id % num_instances. Each partition has its own latch, so threads working on pages
+ * of different partitions never serialize on a single global latch.
+ *
+ * An optional background writer flushes dirty, unpinned pages ahead of eviction, so that foreground fetches mostly
+ * find clean victims and do not pay for the write themselves.
+ *
+ * Prefetch requests are queued to an I/O thread that reads the pages in without pinning them, which lets scans read
+ * ahead along their page chain instead of waiting for every page miss.
+ *
+ * The prefetcher, the warm-up loader and the background writer each keep a batch of transfers in flight through their
+ * own PageIOQueue instead of waiting for every page. Page chains are still read one page at a time, the next page id
+ * is only known once a page is in.
+ *
+ * The pool can be resized online between num_instances and max_pool_size frames, see Resize.
+ *
+ * For a warm start, the ids of the resident pages can be saved to a small sidecar file, hottest first, and read back
+ * in by a background loader when the database is opened again.
+ *
+ * When the disk manager maps a read-only db file (see DiskManager::IsMapped), the frames are bypassed: FetchPage
+ * returns a view, a Page whose data is the page in the mapping, so nothing is copied and the OS page cache is the
+ * only cache. Views are created on first fetch and live as long as the pool. Prefetches become MADV_WILLNEED hints.
+ * Pages cannot be created, deleted or unpinned dirty in a read-only database.
+ */
 class BufferPoolManager {
  public:
-  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager);
+  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
+                             size_t num_instances = DEFAULT_BUFFER_POOL_INSTANCES,
+                             ReplacerType replacer_type = DEFAULT_REPLACER_TYPE,
+                             bool use_huge_pages = DEFAULT_USE_HUGE_PAGES, size_t max_pool_size = 0);
 
   ~BufferPoolManager();
 
@@ -24,35 +66,211 @@ class BufferPoolManager {
 
   bool FlushPage(page_id_t page_id);
 
-  Page *NewPage(page_id_t &page_id);
+  /**
+   * Write back every dirty page: the pages are sorted by page id, runs of adjacent pages are written with vectored
+   * writes, and the disk manager checkpoints once at the end, which syncs the file unless the durability mode is NONE.
+   * Clean pages are not written.
+   * @return the number of pages written
+   */
+  size_t FlushAllPages();
+
+  /**
+   * @param segment the table heap or index the page belongs to, see segment_id_t
+   */
+  Page *NewPage(page_id_t &page_id, segment_id_t segment = INVALID_SEGMENT_ID);
 
   bool DeletePage(page_id_t page_id);
 
   bool IsPageFree(page_id_t page_id);
 
+  /** Give back the pages reserved on disk for a segment that is being dropped. */
+  void ReleaseSegment(segment_id_t segment);
+
   bool CheckAllUnpinned();
 
+  /**
+   * Start (or reconfigure) the background writer. Every interval it makes sure that at least clean_fraction of the
+   * frames of each instance are free or clean and unpinned.
+   */
+  void EnableBackgroundFlush(double clean_fraction, std::chrono::milliseconds interval);
+
+  /** Stop the background writer and wait for it to exit. */
+  void DisableBackgroundFlush();
+
+  /**
+   * One round of the background writer: write back dirty, unpinned pages of the instances that are short of clean
+   * frames, in page id order.
+   * @param io queue to write through, a new one if nullptr
+   * @return the number of pages written
+   */
+  size_t FlushAhead(PageIOQueue *io = nullptr);
+
+  /** Asynchronously bring page_id into the pool. Prefetching is a hint, requests are dropped when the queue is full. */
+  void PrefetchPage(page_id_t page_id);
+
+  /** Asynchronously bring the allocated pages among [first_page_id, first_page_id + count) into the pool. */
+  void PrefetchRange(page_id_t first_page_id, size_t count);
+
+  /**
+   * Asynchronously bring up to count pages of a page chain into the pool, starting at page_id and following the links
+   * read by next_page.
+   */
+  void PrefetchChain(page_id_t page_id, size_t count, NextPageIdReader next_page);
+
+  /**
+   * Save the ids of the resident pages to path, from the hottest to the coldest. The file is replaced atomically.
+   * @return false if the file could not be written
+   */
+  bool SaveHotPages(const std::string &path);
+
+  /**
+   * Start a background loader that reads the hottest pages listed in path, as many as fit into the pool, in page id
+   * order. Pages are loaded like prefetched ones, without counting as accesses. Nothing happens if path does not exist.
+   * @return false if path does not exist or is not a hot page file
+   */
+  bool LoadHotPages(const std::string &path);
+
+  /** Keep the hot page set in path: load it now, save it periodically from the background writer and at shutdown. */
+  void EnableWarmStart(const std::string &path);
+
+  /** Block until the background loader is done. */
+  void WaitForWarmUp();
+
+  WarmUpProgress GetWarmUpProgress() const;
+
+  /** Block until every queued prefetch has been served. Used by tests and benchmarks */
+  void WaitForPrefetches();
+
+  /** Prefetch the read-ahead window of a page chain, starting at page_id. Used by the table and index iterators. */
+  inline void ReadAhead(page_id_t page_id, NextPageIdReader next_page) {
+    if (page_id != INVALID_PAGE_ID && read_ahead_window_ > 0) {
+      PrefetchChain(page_id, read_ahead_window_, next_page);
+    }
+  }
+
+  /** @param window number of pages scans read ahead, 0 disables read-ahead */
+  inline void SetReadAheadWindow(size_t window) { read_ahead_window_ = window; }
+
+  inline size_t GetReadAheadWindow() const { return read_ahead_window_; }
+
+  /** @return the counters of all instances added up */
+  BufferPoolCounters GetStats() const;
+
+  void ResetStats();
+
+  /** @return true if page_id is in the pool. Only used for debug */
+  bool IsResident(page_id_t page_id);
+
+  /**
+   * Grow or shrink the pool while it is in use. Shrinking evicts unpinned pages (writing dirty ones back) and gives the
+   * memory of their frames back; if too many pages are pinned the pool stays larger than requested.
+   * @param pool_size the requested total number of frames, clamped to [number of instances, max pool size]
+   * @return the total number of frames afterwards
+   */
+  size_t Resize(size_t pool_size);
+
+  /** @return the total number of frames over all instances */
+  inline size_t GetPoolSize() const { return pool_size_; }
+
+  /** @return the largest size Resize can grow the pool to */
+  inline size_t GetMaxPoolSize() const { return max_pool_size_; }
+
+  inline size_t GetNumInstances() const { return instances_.size(); }
+
+  /** @return true if the database is opened read-only */
+  inline bool IsReadOnly() const { return disk_manager_->IsReadOnly(); }
+
  private:
   /**
    * Allocate new page (operations like create index/table) For now just keep an increasing counter
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(segment_id_t segment);
 
   /**
    * Deallocate page (operations like drop index/table) Need bitmap in header page for tracking pages
    */
   void DeallocatePage(page_id_t page_id);
 
-  bool TryToFindFreePage(frame_id_t *frame_id);
+  /** Body of the background writer thread. */
+  void RunBackgroundFlush();
+
+  /** Body of the warm-up thread, page_ids are sorted. */
+  void RunWarmUp(vector<page_id_t> page_ids);
+
+  static constexpr uint32_t HOT_PAGES_MAGIC = 0x4d535750;  // "PWSM"
+  static constexpr uint32_t HOT_PAGES_VERSION = 1;
+
+  /** A queued prefetch: count pages starting at page_id, chained by next_page or consecutive if it is nullptr. */
+  struct PrefetchRequest {
+    page_id_t page_id;
+    size_t count;
+    NextPageIdReader next_page;
+  };
+
+  void EnqueuePrefetch(const PrefetchRequest &request);
+
+  /** @return the view of page_id over the mapped db file, pinned, nullptr if the page is past the end of the file */
+  Page *FetchView(page_id_t page_id);
+
+  /** Body of the prefetch I/O thread. */
+  void RunPrefetch();
+
+  /**
+   * Run up to count page transfers through io, with at most its depth of them in flight. start(i, request, stop) sets
+   * up the i-th transfer, keeping its page in request->user_data_, and returns false to skip it; setting *stop ends the
+   * run after the transfers in flight. finish(request, ns) is called with each completed transfer and its latency.
+   */
+  void RunTransfers(PageIOQueue *io, size_t count,
+                    const std::function<bool(size_t, PageIORequest *, bool *)> &start,
+                    const std::function<void(PageIORequest *, uint64_t)> &finish);
+
+  /**
+   * Read pages in through io like prefetched ones, without pinning them for the caller. Resident pages are skipped.
+   * @return false if an instance had every frame pinned, the pages after it are not read
+   */
+  bool LoadPages(const vector<page_id_t> &page_ids, PageIOQueue *io);
+
+  /** @return the part of total frames that instance index out of num_instances gets */
+  static inline size_t InstanceShare(size_t total, size_t index, size_t num_instances) {
+    return total / num_instances + (index < total % num_instances ? 1 : 0);
+  }
+
+  inline BufferPoolManagerInstance *GetInstance(page_id_t page_id) {
+    return instances_[static_cast<uint32_t>(page_id) % instances_.size()];
+  }
 
  private:
-  size_t pool_size_;                                 // number of pages in buffer pool
-  Page *pages_;                                      // array of pages
-  DiskManager *disk_manager_;                        // pointer to the disk manager.
-  unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
-  Replacer *replacer_;                               // to find an unpinned page for replacement
-  list<frame_id_t> free_list_;                       // to find a free page for replacement
-  recursive_mutex latch_;                            // to protect shared data structure
+  std::atomic<size_t> pool_size_;                 // number of pages in buffer pool
+  size_t max_pool_size_;                          // limit of Resize, frames are reserved up to it
+  std::mutex resize_latch_;                       // serializes Resize
+  BufferPoolStats stats_;                         // counters of pool wide work, FlushAllPages
+  DiskManager *disk_manager_;                     // pointer to the disk manager.
+  vector<BufferPoolManagerInstance *> instances_;  // partitions, indexed by page_id % num_instances
+  std::unique_ptr<std::atomic<Page *>[]> views_;  // page views of a mapped db file by page id, nullptr if not mapped
+  size_t num_views_{0};
+
+  std::thread flush_thread_;                        // background writer, joinable while enabled
+  std::mutex flush_latch_;                          // protects the fields below
+  std::condition_variable flush_cv_;                // wakes the writer up early on a new setting or stop
+  bool flush_stop_{false};
+  double clean_fraction_{0};
+  std::chrono::milliseconds flush_interval_{DEFAULT_BG_FLUSH_INTERVAL_MS};
+  std::string hot_pages_file_;                      // warm start sidecar file, empty if disabled
+
+  std::thread warm_up_thread_;                      // background loader of LoadHotPages
+  std::atomic<bool> warm_up_stop_{false};
+  std::atomic<bool> warm_up_running_{false};
+  std::atomic<size_t> warm_up_loaded_{0};
+  std::atomic<size_t> warm_up_total_{0};
+
+  std::atomic<size_t> read_ahead_window_{DEFAULT_READ_AHEAD_WINDOW};
+  std::thread prefetch_thread_;                     // serves prefetch_queue_
+  std::mutex prefetch_latch_;                       // protects the fields below
+  std::condition_variable prefetch_cv_;             // signalled on new requests and on stop
+  std::condition_variable prefetch_idle_cv_;        // signalled when the queue runs empty
+  std::deque<PrefetchRequest> prefetch_queue_;
+  bool prefetch_busy_{false};                       // a request is being served
+  bool prefetch_stop_{false};
 };
 
 #endif  // MINISQL_BUFFER_POOL_MANAGER_H
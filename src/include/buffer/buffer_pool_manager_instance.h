@@ -0,0 +1,212 @@
+#ifndef MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+#define MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/frame_arena.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
+#include "page/page.h"
+#include "storage/disk_manager.h"
+
+using namespace std;
+
+/** Reads the id of the next page of a page chain (table heap, B+ tree leaves) from the raw page data. */
+using NextPageIdReader = page_id_t (*)(const char *page_data);
+
+/**
+ * BufferPoolManagerInstance is one partition of the buffer pool. It owns its own frames, page table, free list,
+ * replacer and latch, so that instances never contend with each other. Page id allocation and de-allocation are done
+ * by the owning BufferPoolManager, an instance only maps already allocated pages onto its frames.
+ *
+ * Hits on resident pages (FetchPage/UnpinPage) do not take the latch: the page table is read lock-free and the frame
+ * is pinned with an atomic increment, then validated. The latch only serializes changes of the frame <-> page mapping.
+ * Before remapping a frame the instance swaps its pin count from 0 to FRAME_LOCKED, so an optimistic pin either lands
+ * first (and the frame is not evicted) or sees a negative count and retries on the latched path.
+ *
+ * Disk transfers happen outside the latch. A frame being read in stays mapped in the LOADING state and a victim being
+ * written back stays mapped in the WRITING_BACK state; threads that need such a frame wait on io_cv_ instead of
+ * issuing their own I/O.
+ *
+ * Frames are allocated up to max_pool_size up front, but only pool_size of them are in use. The frames above the
+ * current size are retired: they are locked for good, and their memory is handed back to the kernel. Resize moves
+ * frames between the retired list and the free list, evicting the pages of the frames it retires.
+ */
+class BufferPoolManagerInstance {
+ public:
+  /**
+   * @param max_pool_size upper limit of Resize, 0 for pool_size
+   */
+  explicit BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                                     ReplacerType replacer_type = DEFAULT_REPLACER_TYPE,
+                                     bool use_huge_pages = DEFAULT_USE_HUGE_PAGES, size_t max_pool_size = 0);
+
+  ~BufferPoolManagerInstance();
+
+  Page *FetchPage(page_id_t page_id);
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty);
+
+  bool FlushPage(page_id_t page_id);
+
+  /**
+   * Bring a freshly allocated page into the pool, zeroed and pinned.
+   * @return nullptr if all frames of this instance are pinned
+   */
+  Page *NewPage(page_id_t page_id);
+
+  /**
+   * Drop a page from the pool without writing it back.
+   * @return false if the page is resident and still pinned
+   */
+  bool DeletePage(page_id_t page_id);
+
+  /**
+   * Collect the dirty, unpinned pages to write back ahead of eviction. Nothing is collected while at least min_clean
+   * frames are free or clean and unpinned, otherwise at most the missing number of pages.
+   */
+  void CollectFlushCandidates(size_t min_clean, vector<page_id_t> *page_ids);
+
+  /** Append the ids of the resident pages, pinned pages first and then the others from the hottest to the coldest. */
+  void GetHotPages(vector<page_id_t> *page_ids);
+
+  /**
+   * Pin every dirty resident page and mark it clean, so that the caller can write them in one batch. Pages that are
+   * being written back by an evicting thread are skipped. The caller unpins the pages once they are written.
+   */
+  void PinDirtyPages(vector<pair<page_id_t, Page *>> *pages);
+
+  /**
+   * Bring a page into the pool without pinning it for the caller and without counting it as an access, so that
+   * replacers still treat read-ahead pages as cold.
+   * @param next_page if not nullptr, used to read the id of the page that follows page_id into *next_page_id
+   * @return false if every frame of this instance is pinned
+   */
+  bool PrefetchPage(page_id_t page_id, NextPageIdReader next_page, page_id_t *next_page_id);
+
+  /**
+   * First half of a page read done by the caller, e.g. through a PageIOQueue: map page_id to a frame in the LOADING
+   * state and pin it, without counting an access. Threads fetching the page meanwhile wait for FinishLoad.
+   * @param full set to true if nullptr is returned because every frame is pinned
+   * @return the frame to read the page into, nullptr if the page is resident already or no frame is available
+   */
+  Page *StartLoad(page_id_t page_id, bool *full);
+
+  /** Second half of a page read: mark the page READY and drop the pin of StartLoad. */
+  void FinishLoad(Page *page, uint64_t read_ns);
+
+  /**
+   * First half of a page write done by the caller: pin the resident page and mark it clean, as FlushPage does.
+   * @return nullptr if the page is not resident
+   */
+  Page *StartFlush(page_id_t page_id);
+
+  /** Second half of a page write: account for it and drop the pin of StartFlush. */
+  void FinishFlush(Page *page, uint64_t write_ns);
+
+  /** @return true if page_id is mapped to a frame. Only used for debug */
+  bool IsResident(page_id_t page_id);
+
+  bool CheckAllUnpinned();
+
+  /**
+   * Grow or shrink the number of frames in use while the instance is in use. Growing hands retired frames to the free
+   * list. Shrinking retires free frames first and then evicts unpinned pages, writing dirty ones back; pinned frames
+   * are never taken, so a shrink stops early when not enough frames can be evicted.
+   * @param pool_size the requested number of frames, clamped to [1, max_pool_size]
+   * @return the number of frames in use afterwards
+   */
+  size_t Resize(size_t pool_size);
+
+  inline size_t GetPoolSize() const { return pool_size_.load(std::memory_order_relaxed); }
+
+  inline size_t GetMaxPoolSize() const { return max_pool_size_; }
+
+  inline BufferPoolCounters GetStats() const { return stats_.Snapshot(); }
+
+  inline void ResetStats() { stats_.Reset(); }
+
+ private:
+  /** Pin count of a frame whose mapping is being changed under the latch. */
+  static constexpr int FRAME_LOCKED = INT_MIN / 2;
+
+  /**
+   * Pin page_id without taking the latch.
+   * @return nullptr if the page is not resident or its frame is being remapped
+   */
+  Page *TryPinResident(page_id_t page_id);
+
+  /**
+   * Pin page_id under the latch, reading it from disk if it is not resident.
+   * @param record_access whether the replacer is told about the access
+   * @return nullptr if every frame is pinned
+   */
+  Page *PinPage(page_id_t page_id, bool record_access);
+
+  /** Drop one pin of a frame, an unpinned frame becomes a candidate for replacement. */
+  void ReleaseFrame(frame_id_t frame_id);
+
+  /** Swap the pin count of an unpinned frame from 0 to FRAME_LOCKED. */
+  bool LockFrame(Page *page);
+
+  /** Turn a locked frame into a frame pinned once by the caller. */
+  void UnlockFramePinned(Page *page);
+
+  /**
+   * Find a frame for a new mapping, from the free list first and the replacer otherwise.
+   * @return true with *frame_id locked, false if every frame is pinned
+   */
+  bool TryToFindFreePage(frame_id_t *frame_id);
+
+  /**
+   * Write back the dirty page held by a locked victim frame. The latch is released during the write, the frame keeps
+   * its old mapping and is still locked when this returns.
+   */
+  void WriteBackVictim(std::unique_lock<std::recursive_mutex> &lock, frame_id_t frame_id);
+
+  /**
+   * Map a locked frame to page_id in the LOADING state, replacing its old page, and pin it once for the caller. Must be
+   * called under the latch.
+   */
+  void MapLoadingFrame(frame_id_t frame_id, page_id_t page_id);
+
+  /** Take a locked, clean frame out of use. Must be called under the latch. */
+  void RetireFrame(frame_id_t frame_id);
+
+  /** Lock the latch held by lock, accounting the time spent waiting if it is contended. */
+  void LockLatch(std::unique_lock<std::recursive_mutex> &lock);
+
+  inline std::unique_lock<std::recursive_mutex> AcquireLatch() {
+    std::unique_lock<std::recursive_mutex> lock(latch_, std::defer_lock);
+    LockLatch(lock);
+    return lock;
+  }
+
+  /** Timed and counted disk transfers. */
+  void ReadFromDisk(page_id_t page_id, char *page_data);
+
+  void WriteToDisk(page_id_t page_id, const char *page_data);
+
+ private:
+  std::atomic<size_t> pool_size_;                    // number of frames in use
+  size_t max_pool_size_;                             // number of frames allocated
+  FrameArena frames_;                                // page aligned data of all frames
+  Page *pages_;                                      // array of frame metadata, pointing into frames_
+  DiskManager *disk_manager_;                        // pointer to the disk manager.
+  PageTable page_table_;                             // to keep track of pages
+  Replacer *replacer_;                               // to find an unpinned page for replacement
+  list<frame_id_t> free_list_;                       // to find a free page for replacement
+  vector<frame_id_t> retired_list_;                  // frames out of use, locked with FRAME_LOCKED
+  recursive_mutex latch_;                            // to protect shared data structure
+  condition_variable_any io_cv_;                     // signalled whenever a frame leaves LOADING or WRITING_BACK
+  BufferPoolStats stats_;                            // always-on counters
+};
+
+#endif  // MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
@@ -0,0 +1,133 @@
+#ifndef MINISQL_BUFFER_POOL_STATS_H
+#define MINISQL_BUFFER_POOL_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#include "common/macros.h"
+
+/**
+ * A point in time copy of the buffer pool counters. Times are in nanoseconds.
+ */
+struct BufferPoolCounters {
+  uint64_t hits_{0};              // fetches served by a resident page
+  uint64_t misses_{0};            // fetches that had to read the page from disk
+  uint64_t evictions_{0};         // resident pages dropped to make room for another one
+  uint64_t dirty_writebacks_{0};  // evicted pages written back by the evicting thread
+  uint64_t flushes_{0};           // pages written by FlushPage, including the background writer
+  uint64_t new_pages_{0};         // successful NewPage calls
+  uint64_t deleted_pages_{0};     // successful DeletePage calls
+  uint64_t latch_waits_{0};       // latch acquisitions that found the latch taken
+  uint64_t latch_wait_ns_{0};     // time spent waiting for the latch
+  uint64_t disk_reads_{0};
+  uint64_t disk_read_ns_{0};
+  uint64_t disk_writes_{0};
+  uint64_t disk_write_ns_{0};
+
+  BufferPoolCounters &operator+=(const BufferPoolCounters &other) {
+    hits_ += other.hits_;
+    misses_ += other.misses_;
+    evictions_ += other.evictions_;
+    dirty_writebacks_ += other.dirty_writebacks_;
+    flushes_ += other.flushes_;
+    new_pages_ += other.new_pages_;
+    deleted_pages_ += other.deleted_pages_;
+    latch_waits_ += other.latch_waits_;
+    latch_wait_ns_ += other.latch_wait_ns_;
+    disk_reads_ += other.disk_reads_;
+    disk_read_ns_ += other.disk_read_ns_;
+    disk_writes_ += other.disk_writes_;
+    disk_write_ns_ += other.disk_write_ns_;
+    return *this;
+  }
+
+  /** @return hits / (hits + misses), 0 before the first fetch */
+  inline double HitRate() const {
+    uint64_t fetches = hits_ + misses_;
+    return fetches == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(fetches);
+  }
+};
+
+/**
+ * BufferPoolStats keeps always-on counters for one buffer pool instance. Every counter is split over NUM_SHARDS cache
+ * line sized shards and a thread always bumps the shard picked by its thread id, so the hot paths only do a relaxed
+ * increment on a line that is mostly private to the thread. Snapshot sums the shards, it is not atomic with respect to
+ * concurrent updates.
+ */
+class BufferPoolStats {
+ public:
+  enum Counter : uint32_t {
+    HITS,
+    MISSES,
+    EVICTIONS,
+    DIRTY_WRITEBACKS,
+    FLUSHES,
+    NEW_PAGES,
+    DELETED_PAGES,
+    LATCH_WAITS,
+    LATCH_WAIT_NS,
+    DISK_READS,
+    DISK_READ_NS,
+    DISK_WRITES,
+    DISK_WRITE_NS,
+    NUM_COUNTERS
+  };
+
+  BufferPoolStats() { Reset(); }
+
+  DISALLOW_COPY(BufferPoolStats);
+
+  inline void Add(Counter counter, uint64_t value = 1) {
+    shards_[ShardIndex()].counters_[counter].fetch_add(value, std::memory_order_relaxed);
+  }
+
+  BufferPoolCounters Snapshot() const {
+    uint64_t sum[NUM_COUNTERS] = {0};
+    for (const auto &shard : shards_) {
+      for (uint32_t i = 0; i < NUM_COUNTERS; i++) {
+        sum[i] += shard.counters_[i].load(std::memory_order_relaxed);
+      }
+    }
+    BufferPoolCounters counters;
+    counters.hits_ = sum[HITS];
+    counters.misses_ = sum[MISSES];
+    counters.evictions_ = sum[EVICTIONS];
+    counters.dirty_writebacks_ = sum[DIRTY_WRITEBACKS];
+    counters.flushes_ = sum[FLUSHES];
+    counters.new_pages_ = sum[NEW_PAGES];
+    counters.deleted_pages_ = sum[DELETED_PAGES];
+    counters.latch_waits_ = sum[LATCH_WAITS];
+    counters.latch_wait_ns_ = sum[LATCH_WAIT_NS];
+    counters.disk_reads_ = sum[DISK_READS];
+    counters.disk_read_ns_ = sum[DISK_READ_NS];
+    counters.disk_writes_ = sum[DISK_WRITES];
+    counters.disk_write_ns_ = sum[DISK_WRITE_NS];
+    return counters;
+  }
+
+  void Reset() {
+    for (auto &shard : shards_) {
+      for (auto &counter : shard.counters_) {
+        counter.store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+
+ private:
+  static constexpr size_t NUM_SHARDS = 16;
+
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> counters_[NUM_COUNTERS];
+  };
+
+  static inline size_t ShardIndex() {
+    static thread_local size_t index = std::hash<std::thread::id>{}(std::this_thread::get_id()) % NUM_SHARDS;
+    return index;
+  }
+
+  Shard shards_[NUM_SHARDS];
+};
+
+#endif  // MINISQL_BUFFER_POOL_STATS_H
@@ -1,12 +1,7 @@
 #ifndef MINISQL_CLOCK_REPLACER_H
 #define MINISQL_CLOCK_REPLACER_H
 
-#include <algorithm>
-#include <list>
-#include <map>
 #include <mutex>
-#include <queue>
-#include <unordered_set>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -15,7 +10,11 @@
 using namespace std;
 
 /**
- * CLOCKReplacer implements the clock replacement.
+ * CLOCKReplacer implements the clock (second chance) replacement.
+ *
+ * Frames sit on a circle indexed by frame id. Unpin puts a frame on the circle with its reference bit set, Victim
+ * sweeps the clock hand, clearing reference bits until it meets an unreferenced frame. Pin and Unpin are O(1), Victim
+ * is amortized O(1).
  */
 class CLOCKReplacer : public Replacer {
  public:
@@ -36,12 +35,17 @@ class CLOCKReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void GetHotFrames(vector<frame_id_t> *frames) override;
+
   size_t Size() override;
 
  private:
-  size_t capacity;
-  list<frame_id_t> clock_list;               // replacer中可以被替换的数据页
-  map<frame_id_t, frame_id_t> clock_status;  // 数据页的存储状态
+  size_t capacity_;
+  vector<uint8_t> in_clock_;   // 页帧是否可以被替换
+  vector<uint8_t> reference_;  // 页帧的引用位
+  size_t hand_{0};             // 时钟指针
+  size_t size_{0};
+  mutex mutex_;
 };
 
-#endif  // MINISQL_CLOCK_REPLACER_H
\ No newline at end of file
+#endif  // MINISQL_CLOCK_REPLACER_H
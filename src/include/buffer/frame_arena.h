@@ -0,0 +1,45 @@
+#ifndef MINISQL_FRAME_ARENA_H
+#define MINISQL_FRAME_ARENA_H
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+/**
+ * FrameArena is the memory that holds the data of all frames of a buffer pool instance.
+ *
+ * It is one anonymous mapping, so every frame is PAGE_SIZE aligned (as O_DIRECT requires) and no frame shares a cache
+ * line with frame metadata. With huge pages requested, the arena is first mapped with MAP_HUGETLB; if no huge pages are
+ * reserved it falls back to a normal mapping advised for transparent huge pages.
+ */
+class FrameArena {
+ public:
+  /**
+   * @param num_frames number of PAGE_SIZE frames
+   * @param use_huge_pages back the arena with huge pages if possible
+   */
+  FrameArena(size_t num_frames, bool use_huge_pages);
+
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the data of frame frame_id, zeroed when the arena is created */
+  inline char *GetFrameData(size_t frame_id) const { return base_ + frame_id * PAGE_SIZE; }
+
+  /** Give the memory of a frame that is out of use back to the kernel, it reads as zeros once it is used again. */
+  void Release(size_t frame_id);
+
+  /** @return true if the arena is mapped with MAP_HUGETLB */
+  inline bool UsesHugeTLB() const { return huge_tlb_; }
+
+ private:
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  char *base_{nullptr};
+  size_t mapped_size_{0};
+  bool huge_tlb_{false};
+};
+
+#endif  // MINISQL_FRAME_ARENA_H
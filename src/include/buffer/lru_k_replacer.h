@@ -0,0 +1,72 @@
+#ifndef MINISQL_LRU_K_REPLACER_H
+#define MINISQL_LRU_K_REPLACER_H
+
+#include <mutex>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * LRUKReplacer implements a scan resistant LRU-K replacement policy.
+ *
+ * Every Pin counts as an access of the frame, Unpin does not. Frames with fewer than k distinct accesses since their page was loaded
+ * are kept on a history list, the others on a cache list; victims come from the history list first, so pages touched
+ * once by a sequential scan are evicted before pages that are re-referenced, e.g. B+ tree internal pages.
+ *
+ * Accesses are only distinct if some page was loaded in between (the correlated reference period of LRU-K measured in
+ * page loads), otherwise the many pins a scan does on one page while walking its tuples would promote it. Both lists
+ * are intrusive and ordered by last unpin, so all operations are O(1); the cache list therefore approximates the
+ * K-distance order with plain LRU.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k number of distinct accesses after which a frame is considered hot
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = 2);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  void GetHotFrames(vector<frame_id_t> *frames) override;
+
+  size_t Size() override;
+
+ private:
+  void RecordAccess(frame_id_t frame_id);
+
+  void PushFront(frame_id_t list, frame_id_t frame_id);
+
+  void Unlink(frame_id_t frame_id);
+
+ private:
+  size_t max_size_;
+  size_t k_;
+  frame_id_t history_;  // sentinel of the history list
+  frame_id_t cache_;    // sentinel of the cache list
+  vector<frame_id_t> prev_;
+  vector<frame_id_t> next_;
+  vector<bool> in_list_;
+  vector<uint32_t> access_count_;  // distinct accesses since the page was loaded, 0 if the frame is untracked
+  vector<uint64_t> access_epoch_;  // load epoch of the last distinct access
+  uint64_t load_epoch_{0};         // bumped whenever a frame sees its first access
+  size_t size_{0};
+  mutex mutex_;
+};
+
+#endif  // MINISQL_LRU_K_REPLACER_H
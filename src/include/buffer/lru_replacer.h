@@ -1,9 +1,7 @@
 #ifndef MINISQL_LRU_REPLACER_H
 #define MINISQL_LRU_REPLACER_H
 
-#include <list>
 #include <mutex>
-#include <unordered_set>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -13,6 +11,9 @@ using namespace std;
 
 /**
  * LRUReplacer implements the Least Recently Used replacement policy.
+ *
+ * The LRU list is intrusive: prev/next links are kept in flat arrays indexed by frame id, so Pin, Unpin and Victim
+ * are all O(1) and never allocate.
  */
 class LRUReplacer : public Replacer {
  public:
@@ -33,15 +34,24 @@ class LRUReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void Remove(frame_id_t frame_id) override;
+
+  void GetHotFrames(vector<frame_id_t> *frames) override;
+
   size_t Size() override;
 
-private:
-  // add your own private member variables here
-  list<frame_id_t> free_list_; // 用于存储可替换的页帧号，按访问顺序排列
-  unordered_set<frame_id_t> free_set_; // 用于快速查找页帧号是否在lru_list_中
+ private:
+  /** Unlink a frame that is in the list. */
+  void Unlink(frame_id_t frame_id);
+
+ private:
+  // Node max_size_ is the sentinel: next_[sentinel] is the most recently unpinned frame, prev_[sentinel] the victim.
+  vector<frame_id_t> prev_;
+  vector<frame_id_t> next_;
+  vector<bool> in_list_;  // 页帧是否在链表中
   size_t size_;
   size_t max_size_;
-  mutex mutex_; // 用于线程安全
+  mutex mutex_;  // 用于线程安全
 };
 
 #endif  // MINISQL_LRU_REPLACER_H
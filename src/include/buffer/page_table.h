@@ -0,0 +1,164 @@
+#ifndef MINISQL_PAGE_TABLE_H
+#define MINISQL_PAGE_TABLE_H
+
+#include <atomic>
+#include <memory>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+/**
+ * PageTable maps resident page ids to frame ids for one buffer pool instance.
+ *
+ * It is an open-addressing hash table with linear probing whose slots are single atomic words, so readers never take
+ * a latch. All writes (Insert/Erase) must be serialized by the caller, the buffer pool instance does them under its
+ * latch. A lock-free Find is only a hint: it may miss an entry that is being moved, and the frame it returns may be
+ * remapped right after the lookup, so the caller has to validate the frame after pinning it. A Find done while
+ * holding the writer latch is exact.
+ */
+class PageTable {
+ public:
+  /**
+   * @param max_entries the maximum number of live entries, i.e. the number of frames of the instance
+   */
+  explicit PageTable(size_t max_entries) {
+    capacity_ = 16;
+    while (capacity_ < max_entries * 2) {
+      capacity_ <<= 1;
+    }
+    mask_ = capacity_ - 1;
+    slots_.reset(new std::atomic<uint64_t>[capacity_]);
+    for (size_t i = 0; i < capacity_; i++) {
+      slots_[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+    }
+  }
+
+  ~PageTable() = default;
+
+  DISALLOW_COPY(PageTable);
+
+  /**
+   * @return the frame holding page_id, or INVALID_FRAME_ID if the page is not in the table
+   */
+  frame_id_t Find(page_id_t page_id) const {
+    size_t pos = Hash(page_id);
+    for (size_t i = 0; i < capacity_; i++) {
+      uint64_t slot = slots_[pos].load(std::memory_order_acquire);
+      if (slot == EMPTY_SLOT) {
+        break;
+      }
+      // a tombstone decodes to page id -1, it must never match INVALID_PAGE_ID
+      if (slot != TOMBSTONE_SLOT && SlotPageId(slot) == page_id) {
+        return SlotFrameId(slot);
+      }
+      pos = (pos + 1) & mask_;
+    }
+    return INVALID_FRAME_ID;
+  }
+
+  /**
+   * Insert or overwrite the mapping of page_id. Writer latch required.
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id) {
+    ASSERT(page_id >= 0, "Invalid page id.");
+    size_t pos = Hash(page_id);
+    size_t target = capacity_;
+    for (size_t i = 0; i < capacity_; i++) {
+      uint64_t slot = slots_[pos].load(std::memory_order_relaxed);
+      if (slot != EMPTY_SLOT && SlotPageId(slot) == page_id) {
+        slots_[pos].store(MakeSlot(page_id, frame_id), std::memory_order_release);
+        return;
+      }
+      if (slot == TOMBSTONE_SLOT && target == capacity_) {
+        target = pos;
+      }
+      if (slot == EMPTY_SLOT) {
+        if (target == capacity_) {
+          target = pos;
+        }
+        break;
+      }
+      pos = (pos + 1) & mask_;
+    }
+    ASSERT(target != capacity_, "Page table is full.");
+    if (slots_[target].load(std::memory_order_relaxed) == TOMBSTONE_SLOT) {
+      tombstones_--;
+    }
+    slots_[target].store(MakeSlot(page_id, frame_id), std::memory_order_release);
+    size_++;
+  }
+
+  /**
+   * Remove the mapping of page_id if present. Writer latch required.
+   */
+  void Erase(page_id_t page_id) {
+    size_t pos = Hash(page_id);
+    for (size_t i = 0; i < capacity_; i++) {
+      uint64_t slot = slots_[pos].load(std::memory_order_relaxed);
+      if (slot == EMPTY_SLOT) {
+        return;
+      }
+      if (slot != TOMBSTONE_SLOT && SlotPageId(slot) == page_id) {
+        slots_[pos].store(TOMBSTONE_SLOT, std::memory_order_release);
+        size_--;
+        tombstones_++;
+        // Tombstones lengthen every probe that passes them, rebuild once they take up a quarter of the table.
+        if (tombstones_ * 4 > capacity_) {
+          Rehash();
+        }
+        return;
+      }
+      pos = (pos + 1) & mask_;
+    }
+  }
+
+  /** @return the number of live entries. Writer latch required. */
+  inline size_t Size() const { return size_; }
+
+ private:
+  static constexpr uint64_t EMPTY_SLOT = ~0ULL;
+  static constexpr uint64_t TOMBSTONE_SLOT = EMPTY_SLOT - 1;
+
+  static inline uint64_t MakeSlot(page_id_t page_id, frame_id_t frame_id) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+
+  static inline page_id_t SlotPageId(uint64_t slot) { return static_cast<page_id_t>(slot >> 32); }
+
+  static inline frame_id_t SlotFrameId(uint64_t slot) { return static_cast<frame_id_t>(slot & 0xFFFFFFFFULL); }
+
+  /** Fibonacci hashing, page ids of one instance are strided by the number of instances. */
+  inline size_t Hash(page_id_t page_id) const {
+    return static_cast<size_t>(static_cast<uint32_t>(page_id) * 2654435761U) & mask_;
+  }
+
+  /**
+   * Rebuild the table in place to drop all tombstones. Concurrent lock-free readers may miss entries while this runs,
+   * they fall back to the latched path, which cannot run until the writer is done.
+   */
+  void Rehash() {
+    std::unique_ptr<uint64_t[]> live(new uint64_t[size_]);
+    size_t n = 0;
+    for (size_t i = 0; i < capacity_; i++) {
+      uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+      if (slot != EMPTY_SLOT && slot != TOMBSTONE_SLOT) {
+        live[n++] = slot;
+      }
+      slots_[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+    }
+    size_ = 0;
+    tombstones_ = 0;
+    for (size_t i = 0; i < n; i++) {
+      Insert(SlotPageId(live[i]), SlotFrameId(live[i]));
+    }
+  }
+
+ private:
+  size_t capacity_;
+  size_t mask_;
+  size_t size_{0};
+  size_t tombstones_{0};
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+};
+
+#endif  // MINISQL_PAGE_TABLE_H
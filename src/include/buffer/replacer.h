@@ -2,6 +2,7 @@
 #define MINISQL_REPLACER_H
 
 #include <cstdio>
+#include <vector>
 
 #include "common/config.h"
 
@@ -33,6 +34,18 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Forgets a frame whose page has left the buffer pool, including any access history kept for it.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
+  /**
+   * Append the frames that can be victimized, from the hottest one to the next victim.
+   * @param[out] frames frames in the order opposite to the one they would be victimized in
+   */
+  virtual void GetHotFrames(std::vector<frame_id_t> *frames) = 0;
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
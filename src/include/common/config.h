@@ -13,8 +13,49 @@ static constexpr int META_PAGE_ID = 0;          // physical page id of the disk
 static constexpr int CATALOG_META_PAGE_ID = 0;  // logical page id of the catalog meta data
 static constexpr int INDEX_ROOTS_PAGE_ID = 1;   // logical page id of the index roots
 
-static constexpr int PAGE_SIZE = 4096;                  // size of a data page in byte
-static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;  // default size of buffer pool
+static constexpr int PAGE_SIZE = 4096;                   // size of a data page in byte
+static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;   // default size of buffer pool
+static constexpr int DEFAULT_BUFFER_POOL_INSTANCES = 1;  // default number of buffer pool partitions
+static constexpr int BUFFER_POOL_MAX_GROWTH = 4;         // online resize limit, as a multiple of the initial size
+static constexpr bool DEFAULT_USE_HUGE_PAGES = false;    // back buffer pool frames with huge pages
+static constexpr bool DEFAULT_DIRECT_IO = false;         // open database files with O_DIRECT
+static constexpr bool DEFAULT_PAGE_COMPRESSION = false;  // store the pages of new database files compressed
+
+/** Page replacement policy of a buffer pool, chosen when a database is opened. */
+enum class ReplacerType : uint8_t { LRU, CLOCK, LRU_K };
+
+static constexpr ReplacerType DEFAULT_REPLACER_TYPE = ReplacerType::LRU;
+
+/**
+ * When written pages are made durable, chosen per database: NONE leaves it to the OS, PERIODIC syncs the file in the
+ * background every sync interval, STRICT syncs at every commit and checkpoint.
+ */
+enum class DurabilityMode : uint8_t { NONE, PERIODIC, STRICT };
+
+static constexpr DurabilityMode DEFAULT_DURABILITY_MODE = DurabilityMode::PERIODIC;
+static constexpr int DEFAULT_SYNC_INTERVAL_MS = 1000;  // period of the background sync in periodic durability mode
+
+/**
+ * Backend of the asynchronous page I/O queues. IO_URING falls back to THREAD_POOL where the kernel does not support
+ * it, THREAD_POOL falls back to SYNC, which transfers the pages in Submit, when no I/O threads are configured.
+ */
+enum class IOBackend : uint8_t { IO_URING, THREAD_POOL, SYNC };
+
+static constexpr IOBackend DEFAULT_IO_BACKEND = IOBackend::IO_URING;
+static constexpr int DEFAULT_IO_QUEUE_DEPTH = 32;  // page transfers an asynchronous I/O queue keeps in flight
+static constexpr int DEFAULT_IO_THREADS = 4;       // threads of the THREAD_POOL backend, per disk manager
+
+static constexpr double DEFAULT_BG_FLUSH_CLEAN_FRACTION = 0.1;  // fraction of frames the background writer keeps clean
+static constexpr int DEFAULT_BG_FLUSH_INTERVAL_MS = 100;        // period of the background writer
+static constexpr int DEFAULT_READ_AHEAD_WINDOW = 8;             // pages scans prefetch along their page chain
+static constexpr int MAX_PENDING_PREFETCHES = 64;               // prefetch requests queued before new ones are dropped
+static constexpr int HOT_PAGES_SAVE_INTERVAL_MS = 60000;        // period of saving the hot page set for warm start
+static constexpr int SEGMENT_RUN_PAGES = 64;                    // contiguous pages reserved at a time for a segment
+static constexpr int FILE_PREALLOCATE_PAGES = 256;              // pages the db file is grown by at a time
+static constexpr int HOLE_PUNCH_MIN_PAGES = 16;                 // free runs at least this long give their space back
+static constexpr double VACUUM_MERGE_FILL = 0.25;               // vacuum merges pages filled below this into the previous
+static constexpr int AUTOVACUUM_MIN_DEAD_TUPLES = 1000;         // deletes a table gathers before autovacuum visits it
+static constexpr int BULK_LOAD_INDEX_BATCH = 65536;             // rows a bulk load sorts into its indexes at a time
 
 static constexpr uint32_t FIELD_NULL_LEN = UINT32_MAX;
 static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;  // max length of varchar
@@ -28,5 +69,17 @@ using lsn_t = int32_t;
 using column_id_t = uint32_t;
 using index_id_t = uint32_t;
 using table_id_t = uint32_t;
+using segment_id_t = int64_t;
+
+/**
+ * A segment is the set of pages of one table heap or one index. Pages allocated for a segment come out of runs of
+ * SEGMENT_RUN_PAGES contiguous pages reserved for it, so that its pages are not interleaved with the pages of other
+ * segments on disk. A table heap is identified by its first page, an index by its index id.
+ */
+static constexpr segment_id_t INVALID_SEGMENT_ID = -1;
+
+static constexpr segment_id_t TableHeapSegmentId(page_id_t first_page_id) { return first_page_id; }
+
+static constexpr segment_id_t IndexSegmentId(index_id_t index_id) { return (segment_id_t{1} << 32) | index_id; }
 
 #endif  // MINISQL_CONFIG_H
@@ -14,12 +14,33 @@
 
 class DBStorageEngine {
  public:
-  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE);
+  /**
+   * @param read_only open an existing database read-only: its file is mapped into memory and pages are read in place,
+   * without going through buffer pool frames (see BufferPoolManager), and every write is refused. Meant for analytical
+   * use of a database that is not being changed. Requires init to be false.
+   */
+  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE,
+                           uint32_t buffer_pool_instances = DEFAULT_BUFFER_POOL_INSTANCES,
+                           ReplacerType replacer_type = DEFAULT_REPLACER_TYPE,
+                           DurabilityMode durability = DEFAULT_DURABILITY_MODE,
+                           bool compress = DEFAULT_PAGE_COMPRESSION, bool read_only = false);
 
   ~DBStorageEngine();
 
   std::unique_ptr<ExecuteContext> MakeExecuteContext(Txn *txn);
 
+  /**
+   * Commit boundary of a statement that changed the database. In STRICT durability mode every dirty page is written
+   * back and synced before it returns, the other modes leave the pages to the buffer pool.
+   */
+  void Commit();
+
+  /** @return true if the database is opened read-only */
+  inline bool IsReadOnly() const { return disk_mgr_->IsReadOnly(); }
+
+  /** @return the hidden sidecar file next to the database file that keeps the hot pages for a warm start */
+  static std::string GetHotPagesFileName(const std::string &db_file_name);
+
  public:
   DiskManager *disk_mgr_;
   BufferPoolManager *bpm_;
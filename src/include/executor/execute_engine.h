@@ -1,8 +1,12 @@
 #ifndef MINISQL_EXECUTE_ENGINE_H
 #define MINISQL_EXECUTE_ENGINE_H
 
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 
 #include "common/dberr.h"
@@ -25,6 +29,7 @@ class ExecuteEngine {
   ExecuteEngine();
 
   ~ExecuteEngine() {
+    StopAutoVacuum();
     for (auto it : dbs_) {
       delete it.second;
     }
@@ -73,9 +78,43 @@ class ExecuteEngine {
 
   dberr_t ExecuteQuit(pSyntaxNode ast, ExecuteContext *context);
 
+  dberr_t ExecuteShowBufferPoolStatus(pSyntaxNode ast, ExecuteContext *context);
+
+  dberr_t ExecuteSetBufferPoolSize(pSyntaxNode ast, ExecuteContext *context);
+
+  dberr_t ExecuteSetDurability(pSyntaxNode ast, ExecuteContext *context);
+
+  dberr_t ExecuteVacuumFile(pSyntaxNode ast, ExecuteContext *context);
+
+  dberr_t ExecuteVacuumTable(pSyntaxNode ast, ExecuteContext *context);
+
+  dberr_t ExecuteSetAutoVacuum(pSyntaxNode ast, ExecuteContext *context);
+
+  dberr_t ExecuteLoadData(pSyntaxNode ast, ExecuteContext *context);
+
+  /** Vacuum the heap of a table, moving the index entries of the rows it relocates along. */
+  TableHeap::VacuumStats VacuumTable(DBStorageEngine *db, TableInfo *table_info);
+
+  /**
+   * Body of the autovacuum thread: every interval, between statements, vacuum the tables of the open databases that
+   * gathered at least AUTOVACUUM_MIN_DEAD_TUPLES deletes.
+   */
+  void RunAutoVacuum();
+
+  void StopAutoVacuum();
+
+  /** Every statement runs on its own, a successful statement that changed the current database commits it. */
+  dberr_t EndStatement(dberr_t result);
+
  private:
   std::unordered_map<std::string, DBStorageEngine *> dbs_; /** all opened databases */
   std::string current_db_;                                 /** current database */
+  std::recursive_mutex statement_latch_;                   /** held by a statement and by a round of autovacuum */
+  std::thread autovacuum_thread_;
+  std::mutex autovacuum_latch_;
+  std::condition_variable autovacuum_cv_;
+  bool autovacuum_stop_{false};
+  std::chrono::seconds autovacuum_interval_{0};
 };
 
 #endif  // MINISQL_EXECUTE_ENGINE_H
@@ -41,6 +41,9 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
   void SetNextPageId(page_id_t next_page_id);
 
+  /** Read the next page id from raw page data, e.g. for read-ahead. */
+  static page_id_t ReadNextPageId(const char *page_data);
+
   GenericKey *KeyAt(int index);
 
   void SetKeyAt(int index, GenericKey *key);
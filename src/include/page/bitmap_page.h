@@ -29,6 +29,37 @@ class BitmapPage {
    * @return whether a page in the extent is free
    */
   bool IsPageFree(uint32_t page_offset) const;
+
+  /**
+   * Allocate the lowest run of count contiguous free pages.
+   * @param page_offset Index in extent of the first page of the run.
+   * @return true if the extent has such a run.
+   */
+  bool AllocateRun(uint32_t count, uint32_t &page_offset);
+
+  /**
+   * Allocate the free pages starting at page_offset, up to max_count of them.
+   * @return the number of pages allocated, 0 if the page at page_offset is not free.
+   */
+  uint32_t AllocateRunAt(uint32_t page_offset, uint32_t max_count);
+
+  /**
+   * @return the number of allocated pages counted in the bitmap itself, which should match page_allocated_
+   */
+  uint32_t CountAllocated() const;
+
+  /**
+   * Find the next run of free pages.
+   * @param page_offset where to start looking, set to the first page of the run
+   * @return the length of the run, 0 if no page at or after page_offset is free
+   */
+  uint32_t NextFreeRun(uint32_t &page_offset) const;
+
+  /** @return one past the last allocated page, 0 if no page is allocated */
+  uint32_t GetAllocatedEnd() const;
+
+  /** @return the number of allocated pages as recorded in the page header */
+  inline uint32_t GetAllocatedPages() const { return page_allocated_; }
 /*
   void SerializeTo(char* buffer) const {
     // 写入元数据
@@ -72,9 +103,29 @@ void DeserializeFrom(const char* buffer) {
    */
   bool IsPageFreeLow(uint32_t byte_index, uint8_t bit_index) const;
 
+  /**
+   * The bitmap is searched a 64-bit word at a time, bit i of word w records page 64 * w + i. Words are loaded with
+   * memcpy as the page is only guaranteed to be 4-byte aligned.
+   */
+  uint64_t LoadWord(uint32_t word_index) const;
+
+  void StoreWord(uint32_t word_index, uint64_t word);
+
+  /**
+   * @return the first page at or after page_offset that is allocated (or free), GetMaxSupportedSize() if there is none
+   */
+  uint32_t FindNext(uint32_t page_offset, bool allocated) const;
+
+  /** Mark count pages starting at page_offset as allocated, they must be free. */
+  void SetRun(uint32_t page_offset, uint32_t count);
+
   /** Note: need to update if modify page structure. */
   static constexpr size_t MAX_CHARS = PageSize - 2 * sizeof(uint32_t);
 
+  static constexpr size_t NUM_WORDS = MAX_CHARS / sizeof(uint64_t);
+
+  static_assert(MAX_CHARS % sizeof(uint64_t) == 0, "The bitmap must consist of whole 64-bit words.");
+
  private:
   /** The space occupied by all members of the class should be equal to the PageSize */
   [[maybe_unused]] uint32_t page_allocated_;
@@ -0,0 +1,67 @@
+#ifndef MINISQL_FREE_SPACE_MAP_PAGE_H
+#define MINISQL_FREE_SPACE_MAP_PAGE_H
+
+#include <cstdint>
+
+#include "common/config.h"
+
+/**
+ * A page of the free space map of a table heap, see FreeSpaceMap. The pages of a map are chained by NextPageId, and
+ * each records the free space category of up to MAX_ENTRY_COUNT heap pages.
+ *
+ * Format (size in byte):
+ *  ---------------------------------------------------------------------------------------------------
+ * | Version (4) | NextPageId (4) | EntryCount (4) | LastHeapPageId (4) | HeapPageId_1 (4) | ... |
+ *  ---------------------------------------------------------------------------------------------------
+ *  ---------------------------------------------
+ * | ... | Category_1 (1) | Category_2 (1) | ... |
+ *  ---------------------------------------------
+ *
+ * LastHeapPageId is the tail of the heap page chain, only kept on the first page of the map. The entry of a heap
+ * page that was freed has INVALID_PAGE_ID as page id, until a new heap page takes it.
+ */
+class FreeSpaceMapPage {
+ public:
+  void Init();
+
+  /**
+   * @return false if the page is full
+   */
+  bool Append(page_id_t heap_page_id, uint8_t category);
+
+  inline uint32_t GetVersion() const { return version_; }
+
+  inline page_id_t GetNextPageId() const { return next_page_id_; }
+
+  inline void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  inline uint32_t GetEntryCount() const { return count_; }
+
+  inline page_id_t GetLastHeapPageId() const { return last_heap_page_id_; }
+
+  inline void SetLastHeapPageId(page_id_t page_id) { last_heap_page_id_ = page_id; }
+
+  inline page_id_t GetHeapPageId(uint32_t index) const { return heap_page_ids_[index]; }
+
+  inline void SetHeapPageId(uint32_t index, page_id_t heap_page_id) { heap_page_ids_[index] = heap_page_id; }
+
+  inline uint8_t GetCategory(uint32_t index) const { return categories_[index]; }
+
+  inline void SetCategory(uint32_t index, uint8_t category) { categories_[index] = category; }
+
+  static constexpr uint32_t VERSION = 1;
+  static constexpr uint32_t SIZE_HEADER = 16;
+  static constexpr uint32_t MAX_ENTRY_COUNT = (PAGE_SIZE - SIZE_HEADER) / (sizeof(page_id_t) + sizeof(uint8_t));
+
+ private:
+  uint32_t version_;
+  page_id_t next_page_id_;
+  uint32_t count_;
+  page_id_t last_heap_page_id_;
+  page_id_t heap_page_ids_[MAX_ENTRY_COUNT];
+  uint8_t categories_[MAX_ENTRY_COUNT];
+};
+
+static_assert(sizeof(FreeSpaceMapPage) <= PAGE_SIZE);
+
+#endif  // MINISQL_FREE_SPACE_MAP_PAGE_H
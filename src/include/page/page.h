@@ -1,8 +1,10 @@
 #ifndef MINISQL_PAGE_H
 #define MINISQL_PAGE_H
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <shared_mutex>
 
 #include "common/config.h"
@@ -12,16 +14,21 @@
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * The data of a buffer pool frame is not stored inline: it lives in the page aligned frame arena of the buffer pool,
+ * so that the array of Page objects only holds the compact frame metadata. A standalone Page owns its data. A view
+ * of a read-only database points into the mapping of the db file, see BufferPoolManager.
  */
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
+  friend class BufferPoolManagerInstance;
   friend class BufferPoolManager;
 
  public:
   DISALLOW_COPY(Page)
 
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor of a standalone page. Zeros out the page data. */
+  Page() : owned_data_(new char[PAGE_SIZE]), data_(owned_data_.get()) { ResetMemory(); }
 
   /** Default destructor. */
   ~Page() = default;
@@ -30,13 +37,13 @@ class Page {
   inline char *GetData() { return data_; }
 
   /** @return the page id of this page */
-  inline page_id_t GetPageId() { return page_id_; }
+  inline page_id_t GetPageId() { return page_id_.load(std::memory_order_acquire); }
 
   /** @return the pin count of this page */
-  inline int GetPinCount() { return pin_count_; }
+  inline int GetPinCount() { return pin_count_.load(std::memory_order_acquire); }
 
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
-  inline bool IsDirty() { return is_dirty_; }
+  inline bool IsDirty() { return is_dirty_.load(std::memory_order_acquire); }
 
   /** Acquire the page write latch. */
   inline void WLatch() { rwlatch_.WLock(); }
@@ -65,17 +72,31 @@ class Page {
   static constexpr size_t OFFSET_LSN = 4;
 
  private:
+  /** Constructor of a buffer pool frame whose data is PAGE_SIZE bytes of the frame arena, or of a page view. */
+  explicit Page(char *data) : data_(data) {}
+
+  /** I/O state of the frame holding this page, only the buffer pool manager reads and writes it. */
+  enum class IOState : uint8_t {
+    READY,         // page content is valid
+    LOADING,       // page is mapped and being read in from disk
+    WRITING_BACK,  // page is being written back before the frame is reused
+  };
+
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
+  /** Backing store of a standalone page, empty for buffer pool frames. */
+  std::unique_ptr<char[]> owned_data_;
   /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
-  /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  char *data_;
+  /** The ID of this page. Atomic because resident pages are looked up and pinned without the buffer pool latch. */
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  /** The pin count of this page, negative while the buffer pool is remapping the frame. */
+  std::atomic<int> pin_count_{0};
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_{false};
+  /** Whether the page content is valid or a disk transfer is in flight. */
+  std::atomic<IOState> io_state_{IOState::READY};
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
 };
@@ -12,9 +12,23 @@
  *  ----------------------------------------------------------------------------
  *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| FreeSpacePointer(4) |
  *  ----------------------------------------------------------------------------
- *  ----------------------------------------------------------------
- *  | TupleCount (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
- *  ----------------------------------------------------------------
+ *  --------------------------------------------------------------------
+ *  | TupleCount (4) | Version (4) | FreeSlotHead (4) | FragmentedBytes (4) |
+ *  --------------------------------------------------------------------
+ *  ---------------------------------------------------
+ *  | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
+ *  ---------------------------------------------------
+ *
+ *  An empty slot (size 0) keeps the number of the next empty slot in its offset field, FreeSlotHead is the first one,
+ *  so that inserts reuse a slot without scanning the slot array.
+ *
+ *  A delete leaves the bytes of its tuple where they are and counts them in FragmentedBytes. The tuples are packed
+ *  again, all at once, when an insert or update needs more contiguous space than the page has, or by Compact.
+ *
+ *  Version and FreeSlotHead came with the second page format, FragmentedBytes with the third. Pages of the first
+ *  format have the slot array right after TupleCount, where a tuple offset is never larger than PAGE_SIZE, which tells
+ *  them apart from the version. Older pages are read as they are and upgraded the first time an insert or delete finds
+ *  room for the larger header, until then deletes pack their tuples right away.
  **/
 
 #include <cstring>
@@ -37,6 +51,11 @@ class TablePage : public Page {
 
   page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
 
+  /** Read the next page id from raw page data, e.g. for read-ahead. */
+  static page_id_t ReadNextPageId(const char *page_data) {
+    return MACH_READ_FROM(page_id_t, page_data + OFFSET_NEXT_PAGE_ID);
+  }
+
   void SetPrevPageId(page_id_t prev_page_id) {
     memcpy(GetData() + OFFSET_PREV_PAGE_ID, &prev_page_id, sizeof(page_id_t));
   }
@@ -67,9 +86,28 @@ class TablePage : public Page {
   static bool IsDeleted(uint32_t tuple_size) { return static_cast<bool>(tuple_size & DELETE_MASK) || tuple_size == 0; }
 
   uint32_t GetTupleSize(uint32_t slot_num) {
-    return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num);
+    return *reinterpret_cast<uint32_t *>(GetData() + GetHeaderSize() + OFFSET_SLOT_SIZE + SIZE_TUPLE * slot_num);
   }
 
+  /** @return the free bytes of the page, fragmented bytes included */
+  uint32_t GetFreeSpaceRemaining() { return GetContiguousFreeSpace() + GetFragmentedBytes(); }
+
+  /** @return the bytes of deleted tuples not packed yet */
+  uint32_t GetFragmentedBytes() {
+    return IsCurrentFormat() ? *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FRAGMENTED_BYTES) : 0;
+  }
+
+  /** @return whether the page is in the current format, i.e. has a free slot list and counts fragmented bytes */
+  bool IsCurrentFormat() { return MACH_READ_UINT32(GetData() + OFFSET_VERSION) == FORMAT_VERSION; }
+
+  /**
+   * Pack the tuples against the end of the page, turning the fragmented bytes into contiguous free space.
+   */
+  void Compact();
+
+  /** @return the bytes a tuple of tuple_size takes in a page, its slot included */
+  static uint32_t GetSpaceNeeded(uint32_t tuple_size) { return tuple_size + SIZE_TUPLE; }
+
  private:
   uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
 
@@ -79,20 +117,46 @@ class TablePage : public Page {
 
   void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
 
-  uint32_t GetFreeSpaceRemaining() {
-    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
+  uint32_t GetHeaderSize() {
+    uint32_t version = MACH_READ_UINT32(GetData() + OFFSET_VERSION);
+    if (version == FORMAT_VERSION) {
+      return SIZE_TABLE_PAGE_HEADER;
+    }
+    return version == FORMAT_VERSION_V2 ? SIZE_TABLE_PAGE_HEADER_V2 : SIZE_TABLE_PAGE_HEADER_V1;
+  }
+
+  bool HasFreeSlotList() {
+    uint32_t version = MACH_READ_UINT32(GetData() + OFFSET_VERSION);
+    return version == FORMAT_VERSION || version == FORMAT_VERSION_V2;
+  }
+
+  uint32_t GetContiguousFreeSpace() {
+    return GetFreeSpacePointer() - GetHeaderSize() - SIZE_TUPLE * GetTupleCount();
   }
 
+  void SetFragmentedBytes(uint32_t bytes) { memcpy(GetData() + OFFSET_FRAGMENTED_BYTES, &bytes, sizeof(uint32_t)); }
+
+  uint32_t GetFreeSlotHead() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SLOT_HEAD); }
+
+  void SetFreeSlotHead(uint32_t slot_num) { memcpy(GetData() + OFFSET_FREE_SLOT_HEAD, &slot_num, sizeof(uint32_t)); }
+
+  /**
+   * Move the slot array of a page of an older format behind the current header, putting the empty slots of a page of
+   * the first format on the free slot list.
+   * @return false if the page has no room for the larger header
+   */
+  bool UpgradeFormat();
+
   uint32_t GetTupleOffsetAtSlot(uint32_t slot_num) {
-    return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
+    return *reinterpret_cast<uint32_t *>(GetData() + GetHeaderSize() + OFFSET_SLOT_OFFSET + SIZE_TUPLE * slot_num);
   }
 
   void SetTupleOffsetAtSlot(uint32_t slot_num, uint32_t offset) {
-    memcpy(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num, &offset, sizeof(uint32_t));
+    memcpy(GetData() + GetHeaderSize() + OFFSET_SLOT_OFFSET + SIZE_TUPLE * slot_num, &offset, sizeof(uint32_t));
   }
 
   void SetTupleSize(uint32_t slot_num, uint32_t size) {
-    memcpy(GetData() + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num, &size, sizeof(uint32_t));
+    memcpy(GetData() + GetHeaderSize() + OFFSET_SLOT_SIZE + SIZE_TUPLE * slot_num, &size, sizeof(uint32_t));
   }
 
   static uint32_t SetDeletedFlag(uint32_t tuple_size) { return static_cast<uint32_t>(tuple_size | DELETE_MASK); }
@@ -102,14 +166,25 @@ class TablePage : public Page {
  private:
   static_assert(sizeof(page_id_t) == 4);
   static constexpr uint64_t DELETE_MASK = (1U << (8 * sizeof(uint32_t) - 1));
-  static constexpr size_t SIZE_TABLE_PAGE_HEADER = 24;
+  static constexpr size_t SIZE_TABLE_PAGE_HEADER_V1 = 24;
+  static constexpr size_t SIZE_TABLE_PAGE_HEADER_V2 = 32;
+  static constexpr size_t SIZE_TABLE_PAGE_HEADER = 36;
   static constexpr size_t SIZE_TUPLE = 8;
   static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
   static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
   static constexpr size_t OFFSET_FREE_SPACE = 16;
   static constexpr size_t OFFSET_TUPLE_COUNT = 20;
-  static constexpr size_t OFFSET_TUPLE_OFFSET = 24;
-  static constexpr size_t OFFSET_TUPLE_SIZE = 28;
+  static constexpr size_t OFFSET_VERSION = 24;
+  static constexpr size_t OFFSET_FREE_SLOT_HEAD = 28;
+  static constexpr size_t OFFSET_FRAGMENTED_BYTES = 32;
+  // offsets inside a slot of the slot array
+  static constexpr size_t OFFSET_SLOT_OFFSET = 0;
+  static constexpr size_t OFFSET_SLOT_SIZE = 4;
+  // larger than any tuple offset, so that the first format is told apart
+  static constexpr uint32_t FORMAT_VERSION_V2 = 0x54500002;
+  static constexpr uint32_t FORMAT_VERSION = 0x54500003;
+  static constexpr uint32_t NO_FREE_SLOT = UINT32_MAX;
+  static_assert(FORMAT_VERSION > PAGE_SIZE);
 
  public:
   static constexpr size_t SIZE_MAX_ROW = PAGE_SIZE - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE;
@@ -1,5 +1,6 @@
 %{
   #include <stdio.h>
+  #include <string.h>
   #include "parser/parser.h"
 
   extern char *yytext;
@@ -28,6 +29,8 @@
 %type <syntax_node> connector where_conditions where_condition
 %type <syntax_node> sql_insert sql_delete sql_update update_values update_value
 %type <syntax_node> sql_quit sql_exec_file
+%type <syntax_node> sql_show_bufferpool_status sql_set_bufferpool_size sql_set_durability sql_vacuum
+%type <syntax_node> sql_set_autovacuum sql_load_data
 
 %%
 
@@ -58,6 +61,12 @@ sql:
   | sql_trx_rollback { $$ = $1; }
   | sql_quit { $$ = $1; }
   | sql_exec_file { $$ = $1; }
+  | sql_show_bufferpool_status { $$ = $1; }
+  | sql_set_bufferpool_size { $$ = $1; }
+  | sql_set_durability { $$ = $1; }
+  | sql_vacuum { $$ = $1; }
+  | sql_set_autovacuum { $$ = $1; }
+  | sql_load_data { $$ = $1; }
   ;
 
 sql_create_database:
@@ -393,6 +402,87 @@ sql_exec_file:
   }
   ;
 
+/* bufferpool and status are not keywords, so that they stay usable as table and column names. */
+sql_show_bufferpool_status:
+  SHOW IDENTIFIER IDENTIFIER {
+    if (strcmp($2->val_, "bufferpool") != 0 || strcmp($3->val_, "status") != 0) {
+      MinisqlParserSetError("unknown show statement, expected show bufferpool status");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeShowBufferPoolStatus, NULL);
+  }
+  ;
+
+sql_set_bufferpool_size:
+  SET IDENTIFIER IDENTIFIER EQ NUMBER {
+    if (strcmp($2->val_, "bufferpool") != 0 || strcmp($3->val_, "size") != 0) {
+      MinisqlParserSetError("unknown set statement, expected set bufferpool size = <frames>");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeSetBufferPoolSize, NULL);
+    SyntaxNodeAddChildren($$, $5);
+  }
+  ;
+
+sql_set_durability:
+  SET IDENTIFIER EQ IDENTIFIER {
+    if (strcmp($2->val_, "durability") != 0) {
+      MinisqlParserSetError("unknown set statement, expected set durability = none | periodic | strict");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeSetDurability, NULL);
+    SyntaxNodeAddChildren($$, $4);
+  }
+  ;
+
+/* vacuum is not a keyword either */
+sql_vacuum:
+  IDENTIFIER IDENTIFIER {
+    if (strcmp($1->val_, "vacuum") != 0) {
+      MinisqlParserSetError("unknown statement, expected vacuum file | vacuum <table>");
+      YYABORT;
+    }
+    if (strcmp($2->val_, "file") == 0) {
+      $$ = CreateSyntaxNode(kNodeVacuumFile, NULL);
+    } else {
+      $$ = CreateSyntaxNode(kNodeVacuumTable, NULL);
+      SyntaxNodeAddChildren($$, $2);
+    }
+  }
+  ;
+
+sql_set_autovacuum:
+  SET IDENTIFIER EQ NUMBER {
+    if (strcmp($2->val_, "autovacuum") != 0) {
+      MinisqlParserSetError("unknown set statement, expected set autovacuum = <seconds>");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeSetAutoVacuum, NULL);
+    SyntaxNodeAddChildren($$, $4);
+  }
+  ;
+
+sql_load_data:
+  IDENTIFIER IDENTIFIER IDENTIFIER STRING INTO TABLE IDENTIFIER {
+    if (strcmp($1->val_, "load") != 0 || strcmp($2->val_, "data") != 0 || strcmp($3->val_, "infile") != 0) {
+      MinisqlParserSetError("unknown statement, expected load data infile \"<file>\" into table <table>");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeLoadData, NULL);
+    SyntaxNodeAddChildren($$, $4);
+    SyntaxNodeAddChildren($$, $7);
+  }
+  | IDENTIFIER IDENTIFIER FROM STRING {
+    if (strcmp($1->val_, "copy") != 0) {
+      MinisqlParserSetError("unknown statement, expected copy <table> from \"<file>\"");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeLoadData, NULL);
+    SyntaxNodeAddChildren($$, $4);
+    SyntaxNodeAddChildren($$, $2);
+  }
+  ;
+
 %%
 int yyerror(char* error) {
 	MinisqlParserSetError(error);
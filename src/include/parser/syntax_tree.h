@@ -43,7 +43,14 @@ typedef enum {
   kNodeIndexType,            /** type of index */
   kNodeTrxBegin,             /** begin recovery command */
   kNodeTrxCommit,            /** commit recovery command */
-  kNodeTrxRollback           /** rollback recovery command */
+  kNodeTrxRollback,          /** rollback recovery command */
+  kNodeShowBufferPoolStatus, /** show bufferpool status command */
+  kNodeSetBufferPoolSize,    /** set bufferpool size command */
+  kNodeSetDurability,        /** set durability command */
+  kNodeVacuumFile,           /** vacuum file command */
+  kNodeVacuumTable,          /** vacuum table command */
+  kNodeSetAutoVacuum,        /** set autovacuum command */
+  kNodeLoadData              /** load data infile / copy from command */
 } SyntaxNodeType;
 
 /**
@@ -4,6 +4,7 @@
 #ifndef MINISQL_SYNTAX_TREE_PRINTER_H
 #define MINISQL_SYNTAX_TREE_PRINTER_H
 
+#include <fstream>
 #include <iostream>
 #include <string>
 
@@ -2,15 +2,22 @@
 #define DISK_MGR_H
 
 #include <atomic>
-#include <fstream>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "common/macros.h"
 #include "page/bitmap_page.h"
 #include "page/disk_file_meta_page.h"
+#include "storage/page_io_queue.h"
 
 /**
  * DiskManager takes care of the allocation and de allocation of pages within a database. It performs the reading and
@@ -19,10 +26,62 @@
  * Disk page storage format: (Free Page BitMap Size = PAGE_SIZE * 8, we note it as N)
  * | Meta Page | Free Page BitMap 1 | Page 1 | Page 2 | ....
  *      | Page N | Free Page BitMap 2 | Page N+1 | ... | Page 2N | ... |
+ *
+ * Pages are transferred with positioned pread/pwrite, so page reads and writes of different pages run in parallel; only
+ * page allocation, which updates the meta page and the bitmap pages, is serialized by db_io_latch_. The file size is
+ * tracked in memory.
+ *
+ * The bitmap pages are cached in memory once touched and written back lazily, on Sync and on Close, together with the
+ * meta page. AllocatePage skips full extents by the used page counters of the meta page and remembers the first extent
+ * that may have a free page, so allocation does no I/O and does not rescan the extents in front of it.
+ *
+ * Pages of a segment (a table heap or an index, see segment_id_t) are handed out of runs of SEGMENT_RUN_PAGES
+ * contiguous pages reserved for the segment, so that the pages of tables and indexes growing at the same time are not
+ * interleaved on disk. A new run continues right after the previous one of the segment if those pages are free. The
+ * unused rest of the runs counts as allocated until the segment is released or the disk manager is closed, so a
+ * process that dies without closing leaks at most one partial run per segment.
+ *
+ * Writes only reach the OS page cache. When they become durable is up to the durability mode: never explicitly (NONE),
+ * every sync interval from a background thread as long as something was written since the last sync (PERIODIC), or
+ * at every Checkpoint (STRICT, the storage engine checkpoints after each statement that changed data).
+ *
+ * The file is grown FILE_PREALLOCATE_PAGES at a time with fallocate, ahead of the writes past its end, so that the
+ * file system can lay it out in large contiguous extents. The preallocated space is kept beyond the end of the file
+ * (FALLOC_FL_KEEP_SIZE), the file size still only covers the pages written. The other way round, runs of at least
+ * HOLE_PUNCH_MIN_PAGES free pages in the extents that had pages freed give their disk space back at the next write
+ * back of the bitmaps, by punching holes into the file. Vacuum does this for the whole file and also cuts off the free
+ * pages at its end.
+ *
+ * Besides the blocking calls, batches of page transfers can be kept in flight through a PageIOQueue, see CreateIOQueue.
+ *
+ * In direct I/O mode pages are transferred with O_DIRECT, bypassing the OS page cache, so that a page is not cached
+ * both by the buffer pool and by the kernel. Buffers that are not PAGE_SIZE aligned go through a bounce buffer.
+ *
+ * In compressed mode pages are compressed with PageCompressor and stored in slots of whole SLOT_UNIT_SIZE units in a
+ * hidden slot file next to the db file, see GetSlotFileName, so that reads and writes move only the compressed bytes.
+ * The page map from logical page id to (slot offset, slot size, stored length) takes the place of the data pages in
+ * the db file: map block k, with the entries of pages [k * PAGE_MAP_BLOCK_SIZE, (k + 1) * PAGE_MAP_BLOCK_SIZE), is
+ * physical page MapPageId(k). The map is written back lazily like the bitmap pages. A page keeps its slot as long as
+ * it fits in it. A slot that is left or freed is reused for pages of the same slot size only after FlushPageMap has
+ * synced the map blocks that no longer point to it, so that the map on disk never points to another page's data after
+ * a crash. Whether a db file is compressed is decided
+ * when it is created and kept for its lifetime. Compressed mode does not support direct I/O.
+ *
+ * In read-only mode an existing db file is opened O_RDONLY and, unless it is compressed, mapped into memory with
+ * PROT_READ, so that the buffer pool can hand out the mapped pages themselves instead of copies, see GetPageView. Page
+ * allocation and writes are refused with an error, nothing is written back on Close.
  */
 class DiskManager {
  public:
-  explicit DiskManager(const std::string &db_file);
+  /**
+   * @param direct_io open the file with O_DIRECT, ignored (with a warning) if the file system does not support it
+   * @param compress create a new db file in compressed mode, an existing file keeps the mode it was created with
+   * @param read_only open an existing db file read-only, direct_io, durability and compress are ignored
+   */
+  explicit DiskManager(const std::string &db_file, bool direct_io = DEFAULT_DIRECT_IO,
+                       DurabilityMode durability = DurabilityMode::NONE,
+                       std::chrono::milliseconds sync_interval = std::chrono::milliseconds(DEFAULT_SYNC_INTERVAL_MS),
+                       bool compress = DEFAULT_PAGE_COMPRESSION, bool read_only = false);
 
   ~DiskManager() {
     if (!closed) {
@@ -42,11 +101,40 @@ class DiskManager {
    */
   void WritePage(page_id_t logical_page_id, const char *page_data);
 
+  /**
+   * Write a batch of pages in physical order. Runs of physically adjacent pages are written with one pwritev each,
+   * the pages are not synced, see Sync.
+   * @param pages (logical page id, page data) pairs, in any order
+   */
+  void WritePages(std::vector<std::pair<page_id_t, const char *>> pages);
+
+  /** Write back the cached bitmap pages and the meta page, then make every page written so far durable. */
+  void Sync();
+
+  /**
+   * A point at which every page written so far should be durable according to the durability mode. The cached bitmap
+   * pages and the meta page are always written back, the file is synced unless the mode is NONE.
+   */
+  void Checkpoint();
+
+  /** Switch the durability mode, starting or stopping the background sync thread as needed. */
+  void SetDurability(DurabilityMode mode,
+                     std::chrono::milliseconds sync_interval = std::chrono::milliseconds(DEFAULT_SYNC_INTERVAL_MS));
+
+  inline DurabilityMode GetDurability() const { return durability_.load(std::memory_order_relaxed); }
+
+  /** @return true if pages were written since the last sync */
+  inline bool HasUnsyncedWrites() const { return unsynced_.load(std::memory_order_relaxed); }
+
   /**
    * Get next free page from disk
+   * @param segment the segment the page belongs to, INVALID_SEGMENT_ID for a lone page which takes the lowest free page
    * @return logical page id of allocated page
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(segment_id_t segment = INVALID_SEGMENT_ID);
+
+  /** Give back the pages reserved for a segment that were not allocated yet, when the segment is dropped. */
+  void ReleaseSegment(segment_id_t segment);
 
   /**
    * Free this page and reset bit map
@@ -69,18 +157,94 @@ class DiskManager {
    */
   char *GetMetaData() { return meta_data_; }
 
+  /**
+   * Create a queue for asynchronous batches of page transfers. The IO_URING backend falls back to the shared pool of
+   * I/O threads when the kernel does not support io_uring, see IOBackend.
+   * @param depth the number of transfers the queue keeps in flight
+   */
+  std::unique_ptr<PageIOQueue> CreateIOQueue(size_t depth = DEFAULT_IO_QUEUE_DEPTH,
+                                             IOBackend backend = DEFAULT_IO_BACKEND);
+
+  /** @return true if pages are transferred with O_DIRECT */
+  inline bool IsDirectIO() const { return direct_fd_ >= 0; }
+
+  /** @return true if pages are stored compressed */
+  inline bool IsCompressed() const { return slot_fd_ >= 0; }
+
+  /** @return the hidden file next to the db file that holds the pages in compressed mode */
+  static std::string GetSlotFileName(const std::string &db_file);
+
+  /** @return the bytes of data pages read from disk so far, compressed bytes in compressed mode */
+  inline uint64_t GetDataBytesRead() const { return data_bytes_read_.load(std::memory_order_relaxed); }
+
+  /** @return the bytes of data pages written to disk so far, compressed bytes in compressed mode */
+  inline uint64_t GetDataBytesWritten() const { return data_bytes_written_.load(std::memory_order_relaxed); }
+
+  /** @return the stored size of all the pages in compressed mode, 0 otherwise */
+  size_t GetCompressedSize();
+
+  /**
+   * Give the disk space of the free pages back: punch holes for all the runs of at least HOLE_PUNCH_MIN_PAGES free
+   * pages and truncate the file after its last allocated page, dropping the extents left empty. Pages are not moved.
+   * @return false if the file is read-only or compressed, where the free pages are not at fixed places of the db file
+   */
+  bool Vacuum();
+
+  /** @return the size of the db file */
+  inline size_t GetDbFileSize() const { return file_size_.load(std::memory_order_relaxed); }
+
+  /** @return the disk space taken by the db file, including preallocated space and excluding holes */
+  size_t GetDiskUsage();
+
+  /** @return true if the db file was opened read-only */
+  inline bool IsReadOnly() const { return read_only_; }
+
+  /** @return true if the db file is mapped into memory, see GetPageView */
+  inline bool IsMapped() const { return map_ != nullptr; }
+
+  /** @return the number of physical pages in the mapping, an upper bound of the logical page ids it holds */
+  inline size_t GetMappedPageCount() const { return map_size_ / PAGE_SIZE; }
+
+  /**
+   * @return the data of a page in the read-only mapping of the db file, nullptr if the file is not mapped or ends
+   * before the page. Writing to it faults.
+   */
+  const char *GetPageView(page_id_t logical_page_id);
+
+  /** Ask the kernel to read the mapped pages [first_page_id, first_page_id + count) ahead (MADV_WILLNEED). */
+  void AdviseWillNeed(page_id_t first_page_id, size_t count);
+
   static constexpr size_t BITMAP_SIZE = BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+  static constexpr size_t SLOT_UNIT_SIZE = 512;
+  static constexpr size_t MAX_SLOT_UNITS = PAGE_SIZE / SLOT_UNIT_SIZE;
+  static constexpr size_t PAGE_MAP_BLOCK_SIZE = PAGE_SIZE / sizeof(uint64_t);
 
  private:
+  friend class PageIOQueue;
+  friend class IoUringPageIOQueue;
+
   /**
    * Helper function to get disk file size
    */
-  int GetFileSize(const std::string &file_name);
+  static size_t GetFileSize(const std::string &file_name);
+
+  /** Raise the in-memory file size to size if the file has grown past it, preallocating the space ahead of it. */
+  void ExtendFileSize(size_t size);
+
+  /** Preallocate the file up to the chunk of FILE_PREALLOCATE_PAGES pages that size falls into. */
+  void Preallocate(size_t size);
+
+  /**
+   * Punch holes for the runs of at least HOLE_PUNCH_MIN_PAGES free pages of an extent. Caller holds db_io_latch_.
+   * @return the number of pages in the holes
+   */
+  uint32_t PunchFreeRuns(uint32_t extent_id);
 
   /**
    * Read physical page from disk
+   * @return the number of bytes read from the file, the rest of the page is zeroed
    */
-  void ReadPhysicalPage(page_id_t physical_page_id, char *page_data);
+  size_t ReadPhysicalPage(page_id_t physical_page_id, char *page_data);
 
   /**
    * Write data to physical page in disk
@@ -92,14 +256,116 @@ class DiskManager {
    */
   page_id_t MapPageId(page_id_t logical_page_id);
 
+  static inline page_id_t BitmapPhysicalPageId(uint32_t extent_id) { return extent_id * (BITMAP_SIZE + 1) + 1; }
+
+  /** @return the cached bitmap of an extent, read from disk on first use. Caller holds db_io_latch_. */
+  BitmapPage<PAGE_SIZE> *GetBitmap(uint32_t extent_id);
+
+  /** Pages reserved for a segment, [next_, end_) are not handed out yet. */
+  struct SegmentRun {
+    page_id_t next_{INVALID_PAGE_ID};
+    page_id_t end_{INVALID_PAGE_ID};
+  };
+
+  /** Reserve the next run of a segment and point run at it. Caller holds db_io_latch_. */
+  bool ReserveRun(SegmentRun *run);
+
+  /** Mark the unused rest of a run free again. Caller holds db_io_latch_. */
+  void ReleaseRun(SegmentRun *run);
+
+  /** Count count pages just allocated in the bitmap of an extent in the meta page. Caller holds db_io_latch_. */
+  void AddAllocated(uint32_t extent_id, uint32_t count);
+
+  /** Write the dirty cached bitmap pages and the meta page to disk. */
+  void FlushMetaData();
+
+  void RunPeriodicSync();
+
+  /** Load the page map of a compressed db file and find the free slots. */
+  void OpenPageMap();
+
+  /** @return the offset in slot units of a free slot of units units. Caller holds page_map_latch_. */
+  uint64_t AllocateSlot(uint32_t units);
+
+  void ReadCompressedPage(page_id_t logical_page_id, char *page_data);
+
+  void WriteCompressedPage(page_id_t logical_page_id, const char *page_data);
+
+  /** Free the slot of a page that is de-allocated. */
+  void FreePageSlot(page_id_t logical_page_id);
+
+  /** Write the dirty blocks of the page map to disk, then make the slots they stopped pointing to reusable. */
+  void FlushPageMap();
+
+  /**
+   * Find where an asynchronous transfer goes in the file.
+   * @return false if the request has to be done synchronously: a read past the end of the file, in direct I/O mode an
+   * unaligned buffer, in compressed mode any request
+   */
+  bool PrepareTransfer(const PageIORequest *request, int *fd, off_t *offset);
+
+  /** Account for an asynchronous transfer that completed in full. */
+  void FinishTransfer(const PageIORequest *request);
+
+  /** @return the pool of the THREAD_POOL backend, started on first use */
+  IOThreadPool *GetIOThreadPool();
+
+  void StopPeriodicSync();
+
  private:
-  // stream to write db file
-  std::fstream db_io_;
   std::string file_name_;
-  // with multiple buffer pool instances, need to protect file access
+  bool read_only_;
+  // read-only mapping of the whole db file, nullptr unless in read-only mode
+  char *map_{nullptr};
+  size_t map_size_{0};
+  // protects the meta page and the bitmap pages, page transfers do not take it
   std::recursive_mutex db_io_latch_;
   bool closed{false};
   char meta_data_[PAGE_SIZE];
+  // cached bitmap pages indexed by extent id, nullptr until first used
+  std::vector<std::unique_ptr<char[]>> bitmaps_;
+  std::vector<bool> bitmap_dirty_;
+  // pages of the extent were freed since the bitmap was last written back
+  std::vector<bool> bitmap_freed_;
+  // every extent in front of it is full
+  uint32_t next_free_extent_{0};
+  // the current run of each segment
+  std::unordered_map<segment_id_t, SegmentRun> segment_runs_;
+  bool meta_dirty_{true};
+  // descriptor of the db file
+  int fd_{-1};
+  // descriptor of the slot file, -1 unless in compressed mode
+  int slot_fd_{-1};
+  // page map of compressed mode and the free slots by size, page_map_latch_ protects them and the end of the slot file
+  std::mutex page_map_latch_;
+  std::vector<uint64_t> page_map_;
+  std::vector<bool> page_map_dirty_;
+  std::vector<uint64_t> free_slots_[MAX_SLOT_UNITS + 1];
+  std::vector<uint64_t> pending_free_slots_;  // page map entries of left slots, free once the map is on disk
+  uint64_t slot_file_units_{0};
+  std::atomic<uint64_t> data_bytes_read_{0};
+  std::atomic<uint64_t> data_bytes_written_{0};
+  // O_DIRECT descriptor of the db file, -1 unless in direct I/O mode
+  int direct_fd_{-1};
+  // size of the db file, kept in memory instead of asking the file system on every read
+  std::atomic<size_t> file_size_{0};
+  // the file is preallocated up to here, preallocate_latch_ serializes growing it
+  std::atomic<size_t> preallocated_size_{0};
+  std::mutex preallocate_latch_;
+  bool preallocate_unsupported_{false};
+  bool punch_unsupported_{false};
+  // pages were written since the last fdatasync
+  std::atomic<bool> unsynced_{false};
+  std::atomic<DurabilityMode> durability_{DurabilityMode::NONE};
+  // background sync thread of PERIODIC mode, sync_latch_ protects the fields below and the thread handle
+  std::mutex sync_latch_;
+  std::condition_variable sync_cv_;
+  std::thread sync_thread_;
+  std::chrono::milliseconds sync_interval_{DEFAULT_SYNC_INTERVAL_MS};
+  bool sync_stop_{false};
+  std::mutex io_pool_latch_;
+  std::unique_ptr<IOThreadPool> io_pool_;
+  std::atomic<bool> io_uring_unsupported_{false};
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef MINISQL_FREE_SPACE_MAP_H
+#define MINISQL_FREE_SPACE_MAP_H
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "page/free_space_map_page.h"
+
+/**
+ * FreeSpaceMap records how much room each page of a table heap has left, one byte per page counting CATEGORY_SIZE
+ * bytes, so that an insert can go straight to a page with enough room instead of walking the heap page chain. It also
+ * keeps the tail of the chain, where new heap pages are linked.
+ *
+ * The map lives in a chain of FreeSpaceMapPage pages whose first page id is kept in the TableMetadata, and is read
+ * into memory on first use. Entries are hints: a page is only recorded when an insert finds it full, when it gets
+ * space back from a delete, or when the map is built, so an entry may promise more room than the page has left. The
+ * insert that finds out records the real free space, so a wrong entry is tried at most once.
+ */
+class FreeSpaceMap {
+ public:
+  /**
+   * Create an empty map for a heap of a single page.
+   * @return the first page id of the map, INVALID_PAGE_ID if no page could be allocated
+   */
+  static page_id_t Create(BufferPoolManager *buffer_pool_manager, page_id_t last_heap_page_id);
+
+  /**
+   * Create the map of an existing heap by walking its page chain, for heaps written before the map existed.
+   * @return the first page id of the map, INVALID_PAGE_ID if no page could be allocated
+   */
+  static page_id_t Build(BufferPoolManager *buffer_pool_manager, page_id_t first_heap_page_id);
+
+  FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id)
+      : buffer_pool_manager_(buffer_pool_manager), first_page_id_(first_page_id) {}
+
+  /**
+   * @param size bytes needed in the page, slot included
+   * @return the first recorded heap page that should have size bytes free, INVALID_PAGE_ID if there is none
+   */
+  page_id_t FindPage(uint32_t size);
+
+  /**
+   * Record the free space of a heap page, adding the page to the map if it is not there yet.
+   */
+  void Update(page_id_t heap_page_id, uint32_t free_space);
+
+  /**
+   * Drop a heap page that was freed from the map.
+   */
+  void Remove(page_id_t heap_page_id);
+
+  /**
+   * @return the tail of the heap page chain, INVALID_PAGE_ID if the map could not be read
+   */
+  page_id_t GetLastHeapPageId();
+
+  void SetLastHeapPageId(page_id_t heap_page_id);
+
+  /**
+   * Delete the pages of the map.
+   */
+  void Destroy();
+
+  inline page_id_t GetFirstPageId() const { return first_page_id_; }
+
+  static uint8_t ToCategory(uint32_t free_space) {
+    return static_cast<uint8_t>(std::min<uint32_t>(free_space / CATEGORY_SIZE, UINT8_MAX));
+  }
+
+  static constexpr uint32_t CATEGORY_SIZE = PAGE_SIZE / 256;
+
+ private:
+  /**
+   * Read the map into memory on first use.
+   * @return false if a page of the map could not be fetched, the next call tries again
+   */
+  bool Load();
+
+  void RecomputeMaxCategory(uint32_t map_index);
+
+  void SetEntry(uint32_t position, page_id_t heap_page_id, uint8_t category);
+
+ private:
+  BufferPoolManager *buffer_pool_manager_;
+  page_id_t first_page_id_;
+  std::mutex latch_;
+  bool loaded_{false};
+  page_id_t last_heap_page_id_{INVALID_PAGE_ID};
+  std::vector<page_id_t> map_page_ids_;
+  std::vector<uint8_t> max_categories_;  // 每个空闲空间表页中最大的 category，查找时整页跳过
+  std::vector<page_id_t> heap_page_ids_;
+  std::vector<uint8_t> categories_;
+  std::unordered_map<page_id_t, uint32_t> positions_;
+  std::vector<uint32_t> free_positions_;  // 已释放堆页留下的空位
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_H
@@ -0,0 +1,40 @@
+#ifndef MINISQL_PAGE_COMPRESSOR_H
+#define MINISQL_PAGE_COMPRESSOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * PageCompressor is a small LZ77 codec in the style of LZ4, meant for single pages: no framing, no checksum, no
+ * dictionary across pages. The compressed data is a list of sequences, each made of
+ *
+ * | token | literal length bytes | literals | match offset (2 bytes) | match length bytes |
+ *
+ * where the high nibble of the token is the literal count and the low nibble the match length minus MIN_MATCH, a nibble
+ * of 15 continuing in the following bytes (255 means another byte follows). The last sequence has literals only. The
+ * input must be shorter than 64 KB, so that match offsets fit in 2 bytes.
+ *
+ * The compressor finds matches with a hash table of 4-byte sequences, so it is fast on the zero runs and repeated
+ * field values that table and index pages are full of, and gives up on data that does not compress.
+ */
+class PageCompressor {
+ public:
+  /**
+   * @param dst_capacity bytes available in dst, compression fails when the output would not fit
+   * @return the compressed size, 0 if the data does not compress into dst_capacity bytes
+   */
+  static size_t Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity);
+
+  /**
+   * @return true if src is well formed and decompresses to exactly dst_size bytes
+   */
+  static bool Decompress(const char *src, size_t src_size, char *dst, size_t dst_size);
+
+  static constexpr size_t MIN_MATCH = 4;
+  static constexpr size_t MAX_INPUT_SIZE = 65535;
+
+ private:
+  static constexpr int HASH_BITS = 12;
+};
+
+#endif  // MINISQL_PAGE_COMPRESSOR_H
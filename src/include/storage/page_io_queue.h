@@ -0,0 +1,98 @@
+#ifndef MINISQL_PAGE_IO_QUEUE_H
+#define MINISQL_PAGE_IO_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+class DiskManager;
+
+/** One page transfer of an asynchronous batch. */
+struct PageIORequest {
+  enum Type : uint8_t { READ, WRITE };
+
+  Type type_{READ};
+  page_id_t page_id_{INVALID_PAGE_ID};  // logical page id
+  char *data_{nullptr};                 // PAGE_SIZE bytes read into or written from, valid until the request is reaped
+  void *user_data_{nullptr};            // not used by the queue
+};
+
+/**
+ * PageIOQueue keeps batches of page transfers in flight without blocking the thread that submits them. Requests are
+ * submitted in batches and reaped as they complete, in any order. A queue belongs to one thread at a time, threads
+ * that transfer pages concurrently use a queue each. Reads past the end of the file, short transfers and, in direct
+ * I/O mode, unaligned buffers are handled like by DiskManager::ReadPage and WritePage; errors are logged the same way.
+ *
+ * Queues are created by DiskManager::CreateIOQueue, which uses Create. A destroyed queue waits for its requests in
+ * flight.
+ */
+class PageIOQueue {
+ public:
+  /**
+   * Create a queue of the backend, or of its fallback when the kernel does not support io_uring, see IOBackend.
+   * @param depth the number of transfers the queue keeps in flight
+   */
+  static std::unique_ptr<PageIOQueue> Create(DiskManager *disk_manager, size_t depth, IOBackend backend);
+
+  virtual ~PageIOQueue() = default;
+
+  DISALLOW_COPY(PageIOQueue);
+
+  /** Start the transfers of requests. More than GetDepth requests in flight make Submit wait for some of them. */
+  virtual void Submit(const std::vector<PageIORequest *> &requests) = 0;
+
+  /**
+   * Wait until at least min_complete requests, or every request in flight if fewer, are done, and append all the
+   * done requests to completed.
+   * @return the number of requests appended
+   */
+  virtual size_t Reap(std::vector<PageIORequest *> *completed, size_t min_complete) = 0;
+
+  /** @return the number of submitted requests that have not been reaped yet */
+  inline size_t InFlight() const { return in_flight_; }
+
+  /** @return the number of requests the queue is meant to keep in flight */
+  inline size_t GetDepth() const { return depth_; }
+
+  /** @return the backend actually used, which may be a fallback of the requested one */
+  virtual IOBackend GetBackend() const = 0;
+
+ protected:
+  explicit PageIOQueue(size_t depth) : depth_(depth) {}
+
+  size_t depth_;
+  size_t in_flight_{0};
+};
+
+/**
+ * A fixed set of threads running blocking page transfers for the THREAD_POOL backend, shared by all the queues of a
+ * disk manager. Tasks still queued when the pool is destroyed are run before the threads exit.
+ */
+class IOThreadPool {
+ public:
+  explicit IOThreadPool(size_t num_threads);
+
+  ~IOThreadPool();
+
+  DISALLOW_COPY(IOThreadPool);
+
+  void Post(std::function<void()> task);
+
+ private:
+  void Run();
+
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  std::vector<std::thread> threads_;
+  bool stop_{false};
+};
+
+#endif  // MINISQL_PAGE_IO_QUEUE_H
@@ -1,25 +1,74 @@
 #ifndef MINISQL_TABLE_HEAP_H
 #define MINISQL_TABLE_HEAP_H
 
+#include <atomic>
+#include <functional>
+#include <memory>
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
 #include "page/header_page.h"
 #include "page/table_page.h"
 #include "recovery/log_manager.h"
+#include "storage/free_space_map.h"
 #include "storage/table_iterator.h"
 
 class TableHeap {
   friend class TableIterator;
 
  public:
+  /** What a vacuum did to the heap. */
+  struct VacuumStats {
+    uint32_t applied_deletes{0};
+    uint32_t moved_tuples{0};
+    uint32_t freed_pages{0};
+  };
+
+  /** Called for every tuple a vacuum moves, with the row at its new row id and the old row id. */
+  using RelocateCallback = std::function<void(Row &row, const RowId &old_rid)>;
+
+  /**
+   * Appends tuples at the tail of a heap for a bulk load. The page being filled stays pinned from one append to the
+   * next and is only latched while a tuple goes in, so a load fetches every page once instead of once per tuple. Full
+   * pages are recorded in the free space map as they are left behind, the last one when the appender finishes.
+   */
+  class Appender {
+   public:
+    Appender(TableHeap *table_heap, Txn *txn) : table_heap_(table_heap), txn_(txn) {}
+
+    ~Appender() { Finish(); }
+
+    /**
+     * @param[in/out] row Tuple Row to append, the rid of the appended tuple is wrapped in object row
+     * @return false if the tuple is too large or no page could be allocated
+     */
+    bool Append(Row &row);
+
+    /**
+     * Unpin the page being filled. Appending again afterwards starts over from the tail of the heap.
+     */
+    void Finish();
+
+   private:
+    TableHeap *table_heap_;
+    Txn *txn_;
+    TablePage *page_{nullptr};
+    bool dirty_{false};
+  };
+
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, Schema *schema, Txn *txn, LogManager *log_manager,
                            LockManager *lock_manager) {
     return new TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager);
   }
 
+  /**
+   * Open an existing heap. A heap without a free space map gets one built on its first insert.
+   */
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                           LogManager *log_manager, LockManager *lock_manager) {
-    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager);
+                           LogManager *log_manager, LockManager *lock_manager,
+                           page_id_t free_space_map_page_id = INVALID_PAGE_ID) {
+    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager,
+                         free_space_map_page_id);
   }
 
   ~TableHeap() {}
@@ -81,6 +130,10 @@ class TableHeap {
       buffer_pool_manager_->UnpinPage(old_page_id, false);
       buffer_pool_manager_->DeletePage(old_page_id);
     }
+    buffer_pool_manager_->ReleaseSegment(TableHeapSegmentId(first_page_id_));
+    if (free_space_map_ != nullptr) {
+      free_space_map_->Destroy();
+    }
   }
 
   /**
@@ -88,6 +141,18 @@ class TableHeap {
    */
   void DeleteTable(page_id_t page_id = INVALID_PAGE_ID);
 
+  /**
+   * Reclaim the space of deleted tuples: apply the deletes still pending, pack every page, move the tuples of a page
+   * filled below merge_fill into the page before it when they all fit there, and unlink and free the pages left empty.
+   * The first page always stays. Moved tuples get new row ids, relocate is told about each of them.
+   */
+  VacuumStats Vacuum(double merge_fill, const RelocateCallback &relocate, Txn *txn);
+
+  /**
+   * @return an estimate of the tuples marked deleted since the last vacuum
+   */
+  inline uint32_t GetDeadTupleCount() const { return dead_tuples_; }
+
   /**
    * @return the begin iterator of this table
    */
@@ -103,6 +168,13 @@ class TableHeap {
    */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /**
+   * @return the first page id of the free space map of this table, INVALID_PAGE_ID if it has none yet
+   */
+  inline page_id_t GetFreeSpaceMapPageId() const {
+    return free_space_map_ == nullptr ? INVALID_PAGE_ID : free_space_map_->GetFirstPageId();
+  }
+
  private:
   /**
    * create table heap and initialize first page
@@ -117,32 +189,42 @@ class TableHeap {
     last_page_id = INVALID_PAGE_ID;
     auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager->NewPage(first_page_id_));
     if (first_page != nullptr) {
-    first_page->Init(first_page_id_, INVALID_PAGE_ID, log_manager, txn);
-    buffer_pool_manager->UnpinPage(first_page_id_, true);
-    last_page_id = first_page_id_;  
-  }
-    first_page->Init(first_page_id_, PAGE_SIZE, log_manager, txn);
-    buffer_pool_manager->UnpinPage(first_page_id_, true);
-    schema_ = schema;
+      first_page->Init(first_page_id_, INVALID_PAGE_ID, log_manager, txn);
+      buffer_pool_manager->UnpinPage(first_page_id_, true);
+      last_page_id = first_page_id_;
+      free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager,
+                                                       FreeSpaceMap::Create(buffer_pool_manager, first_page_id_));
+    }
   };
 
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                     LogManager *log_manager, LockManager *lock_manager)
+                     LogManager *log_manager, LockManager *lock_manager, page_id_t free_space_map_page_id)
       : buffer_pool_manager_(buffer_pool_manager),
         first_page_id_(first_page_id),
-        last_page_id(first_page_id),
+        last_page_id(INVALID_PAGE_ID),
         schema_(schema),
         log_manager_(log_manager),
-        lock_manager_(lock_manager) {}
+        lock_manager_(lock_manager) {
+    if (free_space_map_page_id != INVALID_PAGE_ID) {
+      free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager, free_space_map_page_id);
+    }
+  }
+
+  /**
+   * @return the free space map, built from the page chain if the heap has none, nullptr if it can not be built
+   */
+  FreeSpaceMap *GetFreeSpaceMap();
 
  private:
   BufferPoolManager *buffer_pool_manager_;
   page_id_t first_page_id_;
-  page_id_t last_page_id;
+  page_id_t last_page_id;  // 上次插入的页，下次插入先试它
   uint32_t total_page{0};
   Schema *schema_;
   [[maybe_unused]] LogManager *log_manager_;
   [[maybe_unused]] LockManager *lock_manager_;
+  std::unique_ptr<FreeSpaceMap> free_space_map_;
+  std::atomic<uint32_t> dead_tuples_{0};
 };
 
 #endif  // MINISQL_TABLE_HEAP_H
\ No newline at end of file
@@ -23,8 +23,8 @@ BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager
   if(!index_root_page->GetRootId(index_id, &root_page_id_)) {
     root_page_id_ = INVALID_PAGE_ID;
   }
-  buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
-  buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, false);
+  buffer_pool_manager_->UnpinPage(root_page_id_, false);
 }
 /*
  * If current_page_id = INVALID_PAGE_ID, then
@@ -34,7 +34,8 @@ BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager
 void BPlusTree::Destroy(page_id_t current_page_id) {
 //  LOG(INFO) << "Destroy page! " << current_page_id;
   if(IsEmpty()) return;
-  if(current_page_id == INVALID_PAGE_ID) {
+  bool whole_tree = current_page_id == INVALID_PAGE_ID;
+  if(whole_tree) {
     current_page_id = root_page_id_;
     root_page_id_ = INVALID_PAGE_ID;
     UpdateRootPageId(2);
@@ -48,6 +49,9 @@ void BPlusTree::Destroy(page_id_t current_page_id) {
   }
   buffer_pool_manager_->DeletePage(page->GetPageId());
   buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  if(whole_tree) {
+    buffer_pool_manager_->ReleaseSegment(IndexSegmentId(index_id_));
+  }
 }
 
 /*
@@ -108,7 +112,7 @@ bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction) {
  * tree's root page id and insert entry directly into leaf page.
  */
 void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
-  auto * page = buffer_pool_manager_->NewPage(root_page_id_);
+  auto * page = buffer_pool_manager_->NewPage(root_page_id_, IndexSegmentId(index_id_));
   if(page == nullptr) {
 //    LOG(ERROR) << "out of memory" << std::endl;
   }
@@ -161,12 +165,12 @@ bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transac
  */
 BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Txn *transaction) {
   page_id_t new_page_id;
-  auto *page = buffer_pool_manager_->NewPage(new_page_id);
+  auto *page = buffer_pool_manager_->NewPage(new_page_id, IndexSegmentId(index_id_));
   if(page == nullptr) {
 //    LOG(ERROR) << "out of memory" << std::endl;
     return nullptr;
   }
-  BPlusTreeInternalPage *new_page = reinterpret_cast<InternalPage *>(page);
+  BPlusTreeInternalPage *new_page = reinterpret_cast<InternalPage *>(page->GetData());
   new_page->Init(new_page_id, node->GetParentPageId(), node->GetKeySize(), node->GetMaxSize());
   node->MoveHalfTo(new_page, buffer_pool_manager_);
   return new_page;
@@ -174,12 +178,12 @@ BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Txn *transaction) {
 
 BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) {
   page_id_t new_page_id;
-  auto *page = buffer_pool_manager_->NewPage(new_page_id);
+  auto *page = buffer_pool_manager_->NewPage(new_page_id, IndexSegmentId(index_id_));
   if(page == nullptr) {
 //    LOG(ERROR) << "out of memory" << std::endl;
     return nullptr;
   }
-  BPlusTreeLeafPage *new_page = reinterpret_cast<LeafPage *>(page);
+  BPlusTreeLeafPage *new_page = reinterpret_cast<LeafPage *>(page->GetData());
   new_page->Init(new_page_id, node->GetParentPageId(), node->GetKeySize(),node->GetMaxSize());
   node->MoveHalfTo(new_page);
   return new_page;
@@ -197,7 +201,7 @@ BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) {
 void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node,
                                  Txn *transaction) {
   if(old_node->IsRootPage()) {
-    auto *page = buffer_pool_manager_->NewPage(root_page_id_);
+    auto *page = buffer_pool_manager_->NewPage(root_page_id_, IndexSegmentId(index_id_));
     if(page == nullptr) {
 //      LOG(ERROR) << "Out of memory." << std::endl;
     }
@@ -459,17 +463,18 @@ IndexIterator BPlusTree::End() {
  */
 Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
    if(page_id == INVALID_PAGE_ID) page_id = root_page_id_;
-  auto * page = reinterpret_cast<BPlusTreePage *>
-      (buffer_pool_manager_->FetchPage(page_id)->GetData());
+  Page *raw_page = buffer_pool_manager_->FetchPage(page_id);
+  auto * page = reinterpret_cast<BPlusTreePage *>(raw_page->GetData());
   while(!page->IsLeafPage()) {
     auto inner = reinterpret_cast<InternalPage *>(page);
     page_id_t child_id = leftMost ? inner->ValueAt(0) : inner->Lookup(key, processor_);
-    auto child_page = reinterpret_cast<BPlusTreePage *>
-        (buffer_pool_manager_->FetchPage(child_id)->GetData());
+    Page *raw_child = buffer_pool_manager_->FetchPage(child_id);
     buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-    page = child_page;
+    raw_page = raw_child;
+    page = reinterpret_cast<BPlusTreePage *>(raw_page->GetData());
   }
-  return reinterpret_cast<Page *>(page);
+  // Page data lives in the frame arena, return the frame itself rather than a cast of its data.
+  return raw_page;
 }
 
 /*
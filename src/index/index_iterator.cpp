@@ -8,6 +8,7 @@ IndexIterator::IndexIterator() = default;
 IndexIterator::IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index)
     : current_page_id(page_id), item_index(index), buffer_pool_manager(bpm) {
   page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
+  buffer_pool_manager->ReadAhead(page->GetNextPageId(), LeafPage::ReadNextPageId);
 }
 
 IndexIterator::~IndexIterator() {
@@ -36,6 +37,7 @@ IndexIterator &IndexIterator::operator++() {
 //    LOG(INFO) << "before : ";
     buffer_pool_manager->UnpinPage(page->GetPageId(), false);
     page = next_page;
+    buffer_pool_manager->ReadAhead(page->GetNextPageId(), LeafPage::ReadNextPageId);
 //    LOG(INFO) << "after : ";
     item_index = 0;
   } if(item_index == page->GetSize()) {
@@ -38,6 +38,10 @@ page_id_t LeafPage::GetNextPageId() const {
   return next_page_id_;
 }
 
+page_id_t LeafPage::ReadNextPageId(const char *page_data) {
+  return reinterpret_cast<const LeafPage *>(page_data)->GetNextPageId();
+}
+
 void LeafPage::SetNextPageId(page_id_t next_page_id) {
   next_page_id_ = next_page_id;
   if (next_page_id == 0) {
@@ -1,5 +1,8 @@
 #include "page/bitmap_page.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "glog/logging.h"
 
 /**
@@ -7,45 +10,80 @@
  */
 template <size_t PageSize>
 bool BitmapPage<PageSize>::AllocatePage(uint32_t &page_offset) {
-    
   // 检查是否有空闲页
-    if (page_allocated_ >= GetMaxSupportedSize()) {
-        return false;
-    }
+  if (page_allocated_ >= GetMaxSupportedSize()) {
+    return false;
+  }
+  // next_free_page_之前的页都已分配，从它开始按64位字查找第一个空闲页
+  page_offset = FindNext(next_free_page_, false);
+  if (page_offset >= GetMaxSupportedSize()) {
+    LOG(ERROR) << "BitmapPage::AllocatePage: No free page found but page_allocated_ < GetMaxSupportedSize()";
+    return false;
+  }
+  SetRun(page_offset, 1);
+  next_free_page_ = page_offset + 1;
+  return true;
+}
 
-    // 从next_free_page_开始查找空闲页
-    uint32_t start_byte = next_free_page_ / 8;
-    uint8_t start_bit = next_free_page_ % 8;
-
-    // 先查找起始字节中剩余的位
-    for (uint8_t bit = start_bit; bit < 8; ++bit) {
-        if (IsPageFreeLow(start_byte, bit)) {
-            page_offset = start_byte * 8 + bit;
-            bytes[start_byte] |= (1 << bit);  // 标记为已分配
-            ++page_allocated_;
-            next_free_page_ = page_offset + 1;
-            return true;
-        }
+template <size_t PageSize>
+bool BitmapPage<PageSize>::AllocateRun(uint32_t count, uint32_t &page_offset) {
+  if (count == 0 || page_allocated_ + count > GetMaxSupportedSize()) {
+    return false;
+  }
+  // 依次跳过已分配的页和长度不够的空闲段
+  uint32_t free_begin = FindNext(next_free_page_, false);
+  while (free_begin + count <= GetMaxSupportedSize()) {
+    uint32_t free_end = FindNext(free_begin, true);
+    if (free_end - free_begin >= count) {
+      page_offset = free_begin;
+      SetRun(page_offset, count);
+      if (page_offset == next_free_page_) {
+        next_free_page_ = page_offset + count;
+      }
+      return true;
     }
+    free_begin = FindNext(free_end, false);
+  }
+  return false;
+}
 
-    // 查找后续字节
-    for (uint32_t byte = start_byte + 1; byte < MAX_CHARS; ++byte) {
-        if (bytes[byte] != 0xFF) {  // 如果字节不全为1，说明有空闲位
-            for (uint8_t bit = 0; bit < 8; ++bit) {
-                if (!(bytes[byte] & (1 << bit))) {
-                    page_offset = byte * 8 + bit;
-                    bytes[byte] |= (1 << bit);  // 标记为已分配
-                    ++page_allocated_;
-                    next_free_page_ = page_offset + 1;
-                    return true;
-                }
-            }
-        }
-    }
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::AllocateRunAt(uint32_t page_offset, uint32_t max_count) {
+  if (page_offset >= GetMaxSupportedSize() || !IsPageFree(page_offset)) {
+    return 0;
+  }
+  uint32_t count = std::min(FindNext(page_offset, true) - page_offset, max_count);
+  SetRun(page_offset, count);
+  if (page_offset == next_free_page_) {
+    next_free_page_ = page_offset + count;
+  }
+  return count;
+}
 
-    // 如果没有找到空闲页，这是不可能的情况，因为前面已经检查过page_allocated_
-    LOG(ERROR) << "BitmapPage::AllocatePage: No free page found but page_allocated_ < GetMaxSupportedSize()";
-    return false;
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::CountAllocated() const {
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < NUM_WORDS; i++) {
+    count += __builtin_popcountll(LoadWord(i));
+  }
+  return count;
+}
+
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::NextFreeRun(uint32_t &page_offset) const {
+  page_offset = FindNext(page_offset, false);
+  return FindNext(page_offset, true) - page_offset;
+}
+
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::GetAllocatedEnd() const {
+  for (uint32_t word_index = NUM_WORDS; word_index > 0; word_index--) {
+    uint64_t word = LoadWord(word_index - 1);
+    if (word != 0) {
+      return word_index * 64 - __builtin_clzll(word);
+    }
+  }
+  return 0;
 }
 
 /**
@@ -104,6 +142,56 @@ bool BitmapPage<PageSize>::IsPageFreeLow(uint32_t byte_index, uint8_t bit_index)
     return !(bytes[byte_index] & (1 << bit_index));
 }
 
+template <size_t PageSize>
+uint64_t BitmapPage<PageSize>::LoadWord(uint32_t word_index) const {
+  uint64_t word;
+  memcpy(&word, bytes + word_index * sizeof(uint64_t), sizeof(uint64_t));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  word = __builtin_bswap64(word);
+#endif
+  return word;
+}
+
+template <size_t PageSize>
+void BitmapPage<PageSize>::StoreWord(uint32_t word_index, uint64_t word) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  word = __builtin_bswap64(word);
+#endif
+  memcpy(bytes + word_index * sizeof(uint64_t), &word, sizeof(uint64_t));
+}
+
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::FindNext(uint32_t page_offset, bool allocated) const {
+  if (page_offset >= GetMaxSupportedSize()) {
+    return GetMaxSupportedSize();
+  }
+  uint32_t word_index = page_offset / 64;
+  // 空闲页找0位，取反后统一找1位，并屏蔽掉起始位之前的位
+  uint64_t word = allocated ? LoadWord(word_index) : ~LoadWord(word_index);
+  word &= ~uint64_t{0} << (page_offset % 64);
+  while (word == 0) {
+    if (++word_index == NUM_WORDS) {
+      return GetMaxSupportedSize();
+    }
+    word = allocated ? LoadWord(word_index) : ~LoadWord(word_index);
+  }
+  return word_index * 64 + __builtin_ctzll(word);
+}
+
+template <size_t PageSize>
+void BitmapPage<PageSize>::SetRun(uint32_t page_offset, uint32_t count) {
+  page_allocated_ += count;
+  while (count > 0) {
+    uint32_t word_index = page_offset / 64;
+    uint32_t bit_index = page_offset % 64;
+    uint32_t bits = std::min(count, 64 - bit_index);
+    uint64_t mask = (bits == 64 ? ~uint64_t{0} : (uint64_t{1} << bits) - 1) << bit_index;
+    StoreWord(word_index, LoadWord(word_index) | mask);
+    page_offset += bits;
+    count -= bits;
+  }
+}
+
 template class BitmapPage<64>;
 
 template class BitmapPage<128>;
@@ -0,0 +1,18 @@
+#include "page/free_space_map_page.h"
+
+void FreeSpaceMapPage::Init() {
+  version_ = VERSION;
+  next_page_id_ = INVALID_PAGE_ID;
+  count_ = 0;
+  last_heap_page_id_ = INVALID_PAGE_ID;
+}
+
+bool FreeSpaceMapPage::Append(page_id_t heap_page_id, uint8_t category) {
+  if (count_ >= MAX_ENTRY_COUNT) {
+    return false;
+  }
+  heap_page_ids_[count_] = heap_page_id;
+  categories_[count_] = category;
+  count_++;
+  return true;
+}
@@ -8,31 +8,91 @@ void TablePage::Init(page_id_t page_id, page_id_t prev_id, LogManager *log_mgr,
   SetNextPageId(INVALID_PAGE_ID);
   SetFreeSpacePointer(PAGE_SIZE);
   SetTupleCount(0);
+  MACH_WRITE_UINT32(GetData() + OFFSET_VERSION, FORMAT_VERSION);
+  SetFreeSlotHead(NO_FREE_SLOT);
+  SetFragmentedBytes(0);
+}
+
+bool TablePage::UpgradeFormat() {
+  if (IsCurrentFormat()) {
+    return true;
+  }
+  uint32_t header_size = GetHeaderSize();
+  if (GetContiguousFreeSpace() < SIZE_TABLE_PAGE_HEADER - header_size) {
+    return false;
+  }
+  bool has_free_slot_list = HasFreeSlotList();
+  uint32_t tuple_count = GetTupleCount();
+  memmove(GetData() + SIZE_TABLE_PAGE_HEADER, GetData() + header_size, SIZE_TUPLE * tuple_count);
+  MACH_WRITE_UINT32(GetData() + OFFSET_VERSION, FORMAT_VERSION);
+  SetFragmentedBytes(0);
+  if (has_free_slot_list) {
+    return true;
+  }
+  // Thread the empty slots into the list, lowest slot first.
+  uint32_t free_slot_head = NO_FREE_SLOT;
+  for (uint32_t i = tuple_count; i-- > 0;) {
+    if (GetTupleSize(i) == 0) {
+      SetTupleOffsetAtSlot(i, free_slot_head);
+      free_slot_head = i;
+    }
+  }
+  SetFreeSlotHead(free_slot_head);
+  return true;
+}
+
+void TablePage::Compact() {
+  if (GetFragmentedBytes() == 0) {
+    return;
+  }
+  // Copy the live tuples, the ones marked deleted included, against the end of a scratch page, then back at once.
+  char packed[PAGE_SIZE];
+  uint32_t free_space_pointer = PAGE_SIZE;
+  for (uint32_t i = 0; i < GetTupleCount(); i++) {
+    uint32_t tuple_size = UnsetDeletedFlag(GetTupleSize(i));
+    if (tuple_size == 0) {
+      continue;
+    }
+    free_space_pointer -= tuple_size;
+    memcpy(packed + free_space_pointer, GetData() + GetTupleOffsetAtSlot(i), tuple_size);
+    SetTupleOffsetAtSlot(i, free_space_pointer);
+  }
+  memcpy(GetData() + free_space_pointer, packed + free_space_pointer, PAGE_SIZE - free_space_pointer);
+  SetFreeSpacePointer(free_space_pointer);
+  SetFragmentedBytes(0);
 }
 
 bool TablePage::InsertTuple(Row &row, Schema *schema, Txn *txn, LockManager *lock_manager, LogManager *log_manager) {
   uint32_t serialized_size = row.GetSerializedSize(schema);
   ASSERT(serialized_size > 0, "Can not have empty row.");
-  if (GetFreeSpaceRemaining() < serialized_size + SIZE_TUPLE) {
-    return false;
-  }
+  UpgradeFormat();
   // Try to find a free slot to reuse.
   uint32_t i;
-  bool flag = false;
-  for (i = 0; i < GetTupleCount(); i++) {
-    // If the slot is empty, i.e. its tuple has size 0,
-    if (GetTupleSize(i) == 0) {
-      // Then we break out of the loop at index i.
-      flag = true;
-      break;
+  if (HasFreeSlotList()) {
+    i = GetFreeSlotHead() != NO_FREE_SLOT ? GetFreeSlotHead() : GetTupleCount();
+  } else {
+    // A page of the first format without room for the free slot list has to scan for an empty slot.
+    for (i = 0; i < GetTupleCount(); i++) {
+      if (GetTupleSize(i) == 0) {
+        break;
+      }
     }
   }
-  if (!flag) {
-    // Otherwise we claim available free space..
-    SetFreeSpacePointer(GetFreeSpacePointer() - serialized_size);
-    uint32_t __attribute__((unused)) write_bytes = row.SerializeTo(GetData() + GetFreeSpacePointer(), schema);
-    ASSERT(write_bytes == serialized_size, "Unexpected behavior in row serialize.");
+  // A new slot at index i takes room in the slot array too.
+  uint32_t needed = serialized_size + (i == GetTupleCount() ? SIZE_TUPLE : 0);
+  if (GetFreeSpaceRemaining() < needed) {
+    return false;
+  }
+  if (GetContiguousFreeSpace() < needed) {
+    Compact();
   }
+  if (HasFreeSlotList() && i != GetTupleCount()) {
+    SetFreeSlotHead(GetTupleOffsetAtSlot(i));
+  }
+  // Either way the tuple takes available free space.
+  SetFreeSpacePointer(GetFreeSpacePointer() - serialized_size);
+  uint32_t __attribute__((unused)) write_bytes = row.SerializeTo(GetData() + GetFreeSpacePointer(), schema);
+  ASSERT(write_bytes == serialized_size, "Unexpected behavior in row serialize.");
 
   // Set the tuple.
   SetTupleOffsetAtSlot(i, GetFreeSpacePointer());
@@ -82,6 +142,10 @@ int TablePage::UpdateTuple(Row &new_row, Row *old_row, Schema *schema, Txn *txn,
   if (GetFreeSpaceRemaining() + tuple_size < serialized_size) {
     return -2;
   }
+  // A larger tuple takes contiguous space, pack the page if the deleted bytes are needed.
+  if (GetContiguousFreeSpace() + tuple_size < serialized_size) {
+    Compact();
+  }
   // Copy out the old value.
   uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
   uint32_t __attribute__((unused)) read_bytes = old_row->DeserializeFrom(GetData() + tuple_offset, schema);
@@ -118,6 +182,20 @@ void TablePage::ApplyDelete(const RowId &rid, Txn *txn, LogManager *log_manager)
   uint32_t free_space_pointer = GetFreeSpacePointer();
   ASSERT(tuple_offset >= free_space_pointer, "Free space appears before tuples.");
 
+  if (IsCurrentFormat()) {
+    // Leave the tuple bytes where they are, the page is packed once the space is needed. The lowest tuple simply
+    // gives its bytes back to the free space.
+    if (tuple_offset == free_space_pointer) {
+      SetFreeSpacePointer(free_space_pointer + tuple_size);
+    } else {
+      SetFragmentedBytes(GetFragmentedBytes() + tuple_size);
+    }
+    SetTupleSize(slot_num, 0);
+    SetTupleOffsetAtSlot(slot_num, GetFreeSlotHead());
+    SetFreeSlotHead(slot_num);
+    return;
+  }
+
   memmove(GetData() + free_space_pointer + tuple_size, GetData() + free_space_pointer,
           tuple_offset - free_space_pointer);
   SetFreeSpacePointer(free_space_pointer + tuple_size);
@@ -131,6 +209,13 @@ void TablePage::ApplyDelete(const RowId &rid, Txn *txn, LogManager *log_manager)
       SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size);
     }
   }
+
+  // Put the slot on the free slot list, an older page gets the current format once there is room for it.
+  if (HasFreeSlotList()) {
+    SetTupleOffsetAtSlot(slot_num, GetFreeSlotHead());
+    SetFreeSlotHead(slot_num);
+  }
+  UpgradeFormat();
 }
 
 void TablePage::RollbackDelete(const RowId &rid, Txn *txn, LogManager *log_manager) {
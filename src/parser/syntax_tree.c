@@ -171,6 +171,20 @@ const char *GetSyntaxNodeTypeStr(SyntaxNodeType type) {
       return "kNodeTrxCommit";
     case kNodeTrxRollback:
       return "kNodeTrxRollback";
+    case kNodeShowBufferPoolStatus:
+      return "kNodeShowBufferPoolStatus";
+    case kNodeSetBufferPoolSize:
+      return "kNodeSetBufferPoolSize";
+    case kNodeSetDurability:
+      return "kNodeSetDurability";
+    case kNodeVacuumFile:
+      return "kNodeVacuumFile";
+    case kNodeVacuumTable:
+      return "kNodeVacuumTable";
+    case kNodeSetAutoVacuum:
+      return "kNodeSetAutoVacuum";
+    case kNodeLoadData:
+      return "kNodeLoadData";
     default:
       return "error type";
   }
@@ -1,140 +1,399 @@
 #include "storage/disk_manager.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <climits>
+#include <cstring>
 #include <filesystem>
 #include <stdexcept>
+#include <utility>
 
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
+#include "storage/page_compressor.h"
 
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
-  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    std::filesystem::path p = db_file;
-    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io, DurabilityMode durability,
+                         std::chrono::milliseconds sync_interval, bool compress, bool read_only)
+    : file_name_(db_file), read_only_(read_only) {
+  // directory does not exist
+  std::filesystem::path p = db_file;
+  if (!read_only && p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
+  fd_ = open(db_file.c_str(), read_only ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    throw std::exception();
+  }
+  // A new db file is compressed if asked for, a slot file left over from a removed db file is dropped. An existing db
+  // file is compressed if it has a slot file.
+  std::string slot_file = GetSlotFileName(db_file);
+  bool compressed;
+  if (read_only) {
+    compressed = std::filesystem::exists(slot_file);
+  } else if (GetFileSize(file_name_) == 0) {
+    compressed = compress;
+    if (!compressed) {
+      remove(slot_file.c_str());
+    }
+  } else {
+    compressed = std::filesystem::exists(slot_file);
+    if (compress && !compressed) {
+      LOG(WARNING) << db_file << " was created without page compression, its pages are stored uncompressed";
+    }
+  }
+  if (compressed) {
+    int flags = read_only ? O_RDONLY : O_RDWR | O_CREAT | (GetFileSize(file_name_) == 0 ? O_TRUNC : 0);
+    slot_fd_ = open(slot_file.c_str(), flags, 0644);
+    if (slot_fd_ < 0) {
       throw std::exception();
     }
+    if (direct_io) {
+      LOG(WARNING) << "Direct I/O is not supported with page compression, using buffered I/O for " << db_file;
+      direct_io = false;
+    }
+  }
+  // a read-only file is read through the mapping, which shares the OS page cache
+  if (direct_io && !read_only) {
+    direct_fd_ = open(db_file.c_str(), O_RDWR | O_DIRECT);
+    if (direct_fd_ < 0) {
+      LOG(WARNING) << "O_DIRECT is not supported for " << db_file << ", using buffered I/O";
+    }
+  }
+  file_size_ = GetFileSize(file_name_);
+  preallocated_size_ = file_size_.load();
+  // compressed pages are not stored at fixed offsets and cannot be mapped, they are read through the buffer pool
+  if (read_only && !compressed && file_size_ > 0) {
+    void *map = mmap(nullptr, file_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+      LOG(WARNING) << "Failed to map " << db_file << ", reading it through the buffer pool";
+    } else {
+      map_ = static_cast<char *>(map);
+      map_size_ = file_size_;
+    }
   }
   ReadPhysicalPage(META_PAGE_ID, meta_data_);
+  if (IsCompressed()) {
+    OpenPageMap();
+  }
+  SetDurability(read_only ? DurabilityMode::NONE : durability, sync_interval);
 }
 
 void DiskManager::Close() {
+  StopPeriodicSync();
+  {
+    std::scoped_lock<std::mutex> lock(io_pool_latch_);
+    io_pool_.reset();
+  }
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  WritePhysicalPage(META_PAGE_ID, meta_data_);
   if (!closed) {
-    db_io_.close();
+    for (auto &entry : segment_runs_) {
+      ReleaseRun(&entry.second);
+    }
+    segment_runs_.clear();
+    Checkpoint();
+    close(fd_);
+    fd_ = -1;
+    if (direct_fd_ >= 0) {
+      close(direct_fd_);
+      direct_fd_ = -1;
+    }
+    if (slot_fd_ >= 0) {
+      close(slot_fd_);
+      slot_fd_ = -1;
+    }
+    if (map_ != nullptr) {
+      munmap(map_, map_size_);
+      map_ = nullptr;
+      map_size_ = 0;
+    }
     closed = true;
   }
 }
 
 void DiskManager::ReadPage(page_id_t logical_page_id, char *page_data) {
   ASSERT(logical_page_id >= 0, "Invalid page id.");
-  ReadPhysicalPage(MapPageId(logical_page_id), page_data);
+  if (IsCompressed()) {
+    ReadCompressedPage(logical_page_id, page_data);
+    return;
+  }
+  size_t read_count = ReadPhysicalPage(MapPageId(logical_page_id), page_data);
+  data_bytes_read_.fetch_add(read_count, std::memory_order_relaxed);
 }
 
 void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
   ASSERT(logical_page_id >= 0, "Invalid page id.");
+  if (read_only_) {
+    LOG(ERROR) << "Cannot write page " << logical_page_id << ", " << file_name_ << " is opened read-only";
+    return;
+  }
+  if (IsCompressed()) {
+    WriteCompressedPage(logical_page_id, page_data);
+    return;
+  }
   WritePhysicalPage(MapPageId(logical_page_id), page_data);
+  data_bytes_written_.fetch_add(PAGE_SIZE, std::memory_order_relaxed);
 }
 
-/**
- * TODO: Student Implement
- */
-page_id_t DiskManager::AllocatePage() {
-  
-   DiskFileMetaPage *meta_page;
-   meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
-  // 遍历所有分区，寻找有空闲页的分区
-  uint32_t extent_id;
-  for (extent_id = 0; extent_id < meta_page->GetExtentNums(); extent_id++) {
-      char bitmap_page[PAGE_SIZE];
-      page_id_t bitmap_page_id = extent_id * (BITMAP_SIZE + 1) + 1; // 位图页的物理页号
-      ReadPhysicalPage(bitmap_page_id, bitmap_page);
-      BitmapPage<PAGE_SIZE> *bitmap;
-      bitmap = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap_page);
-
-      uint32_t page_offset = 0;
-      if (bitmap->AllocatePage(page_offset)) {
-        // 更新元信息
-        meta_page->extent_used_page_[extent_id]++; // 直接操作数组
-        meta_page->num_allocated_pages_++;
-        WritePhysicalPage(bitmap_page_id, bitmap_page);
-        // 返回逻辑页号
-        return extent_id * BITMAP_SIZE + page_offset;
-        //LOG(INFO) << "Extend_id: " << extent_id << std::endl;
-        //LOG(INFO) << "page_offset: " << page_offset << std::endl;
+void DiskManager::WritePages(std::vector<std::pair<page_id_t, const char *>> pages) {
+  if (read_only_) {
+    if (!pages.empty()) {
+      LOG(ERROR) << "Cannot write " << pages.size() << " pages, " << file_name_ << " is opened read-only";
+    }
+    return;
+  }
+  // compressed pages are not adjacent in the slot file as a rule, they are written one by one
+  if (IsCompressed()) {
+    for (auto &page : pages) {
+      WritePage(page.first, page.second);
+    }
+    return;
+  }
+  data_bytes_written_.fetch_add(pages.size() * PAGE_SIZE, std::memory_order_relaxed);
+  for (auto &page : pages) {
+    ASSERT(page.first >= 0, "Invalid page id.");
+    page.first = MapPageId(page.first);
+  }
+  std::sort(pages.begin(), pages.end());
+  // O_DIRECT transfers need aligned buffers, unaligned ones are written one by one through the bounce buffer.
+  int fd = direct_fd_ >= 0 ? direct_fd_ : fd_;
+  auto vectored = [this](const char *data) {
+    return direct_fd_ < 0 || reinterpret_cast<uintptr_t>(data) % PAGE_SIZE == 0;
+  };
+  std::vector<struct iovec> iov;
+  size_t i = 0;
+  while (i < pages.size()) {
+    if (!vectored(pages[i].second)) {
+      WritePhysicalPage(pages[i].first, pages[i].second);
+      i++;
+      continue;
+    }
+    // Gather the run of physically adjacent pages starting at i.
+    iov.clear();
+    page_id_t first = pages[i].first;
+    while (i < pages.size() && iov.size() < IOV_MAX && pages[i].first == first + static_cast<page_id_t>(iov.size()) &&
+           vectored(pages[i].second)) {
+      iov.push_back({const_cast<char *>(pages[i].second), PAGE_SIZE});
+      i++;
+    }
+    off_t offset = static_cast<off_t>(first) * PAGE_SIZE;
+    size_t remaining = iov.size() * PAGE_SIZE;
+    ExtendFileSize(offset + remaining);
+    struct iovec *next = iov.data();
+    int count = static_cast<int>(iov.size());
+    // pwritev may write less than asked for, continue with the pages that are left.
+    while (remaining > 0) {
+      ssize_t written = pwritev(fd, next, count, offset);
+      if (written <= 0) {
+        LOG(ERROR) << "I/O error while writing";
+        break;
+      }
+      remaining -= written;
+      offset += written;
+      while (count > 0 && static_cast<size_t>(written) >= next->iov_len) {
+        written -= next->iov_len;
+        next++;
+        count--;
       }
+      if (count > 0) {
+        next->iov_base = static_cast<char *>(next->iov_base) + written;
+        next->iov_len -= written;
+      }
+    }
+    unsynced_.store(true, std::memory_order_relaxed);
   }
-  
-  if (extent_id >=MAX_VALID_PAGE_ID / BITMAP_SIZE) {
-    return INVALID_PAGE_ID;
+}
+
+void DiskManager::Sync() {
+  // nothing is ever written in read-only mode
+  if (read_only_) {
+    return;
   }
+  FlushMetaData();
+  // a write that races with the sync sets the flag again and is picked up by the next one
+  unsynced_.store(false, std::memory_order_relaxed);
+  if (fdatasync(fd_) != 0 || (slot_fd_ >= 0 && fdatasync(slot_fd_) != 0)) {
+    LOG(ERROR) << "I/O error while syncing";
+  }
+}
 
-  char new_bitmap_page[PAGE_SIZE] = {0};
-  page_id_t bitmap_physical_page = extent_id * (BITMAP_SIZE + 1) + 1;
-  //ReadPhysicalPage(bitmap_physical_page, new_bitmap_page);
-  BitmapPage<PAGE_SIZE> *new_bitmap;
-  new_bitmap = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(new_bitmap_page);
-  uint32_t page_offset = 0;
-  new_bitmap->AllocatePage(page_offset);
-  WritePhysicalPage(bitmap_physical_page, new_bitmap_page);
+void DiskManager::Checkpoint() {
+  if (GetDurability() == DurabilityMode::NONE) {
+    FlushMetaData();
+  } else {
+    Sync();
+  }
+}
+
+void DiskManager::SetDurability(DurabilityMode mode, std::chrono::milliseconds sync_interval) {
+  StopPeriodicSync();
+  durability_.store(mode, std::memory_order_relaxed);
+  if (mode == DurabilityMode::PERIODIC) {
+    std::scoped_lock<std::mutex> lock(sync_latch_);
+    sync_interval_ = sync_interval;
+    sync_stop_ = false;
+    sync_thread_ = std::thread(&DiskManager::RunPeriodicSync, this);
+  }
+}
 
-  meta_page->extent_used_page_[extent_id] += 1;
-  meta_page->num_allocated_pages_ ++;
-  meta_page->num_extents_ = extent_id + 1;
-  //LOG(INFO) << "Extend_id: " << extent_id << std::endl;
-  //LOG(INFO) << "page_offset: " << page_offset << std::endl;
-  return page_offset + extent_id * BITMAP_SIZE;
-  
+void DiskManager::StopPeriodicSync() {
+  std::thread thread;
+  {
+    std::scoped_lock<std::mutex> lock(sync_latch_);
+    sync_stop_ = true;
+    thread = std::move(sync_thread_);
+  }
+  sync_cv_.notify_all();
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+void DiskManager::RunPeriodicSync() {
+  std::unique_lock<std::mutex> lock(sync_latch_);
+  while (!sync_cv_.wait_for(lock, sync_interval_, [this] { return sync_stop_; })) {
+    if (HasUnsyncedWrites()) {
+      lock.unlock();
+      Sync();
+      lock.lock();
+    }
+  }
 }
 
 /**
  * TODO: Student Implement
  */
-void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
+page_id_t DiskManager::AllocatePage(segment_id_t segment) {
+  if (read_only_) {
+    LOG(ERROR) << "Cannot allocate a page, " << file_name_ << " is opened read-only";
+    return INVALID_PAGE_ID;
+  }
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-    if (logical_page_id == INVALID_PAGE_ID) {
-        return;
+  if (segment != INVALID_SEGMENT_ID) {
+    auto &run = segment_runs_[segment];
+    if (run.next_ == run.end_ && !ReserveRun(&run)) {
+      // 没有足够长的连续空闲页了，退化为单页分配
+      return AllocatePage();
     }
+    return run.next_++;
+  }
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  // 跳过已满的分区，只看元信息中的计数，不需要读位图页
+  uint32_t extent_id = next_free_extent_;
+  while (extent_id < meta_page->GetExtentNums() && meta_page->GetExtentUsedPage(extent_id) >= BITMAP_SIZE) {
+    extent_id++;
+  }
+  next_free_extent_ = extent_id;
+  if (extent_id >= MAX_VALID_PAGE_ID / BITMAP_SIZE) {
+    return INVALID_PAGE_ID;
+  }
+  uint32_t page_offset = 0;
+  if (!GetBitmap(extent_id)->AllocatePage(page_offset)) {
+    LOG(ERROR) << "Bitmap of extent " << extent_id << " is full but its used page counter is "
+               << meta_page->GetExtentUsedPage(extent_id);
+    return INVALID_PAGE_ID;
+  }
+  AddAllocated(extent_id, 1);
+  // 返回逻辑页号
+  return extent_id * BITMAP_SIZE + page_offset;
+}
 
-    // 计算extent_id和page_offset
-    uint32_t extent_id = logical_page_id / BITMAP_SIZE;
-    uint32_t page_offset = logical_page_id % BITMAP_SIZE;
-
-    DiskFileMetaPage *meta_page;
-    meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+void DiskManager::ReleaseSegment(segment_id_t segment) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  auto it = segment_runs_.find(segment);
+  if (it != segment_runs_.end()) {
+    ReleaseRun(&it->second);
+    segment_runs_.erase(it);
+  }
+}
 
-    // 检查extent_id是否有效
-    if (extent_id >= meta_page->GetExtentNums()) {
-        return;
+bool DiskManager::ReserveRun(SegmentRun *run) {
+  static_assert(SEGMENT_RUN_PAGES > 0 && SEGMENT_RUN_PAGES <= BITMAP_SIZE, "A run must fit in an extent.");
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  const uint32_t max_extents = MAX_VALID_PAGE_ID / BITMAP_SIZE;
+  // 优先紧接着上一段继续预留，段内的页在磁盘上保持连续
+  if (run->end_ != INVALID_PAGE_ID) {
+    uint32_t extent_id = run->end_ / BITMAP_SIZE;
+    if (extent_id <= meta_page->GetExtentNums() && extent_id < max_extents) {
+      uint32_t count = GetBitmap(extent_id)->AllocateRunAt(run->end_ % BITMAP_SIZE, SEGMENT_RUN_PAGES);
+      if (count > 0) {
+        AddAllocated(extent_id, count);
+        run->next_ = run->end_;
+        run->end_ += count;
+        return true;
+      }
+    }
+  }
+  // 否则找第一个有足够长连续空闲页的分区，空闲页数不够的分区不用看位图
+  for (uint32_t extent_id = next_free_extent_; extent_id < max_extents; extent_id++) {
+    if (meta_page->GetExtentUsedPage(extent_id) + SEGMENT_RUN_PAGES > BITMAP_SIZE) {
+      continue;
     }
+    uint32_t page_offset = 0;
+    if (GetBitmap(extent_id)->AllocateRun(SEGMENT_RUN_PAGES, page_offset)) {
+      AddAllocated(extent_id, SEGMENT_RUN_PAGES);
+      run->next_ = extent_id * BITMAP_SIZE + page_offset;
+      run->end_ = run->next_ + SEGMENT_RUN_PAGES;
+      return true;
+    }
+  }
+  return false;
+}
+
+void DiskManager::ReleaseRun(SegmentRun *run) {
+  for (page_id_t page_id = run->next_; page_id < run->end_; page_id++) {
+    DeAllocatePage(page_id);
+  }
+  run->end_ = run->next_;
+}
 
-    // 读取位图页
-    char bitmap_page_data[PAGE_SIZE];
-    page_id_t bitmap_page_id = extent_id * (BITMAP_SIZE + 1) + 1;
-    ReadPhysicalPage(bitmap_page_id, bitmap_page_data);
-    BitmapPage<PAGE_SIZE> *bitmap_page;
-    bitmap_page = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap_page_data);
+void DiskManager::AddAllocated(uint32_t extent_id, uint32_t count) {
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  bitmap_dirty_[extent_id] = true;
+  meta_dirty_ = true;
+  // 更新元信息
+  if (extent_id == meta_page->num_extents_) {
+    meta_page->num_extents_++;
+  }
+  meta_page->extent_used_page_[extent_id] += count;
+  meta_page->num_allocated_pages_ += count;
+}
 
-    // 释放页
-    if (bitmap_page->DeAllocatePage(page_offset)) {
-        // 更新元数据
-        meta_page->num_allocated_pages_--;
-        meta_page->extent_used_page_[extent_id]--;
-  
-        // 更新位图页
-        WritePhysicalPage(bitmap_page_id, bitmap_page_data);
+/**
+ * TODO: Student Implement
+ */
+void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if (logical_page_id < 0) {
+    return;
+  }
+  if (read_only_) {
+    LOG(ERROR) << "Cannot free page " << logical_page_id << ", " << file_name_ << " is opened read-only";
+    return;
+  }
+  // 计算extent_id和page_offset
+  uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+  uint32_t page_offset = logical_page_id % BITMAP_SIZE;
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  // 检查extent_id是否有效
+  if (extent_id >= meta_page->GetExtentNums()) {
+    return;
+  }
+  // 释放页
+  if (GetBitmap(extent_id)->DeAllocatePage(page_offset)) {
+    bitmap_dirty_[extent_id] = true;
+    bitmap_freed_[extent_id] = true;
+    meta_dirty_ = true;
+    // 更新元数据
+    meta_page->num_allocated_pages_--;
+    meta_page->extent_used_page_[extent_id]--;
+    next_free_extent_ = std::min(next_free_extent_, extent_id);
+    if (IsCompressed()) {
+      FreePageSlot(logical_page_id);
     }
+  }
 }
 
 /**
@@ -142,31 +401,159 @@ void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
  */
 bool DiskManager::IsPageFree(page_id_t logical_page_id) {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-    if (logical_page_id == INVALID_PAGE_ID) {
-        return false;
+  if (logical_page_id < 0) {
+    return false;
+  }
+  // 计算extent_id和page_offset
+  uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+  uint32_t page_offset = logical_page_id % BITMAP_SIZE;
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  // 还没有分配过的分区中的页都是空闲的
+  if (extent_id >= meta_page->GetExtentNums()) {
+    return true;
+  }
+  // 为段预留但还没有分配出去的页也是空闲的
+  for (auto &entry : segment_runs_) {
+    if (logical_page_id >= entry.second.next_ && logical_page_id < entry.second.end_) {
+      return true;
     }
+  }
+  // 检查页是否空闲
+  return GetBitmap(extent_id)->IsPageFree(page_offset);
+}
 
-    // 计算extent_id和page_offset
-    uint32_t extent_id = logical_page_id / BITMAP_SIZE;
-    uint32_t page_offset = logical_page_id % BITMAP_SIZE;
+BitmapPage<PAGE_SIZE> *DiskManager::GetBitmap(uint32_t extent_id) {
+  if (extent_id >= bitmaps_.size()) {
+    bitmaps_.resize(extent_id + 1);
+    bitmap_dirty_.resize(extent_id + 1, false);
+    bitmap_freed_.resize(extent_id + 1, false);
+  }
+  auto &bitmap = bitmaps_[extent_id];
+  if (bitmap == nullptr) {
+    bitmap = std::make_unique<char[]>(PAGE_SIZE);
+    // the bitmap of a new extent is not on disk yet and starts out empty
+    auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+    if (extent_id < meta_page->GetExtentNums()) {
+      ReadPhysicalPage(BitmapPhysicalPageId(extent_id), bitmap.get());
+      // 位图页和元信息页不是一起原子写入的，以位图为准修正元信息中的计数
+      uint32_t used = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap.get())->CountAllocated();
+      if (used != meta_page->extent_used_page_[extent_id]) {
+        LOG(WARNING) << "Extent " << extent_id << " has " << used << " allocated pages but the meta page counts "
+                     << meta_page->extent_used_page_[extent_id];
+        meta_page->num_allocated_pages_ += used - meta_page->extent_used_page_[extent_id];
+        meta_page->extent_used_page_[extent_id] = used;
+        meta_dirty_ = true;
+      }
+    }
+  }
+  return reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap.get());
+}
 
-    DiskFileMetaPage *meta_page;
-    meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+void DiskManager::FlushMetaData() {
+  // counters repaired on load are only kept in memory in read-only mode
+  if (read_only_) {
+    return;
+  }
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  for (uint32_t extent_id = 0; extent_id < bitmaps_.size(); extent_id++) {
+    if (bitmap_dirty_[extent_id]) {
+      WritePhysicalPage(BitmapPhysicalPageId(extent_id), bitmaps_[extent_id].get());
+      bitmap_dirty_[extent_id] = false;
+    }
+  }
+  if (IsCompressed()) {
+    FlushPageMap();
+  }
+  if (meta_dirty_) {
+    WritePhysicalPage(META_PAGE_ID, meta_data_);
+    meta_dirty_ = false;
+  }
+  // 位图写回之后再释放空闲页占用的磁盘空间；压缩模式下数据页不在db文件中
+  for (uint32_t extent_id = 0; extent_id < bitmap_freed_.size(); extent_id++) {
+    if (bitmap_freed_[extent_id]) {
+      bitmap_freed_[extent_id] = false;
+      if (!IsCompressed()) {
+        PunchFreeRuns(extent_id);
+      }
+    }
+  }
+}
 
-    // 检查extent_id是否有效
-    //if (extent_id >= meta_page->GetExtentNums()) {
-    //    return false;
-    //}
+uint32_t DiskManager::PunchFreeRuns(uint32_t extent_id) {
+  if (punch_unsupported_) {
+    return 0;
+  }
+  auto *bitmap = GetBitmap(extent_id);
+  size_t file_size = file_size_.load(std::memory_order_relaxed);
+  uint32_t punched = 0;
+  uint32_t page_offset = 0;
+  for (uint32_t length; (length = bitmap->NextFreeRun(page_offset)) > 0; page_offset += length) {
+    if (length < HOLE_PUNCH_MIN_PAGES) {
+      continue;
+    }
+    // the pages of a run are physically contiguous within the extent
+    size_t begin = static_cast<size_t>(MapPageId(extent_id * BITMAP_SIZE + page_offset)) * PAGE_SIZE;
+    if (begin >= file_size) {
+      break;
+    }
+    size_t end = std::min(begin + static_cast<size_t>(length) * PAGE_SIZE, file_size);
+    if (fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, begin, end - begin) != 0) {
+      LOG(WARNING) << "Punching holes is not supported for " << file_name_ << ", free pages keep their disk space";
+      punch_unsupported_ = true;
+      break;
+    }
+    punched += (end - begin) / PAGE_SIZE;
+  }
+  return punched;
+}
 
-    // 读取位图页
-    char bitmap_page_data[PAGE_SIZE];
-    page_id_t bitmap_page_id = extent_id * (BITMAP_SIZE + 1) + 1;
-    ReadPhysicalPage(bitmap_page_id, bitmap_page_data);
-    BitmapPage<PAGE_SIZE> *bitmap_page;
-    bitmap_page = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap_page_data);
+bool DiskManager::Vacuum() {
+  if (read_only_ || IsCompressed()) {
+    return false;
+  }
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  uint32_t num_extents = meta_page->GetExtentNums();
+  // 末尾的空分区整个去掉，文件截断到最后一个已分配页之后
+  uint32_t last_extent = num_extents;
+  while (last_extent > 0 && GetBitmap(last_extent - 1)->GetAllocatedEnd() == 0) {
+    last_extent--;
+  }
+  size_t end = PAGE_SIZE;
+  if (last_extent > 0) {
+    uint32_t allocated_end = GetBitmap(last_extent - 1)->GetAllocatedEnd();
+    end = (static_cast<size_t>(MapPageId((last_extent - 1) * BITMAP_SIZE + allocated_end - 1)) + 1) * PAGE_SIZE;
+  }
+  if (last_extent < num_extents) {
+    meta_page->num_extents_ = last_extent;
+    meta_dirty_ = true;
+    bitmaps_.resize(std::min<size_t>(bitmaps_.size(), last_extent));
+    bitmap_dirty_.resize(bitmaps_.size());
+    bitmap_freed_.resize(bitmaps_.size());
+    next_free_extent_ = std::min(next_free_extent_, last_extent);
+  }
+  for (uint32_t extent_id = 0; extent_id < last_extent; extent_id++) {
+    PunchFreeRuns(extent_id);
+    bitmap_freed_[extent_id] = false;
+  }
+  FlushMetaData();
+  // also drops the space preallocated past the end of the file
+  end = std::min(end, file_size_.load(std::memory_order_relaxed));
+  if (ftruncate(fd_, static_cast<off_t>(end)) != 0) {
+    LOG(ERROR) << "I/O error while truncating " << file_name_;
+    return false;
+  }
+  file_size_.store(end, std::memory_order_relaxed);
+  std::scoped_lock<std::mutex> preallocate_lock(preallocate_latch_);
+  if (!preallocate_unsupported_) {
+    preallocated_size_.store(end, std::memory_order_relaxed);
+  }
+  return true;
+}
 
-    // 检查页是否空闲
-    return bitmap_page->IsPageFree(page_offset);
+size_t DiskManager::GetDiskUsage() {
+  struct stat stat_buf;
+  return fstat(fd_, &stat_buf) == 0 ? static_cast<size_t>(stat_buf.st_blocks) * 512 : 0;
 }
 
 /**
@@ -176,45 +563,376 @@ page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
   return logical_page_id + 1 + 1 + logical_page_id / BITMAP_SIZE;
 }
 
-int DiskManager::GetFileSize(const std::string &file_name) {
+const char *DiskManager::GetPageView(page_id_t logical_page_id) {
+  if (map_ == nullptr || logical_page_id < 0) {
+    return nullptr;
+  }
+  size_t offset = static_cast<size_t>(MapPageId(logical_page_id)) * PAGE_SIZE;
+  return offset + PAGE_SIZE <= map_size_ ? map_ + offset : nullptr;
+}
+
+void DiskManager::AdviseWillNeed(page_id_t first_page_id, size_t count) {
+  if (map_ == nullptr || first_page_id < 0 || count == 0) {
+    return;
+  }
+  // logical pages map to physical pages monotonically, the range only has the bitmap pages it crosses in between
+  count = std::min(count, GetMappedPageCount());
+  size_t begin = static_cast<size_t>(MapPageId(first_page_id)) * PAGE_SIZE;
+  size_t end = (static_cast<size_t>(MapPageId(first_page_id + static_cast<page_id_t>(count) - 1)) + 1) * PAGE_SIZE;
+  end = std::min(end, map_size_ / PAGE_SIZE * PAGE_SIZE);
+  if (begin < end && madvise(map_ + begin, end - begin, MADV_WILLNEED) != 0) {
+    LOG(WARNING) << "madvise failed on " << file_name_;
+  }
+}
+
+size_t DiskManager::GetFileSize(const std::string &file_name) {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? stat_buf.st_size : -1;
+  return rc == 0 ? stat_buf.st_size : 0;
+}
+
+void DiskManager::ExtendFileSize(size_t size) {
+  size_t file_size = file_size_.load(std::memory_order_relaxed);
+  while (file_size < size && !file_size_.compare_exchange_weak(file_size, size, std::memory_order_relaxed)) {
+  }
+  if (size > preallocated_size_.load(std::memory_order_relaxed)) {
+    Preallocate(size);
+  }
+}
+
+void DiskManager::Preallocate(size_t size) {
+  std::scoped_lock<std::mutex> lock(preallocate_latch_);
+  size_t preallocated = preallocated_size_.load(std::memory_order_relaxed);
+  if (size <= preallocated) {
+    return;
+  }
+  constexpr size_t chunk = static_cast<size_t>(FILE_PREALLOCATE_PAGES) * PAGE_SIZE;
+  size_t end = (size + chunk - 1) / chunk * chunk;
+  if (fallocate(fd_, FALLOC_FL_KEEP_SIZE, preallocated, end - preallocated) != 0) {
+    LOG(WARNING) << "Preallocation is not supported for " << file_name_ << ", the file grows page by page";
+    preallocate_unsupported_ = true;
+    // never come back here
+    end = SIZE_MAX;
+  }
+  preallocated_size_.store(end, std::memory_order_relaxed);
 }
 
-void DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
-  int offset = physical_page_id * PAGE_SIZE;
+size_t DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
+  size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
   // check if read beyond file length
-  if (offset >= GetFileSize(file_name_)) {
+  if (offset >= file_size_.load(std::memory_order_relaxed)) {
 #ifdef ENABLE_BPM_DEBUG
     LOG(INFO) << "Read less than a page" << std::endl;
 #endif
     memset(page_data, 0, PAGE_SIZE);
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
+    return 0;
+  }
+  // O_DIRECT needs an aligned buffer, unaligned ones go through a bounce buffer on the stack.
+  alignas(PAGE_SIZE) char bounce_buffer[PAGE_SIZE];
+  bool direct = direct_fd_ >= 0;
+  bool bounce = direct && reinterpret_cast<uintptr_t>(page_data) % PAGE_SIZE != 0;
+  char *buffer = bounce ? bounce_buffer : page_data;
+  size_t read_count = 0;
+  while (read_count < PAGE_SIZE) {
+    ssize_t n = pread(direct ? direct_fd_ : fd_, buffer + read_count, PAGE_SIZE - read_count, offset + read_count);
+    if (n < 0) {
+      LOG(ERROR) << "I/O error while reading";
+      break;
+    }
+    read_count += n;
+    // end of file, O_DIRECT only returns short reads there
+    if (n == 0 || direct) {
+      break;
+    }
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
 #ifdef ENABLE_BPM_DEBUG
-      LOG(INFO) << "Read less than a page" << std::endl;
+    LOG(INFO) << "Read less than a page" << std::endl;
 #endif
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
-    }
+    memset(buffer + read_count, 0, PAGE_SIZE - read_count);
   }
+  if (bounce) {
+    memcpy(page_data, bounce_buffer, PAGE_SIZE);
+  }
+  return read_count;
 }
 
 void DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
   size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG(ERROR) << "I/O error while writing";
+  alignas(PAGE_SIZE) char bounce_buffer[PAGE_SIZE];
+  bool direct = direct_fd_ >= 0;
+  const char *buffer = page_data;
+  if (direct && reinterpret_cast<uintptr_t>(page_data) % PAGE_SIZE != 0) {
+    memcpy(bounce_buffer, page_data, PAGE_SIZE);
+    buffer = bounce_buffer;
+  }
+  // the space is preallocated before the write, so that the file does not grow a page at a time
+  ExtendFileSize(offset + PAGE_SIZE);
+  size_t written = 0;
+  while (written < PAGE_SIZE) {
+    ssize_t n = pwrite(direct ? direct_fd_ : fd_, buffer + written, PAGE_SIZE - written, offset + written);
+    // check for I/O error
+    if (n <= 0) {
+      LOG(ERROR) << "I/O error while writing";
+      return;
+    }
+    written += n;
+  }
+  unsynced_.store(true, std::memory_order_relaxed);
+}
+
+bool DiskManager::PrepareTransfer(const PageIORequest *request, int *fd, off_t *offset) {
+  ASSERT(request->page_id_ >= 0, "Invalid page id.");
+  // compressed pages are read and written whole by ReadPage and WritePage
+  if (IsCompressed()) {
+    return false;
+  }
+  // writes are refused by WritePage in read-only mode
+  if (read_only_ && request->type_ == PageIORequest::WRITE) {
+    return false;
+  }
+  size_t physical_offset = static_cast<size_t>(MapPageId(request->page_id_)) * PAGE_SIZE;
+  bool direct = direct_fd_ >= 0;
+  if (direct && reinterpret_cast<uintptr_t>(request->data_) % PAGE_SIZE != 0) {
+    return false;
+  }
+  if (request->type_ == PageIORequest::READ) {
+    if (physical_offset >= file_size_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+  } else {
+    ExtendFileSize(physical_offset + PAGE_SIZE);
+  }
+  *fd = direct ? direct_fd_ : fd_;
+  *offset = static_cast<off_t>(physical_offset);
+  return true;
+}
+
+void DiskManager::FinishTransfer(const PageIORequest *request) {
+  if (request->type_ == PageIORequest::WRITE) {
+    data_bytes_written_.fetch_add(PAGE_SIZE, std::memory_order_relaxed);
+    unsynced_.store(true, std::memory_order_relaxed);
+  } else {
+    data_bytes_read_.fetch_add(PAGE_SIZE, std::memory_order_relaxed);
+  }
+}
+
+std::unique_ptr<PageIOQueue> DiskManager::CreateIOQueue(size_t depth, IOBackend backend) {
+  return PageIOQueue::Create(this, depth, backend);
+}
+
+IOThreadPool *DiskManager::GetIOThreadPool() {
+  std::scoped_lock<std::mutex> lock(io_pool_latch_);
+  if (io_pool_ == nullptr) {
+    io_pool_ = std::make_unique<IOThreadPool>(DEFAULT_IO_THREADS);
+  }
+  return io_pool_.get();
+}
+
+/*****************************************************************************
+ * Compressed storage mode
+ *****************************************************************************/
+
+namespace {
+
+// An entry of the page map: | offset in slot units (47 bits) | slot units (4 bits) | stored length (13 bits) |, 0 for
+// a page that was never written. A stored length of PAGE_SIZE means the page is stored uncompressed.
+constexpr int LENGTH_BITS = 13;
+constexpr int UNITS_BITS = 4;
+static_assert(PAGE_SIZE < (1 << LENGTH_BITS) && DiskManager::MAX_SLOT_UNITS < (1 << UNITS_BITS),
+              "A page map entry cannot describe the slots.");
+
+inline uint64_t MakeSlotEntry(uint64_t offset, uint32_t units, uint32_t length) {
+  return (offset << (LENGTH_BITS + UNITS_BITS)) | (static_cast<uint64_t>(units) << LENGTH_BITS) | length;
+}
+
+inline uint64_t SlotOffset(uint64_t entry) { return entry >> (LENGTH_BITS + UNITS_BITS); }
+
+inline uint32_t SlotUnits(uint64_t entry) { return (entry >> LENGTH_BITS) & ((1 << UNITS_BITS) - 1); }
+
+inline uint32_t SlotLength(uint64_t entry) { return entry & ((1 << LENGTH_BITS) - 1); }
+
+}  // namespace
+
+std::string DiskManager::GetSlotFileName(const std::string &db_file) {
+  std::filesystem::path path(db_file);
+  path.replace_filename("." + path.filename().string() + ".z");
+  return path.string();
+}
+
+void DiskManager::OpenPageMap() {
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  size_t num_pages = static_cast<size_t>(meta_page->GetExtentNums()) * BITMAP_SIZE;
+  size_t num_blocks = (num_pages + PAGE_MAP_BLOCK_SIZE - 1) / PAGE_MAP_BLOCK_SIZE;
+  page_map_.assign(num_blocks * PAGE_MAP_BLOCK_SIZE, 0);
+  page_map_dirty_.assign(num_blocks, false);
+  for (size_t block = 0; block < num_blocks; block++) {
+    ReadPhysicalPage(MapPageId(block), reinterpret_cast<char *>(&page_map_[block * PAGE_MAP_BLOCK_SIZE]));
+  }
+  // Every part of the slot file that no page maps to is free, cut it into slots of the largest size.
+  std::vector<std::pair<uint64_t, uint32_t>> used;
+  for (auto entry : page_map_) {
+    if (entry != 0) {
+      used.emplace_back(SlotOffset(entry), SlotUnits(entry));
+    }
+  }
+  std::sort(used.begin(), used.end());
+  struct stat stat_buf;
+  slot_file_units_ = fstat(slot_fd_, &stat_buf) == 0 ? stat_buf.st_size / SLOT_UNIT_SIZE : 0;
+  uint64_t next = 0;
+  auto add_free = [this](uint64_t begin, uint64_t end) {
+    for (; begin < end; begin += MAX_SLOT_UNITS) {
+      uint32_t units = std::min<uint64_t>(MAX_SLOT_UNITS, end - begin);
+      free_slots_[units].push_back(begin);
+    }
+  };
+  for (auto &slot : used) {
+    add_free(next, slot.first);
+    next = std::max(next, slot.first + slot.second);
+  }
+  slot_file_units_ = std::max(slot_file_units_, next);
+  add_free(next, slot_file_units_);
+}
+
+uint64_t DiskManager::AllocateSlot(uint32_t units) {
+  auto &free_slots = free_slots_[units];
+  if (!free_slots.empty()) {
+    uint64_t offset = free_slots.back();
+    free_slots.pop_back();
+    return offset;
+  }
+  uint64_t offset = slot_file_units_;
+  slot_file_units_ += units;
+  return offset;
+}
+
+void DiskManager::ReadCompressedPage(page_id_t logical_page_id, char *page_data) {
+  uint64_t entry = 0;
+  {
+    std::scoped_lock<std::mutex> lock(page_map_latch_);
+    if (static_cast<size_t>(logical_page_id) < page_map_.size()) {
+      entry = page_map_[logical_page_id];
+    }
+  }
+  // a page that was never written reads as zeros, like a page past the end of an uncompressed file
+  if (entry == 0) {
+    memset(page_data, 0, PAGE_SIZE);
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
-}
\ No newline at end of file
+  uint32_t length = SlotLength(entry);
+  char buffer[PAGE_SIZE];
+  char *target = length == PAGE_SIZE ? page_data : buffer;
+  size_t read_count = 0;
+  while (read_count < length) {
+    ssize_t n = pread(slot_fd_, target + read_count, length - read_count,
+                      SlotOffset(entry) * SLOT_UNIT_SIZE + read_count);
+    if (n <= 0) {
+      LOG(ERROR) << "I/O error while reading";
+      break;
+    }
+    read_count += n;
+  }
+  data_bytes_read_.fetch_add(read_count, std::memory_order_relaxed);
+  if (read_count < length) {
+    memset(page_data, 0, PAGE_SIZE);
+  } else if (length < PAGE_SIZE && !PageCompressor::Decompress(buffer, length, page_data, PAGE_SIZE)) {
+    LOG(ERROR) << "Compressed page " << logical_page_id << " is corrupt";
+    memset(page_data, 0, PAGE_SIZE);
+  }
+}
+
+void DiskManager::WriteCompressedPage(page_id_t logical_page_id, const char *page_data) {
+  // A page is stored as it is when compression would not save a slot unit.
+  char buffer[PAGE_SIZE];
+  size_t length = PageCompressor::Compress(page_data, PAGE_SIZE, buffer, PAGE_SIZE - SLOT_UNIT_SIZE);
+  const char *data = buffer;
+  if (length == 0) {
+    length = PAGE_SIZE;
+    data = page_data;
+  }
+  uint32_t units = (length + SLOT_UNIT_SIZE - 1) / SLOT_UNIT_SIZE;
+  uint64_t offset;
+  {
+    std::scoped_lock<std::mutex> lock(page_map_latch_);
+    if (static_cast<size_t>(logical_page_id) >= page_map_.size()) {
+      size_t num_blocks = logical_page_id / PAGE_MAP_BLOCK_SIZE + 1;
+      page_map_.resize(num_blocks * PAGE_MAP_BLOCK_SIZE, 0);
+      page_map_dirty_.resize(num_blocks, false);
+    }
+    uint64_t &entry = page_map_[logical_page_id];
+    // keep the slot of the page if the new data fits in it, so that pages do not move around as they change
+    if (entry != 0 && SlotUnits(entry) >= units) {
+      units = SlotUnits(entry);
+      offset = SlotOffset(entry);
+    } else {
+      if (entry != 0) {
+        pending_free_slots_.push_back(entry);
+      }
+      offset = AllocateSlot(units);
+    }
+    entry = MakeSlotEntry(offset, units, length);
+    page_map_dirty_[logical_page_id / PAGE_MAP_BLOCK_SIZE] = true;
+  }
+  size_t written = 0;
+  while (written < length) {
+    ssize_t n = pwrite(slot_fd_, data + written, length - written, offset * SLOT_UNIT_SIZE + written);
+    if (n <= 0) {
+      LOG(ERROR) << "I/O error while writing";
+      return;
+    }
+    written += n;
+  }
+  data_bytes_written_.fetch_add(length, std::memory_order_relaxed);
+  unsynced_.store(true, std::memory_order_relaxed);
+}
+
+void DiskManager::FreePageSlot(page_id_t logical_page_id) {
+  std::scoped_lock<std::mutex> lock(page_map_latch_);
+  if (static_cast<size_t>(logical_page_id) >= page_map_.size() || page_map_[logical_page_id] == 0) {
+    return;
+  }
+  uint64_t &entry = page_map_[logical_page_id];
+  pending_free_slots_.push_back(entry);
+  entry = 0;
+  page_map_dirty_[logical_page_id / PAGE_MAP_BLOCK_SIZE] = true;
+}
+
+void DiskManager::FlushPageMap() {
+  std::vector<uint64_t> released;
+  {
+    std::scoped_lock<std::mutex> lock(page_map_latch_);
+    for (size_t block = 0; block < page_map_dirty_.size(); block++) {
+      if (page_map_dirty_[block]) {
+        WritePhysicalPage(MapPageId(block), reinterpret_cast<const char *>(&page_map_[block * PAGE_MAP_BLOCK_SIZE]));
+        page_map_dirty_[block] = false;
+      }
+    }
+    released.swap(pending_free_slots_);
+  }
+  if (released.empty()) {
+    return;
+  }
+  // 不再指向这些槽的映射块落盘之后，槽才能给别的页用，否则崩溃后旧映射会读到别的页的数据
+  bool synced = fdatasync(fd_) == 0;
+  if (!synced) {
+    LOG(ERROR) << "I/O error while syncing";
+  }
+  std::scoped_lock<std::mutex> lock(page_map_latch_);
+  for (auto entry : released) {
+    if (synced) {
+      free_slots_[SlotUnits(entry)].push_back(SlotOffset(entry));
+    } else {
+      pending_free_slots_.push_back(entry);
+    }
+  }
+}
+
+size_t DiskManager::GetCompressedSize() {
+  std::scoped_lock<std::mutex> lock(page_map_latch_);
+  size_t size = 0;
+  for (auto entry : page_map_) {
+    size += SlotLength(entry);
+  }
+  return size;
+}
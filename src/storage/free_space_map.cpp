@@ -0,0 +1,263 @@
+#include "storage/free_space_map.h"
+
+#include "page/table_page.h"
+
+page_id_t FreeSpaceMap::Create(BufferPoolManager *buffer_pool_manager, page_id_t last_heap_page_id) {
+  page_id_t page_id;
+  auto new_page = buffer_pool_manager->NewPage(page_id);
+  if (new_page == nullptr) {
+    return INVALID_PAGE_ID;
+  }
+  auto page = reinterpret_cast<FreeSpaceMapPage *>(new_page->GetData());
+  page->Init();
+  page->SetLastHeapPageId(last_heap_page_id);
+  buffer_pool_manager->UnpinPage(page_id, true);
+  return page_id;
+}
+
+page_id_t FreeSpaceMap::Build(BufferPoolManager *buffer_pool_manager, page_id_t first_heap_page_id) {
+  page_id_t page_id = Create(buffer_pool_manager, first_heap_page_id);
+  if (page_id == INVALID_PAGE_ID) {
+    return INVALID_PAGE_ID;
+  }
+  FreeSpaceMap map(buffer_pool_manager, page_id);
+  page_id_t heap_page_id = first_heap_page_id;
+  while (heap_page_id != INVALID_PAGE_ID) {
+    auto heap_page = reinterpret_cast<TablePage *>(buffer_pool_manager->FetchPage(heap_page_id));
+    if (heap_page == nullptr) {
+      break;
+    }
+    heap_page->RLatch();
+    uint32_t free_space = heap_page->GetFreeSpaceRemaining();
+    page_id_t next_page_id = heap_page->GetNextPageId();
+    heap_page->RUnlatch();
+    buffer_pool_manager->UnpinPage(heap_page_id, false);
+    map.Update(heap_page_id, free_space);
+    map.SetLastHeapPageId(heap_page_id);
+    heap_page_id = next_page_id;
+  }
+  return page_id;
+}
+
+page_id_t FreeSpaceMap::FindPage(uint32_t size) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!Load()) {
+    return INVALID_PAGE_ID;
+  }
+  // 向上取整，保证该 category 的页一定放得下
+  uint32_t needed = (size + CATEGORY_SIZE - 1) / CATEGORY_SIZE;
+  if (needed > UINT8_MAX) {
+    needed = UINT8_MAX;
+  }
+  for (uint32_t i = 0; i < map_page_ids_.size(); i++) {
+    if (max_categories_[i] < needed) {
+      continue;
+    }
+    uint32_t end = std::min<uint32_t>((i + 1) * FreeSpaceMapPage::MAX_ENTRY_COUNT, categories_.size());
+    for (uint32_t j = i * FreeSpaceMapPage::MAX_ENTRY_COUNT; j < end; j++) {
+      if (categories_[j] >= needed) {
+        return heap_page_ids_[j];
+      }
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+void FreeSpaceMap::Update(page_id_t heap_page_id, uint32_t free_space) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!Load()) {
+    return;
+  }
+  uint8_t category = ToCategory(free_space);
+  auto it = positions_.find(heap_page_id);
+  if (it != positions_.end()) {
+    if (categories_[it->second] != category) {
+      SetEntry(it->second, heap_page_id, category);
+    }
+    return;
+  }
+
+  // 新的堆页先占已释放堆页留下的空位
+  if (!free_positions_.empty()) {
+    uint32_t position = free_positions_.back();
+    free_positions_.pop_back();
+    positions_[heap_page_id] = position;
+    SetEntry(position, heap_page_id, category);
+    return;
+  }
+
+  // 没有空位就追加到最后一个空闲空间表页，满了就再接一页
+  uint32_t position = heap_page_ids_.size();
+  if (position == map_page_ids_.size() * FreeSpaceMapPage::MAX_ENTRY_COUNT) {
+    page_id_t new_page_id;
+    auto new_page = buffer_pool_manager_->NewPage(new_page_id);
+    if (new_page == nullptr) {
+      return;
+    }
+    page_id_t tail_page_id = map_page_ids_.back();
+    auto tail_page = buffer_pool_manager_->FetchPage(tail_page_id);
+    if (tail_page == nullptr) {
+      buffer_pool_manager_->UnpinPage(new_page_id, false);
+      buffer_pool_manager_->DeletePage(new_page_id);
+      return;
+    }
+    reinterpret_cast<FreeSpaceMapPage *>(new_page->GetData())->Init();
+    buffer_pool_manager_->UnpinPage(new_page_id, true);
+    reinterpret_cast<FreeSpaceMapPage *>(tail_page->GetData())->SetNextPageId(new_page_id);
+    buffer_pool_manager_->UnpinPage(tail_page_id, true);
+    map_page_ids_.push_back(new_page_id);
+    max_categories_.push_back(0);
+  }
+  page_id_t map_page_id = map_page_ids_.back();
+  auto map_page = buffer_pool_manager_->FetchPage(map_page_id);
+  if (map_page == nullptr) {
+    return;
+  }
+  reinterpret_cast<FreeSpaceMapPage *>(map_page->GetData())->Append(heap_page_id, category);
+  buffer_pool_manager_->UnpinPage(map_page_id, true);
+  heap_page_ids_.push_back(heap_page_id);
+  categories_.push_back(category);
+  positions_[heap_page_id] = position;
+  max_categories_.back() = std::max(max_categories_.back(), category);
+}
+
+void FreeSpaceMap::Remove(page_id_t heap_page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!Load()) {
+    return;
+  }
+  auto it = positions_.find(heap_page_id);
+  if (it == positions_.end()) {
+    return;
+  }
+  uint32_t position = it->second;
+  positions_.erase(it);
+  SetEntry(position, INVALID_PAGE_ID, 0);
+  free_positions_.push_back(position);
+}
+
+page_id_t FreeSpaceMap::GetLastHeapPageId() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!Load()) {
+    return INVALID_PAGE_ID;
+  }
+  return last_heap_page_id_;
+}
+
+void FreeSpaceMap::SetLastHeapPageId(page_id_t heap_page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!Load()) {
+    return;
+  }
+  if (last_heap_page_id_ == heap_page_id) {
+    return;
+  }
+  // 新页已经接在链表上了，内存中的尾页总要跟上，页上的晚些再写
+  last_heap_page_id_ = heap_page_id;
+  auto page = buffer_pool_manager_->FetchPage(first_page_id_);
+  if (page == nullptr) {
+    return;
+  }
+  reinterpret_cast<FreeSpaceMapPage *>(page->GetData())->SetLastHeapPageId(heap_page_id);
+  buffer_pool_manager_->UnpinPage(first_page_id_, true);
+}
+
+void FreeSpaceMap::Destroy() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!Load()) {
+    return;
+  }
+  for (auto map_page_id : map_page_ids_) {
+    buffer_pool_manager_->DeletePage(map_page_id);
+  }
+  map_page_ids_.clear();
+  max_categories_.clear();
+  heap_page_ids_.clear();
+  categories_.clear();
+  positions_.clear();
+  free_positions_.clear();
+  last_heap_page_id_ = INVALID_PAGE_ID;
+  first_page_id_ = INVALID_PAGE_ID;
+}
+
+bool FreeSpaceMap::Load() {
+  if (loaded_) {
+    return true;
+  }
+  // 先读进临时表，有一页取不到就整个作废，下次再读
+  std::vector<page_id_t> map_page_ids;
+  std::vector<uint8_t> max_categories;
+  std::vector<page_id_t> heap_page_ids;
+  std::vector<uint8_t> categories;
+  std::unordered_map<page_id_t, uint32_t> positions;
+  std::vector<uint32_t> free_positions;
+  page_id_t last_heap_page_id = INVALID_PAGE_ID;
+  page_id_t map_page_id = first_page_id_;
+  while (map_page_id != INVALID_PAGE_ID) {
+    auto map_page = buffer_pool_manager_->FetchPage(map_page_id);
+    if (map_page == nullptr) {
+      return false;
+    }
+    auto page = reinterpret_cast<FreeSpaceMapPage *>(map_page->GetData());
+    ASSERT(page->GetVersion() == FreeSpaceMapPage::VERSION, "Unsupported free space map version.");
+    if (map_page_id == first_page_id_) {
+      last_heap_page_id = page->GetLastHeapPageId();
+    }
+    uint8_t max_category = 0;
+    for (uint32_t i = 0; i < page->GetEntryCount(); i++) {
+      if (page->GetHeapPageId(i) == INVALID_PAGE_ID) {
+        free_positions.push_back(heap_page_ids.size());
+      } else {
+        positions[page->GetHeapPageId(i)] = heap_page_ids.size();
+      }
+      heap_page_ids.push_back(page->GetHeapPageId(i));
+      categories.push_back(page->GetCategory(i));
+      max_category = std::max(max_category, page->GetCategory(i));
+    }
+    map_page_ids.push_back(map_page_id);
+    max_categories.push_back(max_category);
+    page_id_t next_page_id = page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(map_page_id, false);
+    map_page_id = next_page_id;
+  }
+  map_page_ids_ = std::move(map_page_ids);
+  max_categories_ = std::move(max_categories);
+  heap_page_ids_ = std::move(heap_page_ids);
+  categories_ = std::move(categories);
+  positions_ = std::move(positions);
+  free_positions_ = std::move(free_positions);
+  last_heap_page_id_ = last_heap_page_id;
+  loaded_ = true;
+  return true;
+}
+
+void FreeSpaceMap::RecomputeMaxCategory(uint32_t map_index) {
+  uint32_t begin = map_index * FreeSpaceMapPage::MAX_ENTRY_COUNT;
+  uint32_t end = std::min<uint32_t>(begin + FreeSpaceMapPage::MAX_ENTRY_COUNT, categories_.size());
+  uint8_t max_category = 0;
+  for (uint32_t i = begin; i < end; i++) {
+    max_category = std::max(max_category, categories_[i]);
+  }
+  max_categories_[map_index] = max_category;
+}
+
+void FreeSpaceMap::SetEntry(uint32_t position, page_id_t heap_page_id, uint8_t category) {
+  uint32_t map_index = position / FreeSpaceMapPage::MAX_ENTRY_COUNT;
+  page_id_t map_page_id = map_page_ids_[map_index];
+  // 取不到表页就只改内存中的表，页上的项是提示，晚些写进去也无妨
+  auto map_page = buffer_pool_manager_->FetchPage(map_page_id);
+  if (map_page != nullptr) {
+    auto page = reinterpret_cast<FreeSpaceMapPage *>(map_page->GetData());
+    page->SetHeapPageId(position % FreeSpaceMapPage::MAX_ENTRY_COUNT, heap_page_id);
+    page->SetCategory(position % FreeSpaceMapPage::MAX_ENTRY_COUNT, category);
+    buffer_pool_manager_->UnpinPage(map_page_id, true);
+  }
+  uint8_t old_category = categories_[position];
+  heap_page_ids_[position] = heap_page_id;
+  categories_[position] = category;
+  if (category > max_categories_[map_index]) {
+    max_categories_[map_index] = category;
+  } else if (old_category == max_categories_[map_index]) {
+    RecomputeMaxCategory(map_index);
+  }
+}
@@ -0,0 +1,176 @@
+#include "storage/page_compressor.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+inline uint32_t Load32(const char *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+/** @return the number of bytes a and b have in common at their start, at most limit */
+inline size_t CommonPrefix(const char *a, const char *b, size_t limit) {
+  size_t length = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // compare 8 bytes at a time, the lowest set bit of the difference is in the first byte that differs
+  while (length + sizeof(uint64_t) <= limit) {
+    uint64_t x;
+    uint64_t y;
+    memcpy(&x, a + length, sizeof(x));
+    memcpy(&y, b + length, sizeof(y));
+    if (x != y) {
+      return length + __builtin_ctzll(x ^ y) / 8;
+    }
+    length += sizeof(uint64_t);
+  }
+#endif
+  while (length < limit && a[length] == b[length]) {
+    length++;
+  }
+  return length;
+}
+
+/** Append the continuation bytes of a length whose nibble is 15. */
+bool WriteLength(size_t length, char *&op, const char *op_end) {
+  while (length >= 255) {
+    if (op == op_end) {
+      return false;
+    }
+    *op++ = static_cast<char>(255);
+    length -= 255;
+  }
+  if (op == op_end) {
+    return false;
+  }
+  *op++ = static_cast<char>(length);
+  return true;
+}
+
+bool ReadLength(size_t *length, const unsigned char *&ip, const unsigned char *ip_end) {
+  unsigned char byte;
+  do {
+    if (ip == ip_end) {
+      return false;
+    }
+    byte = *ip++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/** Append literals followed by a match, match_length is 0 for the last sequence, which has no match. */
+bool WriteSequence(const char *literals, size_t literal_length, size_t offset, size_t match_length, char *&op,
+                   const char *op_end) {
+  if (op == op_end) {
+    return false;
+  }
+  char *token = op++;
+  size_t match_code = match_length == 0 ? 0 : match_length - PageCompressor::MIN_MATCH;
+  *token = static_cast<char>((std::min<size_t>(literal_length, 15) << 4) | std::min<size_t>(match_code, 15));
+  if (literal_length >= 15 && !WriteLength(literal_length - 15, op, op_end)) {
+    return false;
+  }
+  if (static_cast<size_t>(op_end - op) < literal_length) {
+    return false;
+  }
+  memcpy(op, literals, literal_length);
+  op += literal_length;
+  if (match_length == 0) {
+    return true;
+  }
+  if (op_end - op < 2) {
+    return false;
+  }
+  *op++ = static_cast<char>(offset & 0xFF);
+  *op++ = static_cast<char>(offset >> 8);
+  return match_code < 15 || WriteLength(match_code - 15, op, op_end);
+}
+
+}  // namespace
+
+size_t PageCompressor::Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) {
+  if (src_size > MAX_INPUT_SIZE) {
+    return 0;
+  }
+  // position + 1 of the last 4-byte sequence with each hash, 0 if none
+  uint16_t table[1 << HASH_BITS];
+  memset(table, 0, sizeof(table));
+  char *op = dst;
+  const char *op_end = dst + dst_capacity;
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (pos + MIN_MATCH <= src_size) {
+    uint32_t sequence = Load32(src + pos);
+    uint32_t hash = (sequence * 2654435761U) >> (32 - HASH_BITS);
+    size_t candidate = table[hash];
+    table[hash] = static_cast<uint16_t>(pos + 1);
+    if (candidate == 0 || Load32(src + candidate - 1) != sequence) {
+      // step faster through data that does not compress
+      pos += 1 + ((pos - anchor) >> 6);
+      continue;
+    }
+    candidate--;
+    size_t length = MIN_MATCH + CommonPrefix(src + candidate + MIN_MATCH, src + pos + MIN_MATCH,
+                                             src_size - pos - MIN_MATCH);
+    if (!WriteSequence(src + anchor, pos - anchor, pos - candidate, length, op, op_end)) {
+      return 0;
+    }
+    pos += length;
+    anchor = pos;
+  }
+  if (!WriteSequence(src + anchor, src_size - anchor, 0, 0, op, op_end)) {
+    return 0;
+  }
+  return op - dst;
+}
+
+bool PageCompressor::Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) {
+  auto *ip = reinterpret_cast<const unsigned char *>(src);
+  const auto *ip_end = ip + src_size;
+  char *op = dst;
+  char *op_end = dst + dst_size;
+  while (ip < ip_end) {
+    unsigned char token = *ip++;
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !ReadLength(&literal_length, ip, ip_end)) {
+      return false;
+    }
+    if (static_cast<size_t>(ip_end - ip) < literal_length || static_cast<size_t>(op_end - op) < literal_length) {
+      return false;
+    }
+    memcpy(op, ip, literal_length);
+    op += literal_length;
+    ip += literal_length;
+    // the last sequence ends with its literals
+    if (ip == ip_end) {
+      break;
+    }
+    if (ip_end - ip < 2) {
+      return false;
+    }
+    size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    size_t match_length = token & 15;
+    if (match_length == 15 && !ReadLength(&match_length, ip, ip_end)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > static_cast<size_t>(op - dst) || static_cast<size_t>(op_end - op) < match_length) {
+      return false;
+    }
+    // a match may overlap the bytes it produces, a run of one byte has offset 1
+    const char *match = op - offset;
+    if (offset >= match_length) {
+      memcpy(op, match, match_length);
+    } else {
+      for (size_t i = 0; i < match_length; i++) {
+        op[i] = match[i];
+      }
+    }
+    op += match_length;
+  }
+  return op == op_end;
+}
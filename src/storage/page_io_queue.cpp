@@ -0,0 +1,432 @@
+#include "storage/page_io_queue.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+
+#include "glog/logging.h"
+#include "storage/disk_manager.h"
+
+IOThreadPool::IOThreadPool(size_t num_threads) {
+  for (size_t i = 0; i < num_threads; i++) {
+    threads_.emplace_back(&IOThreadPool::Run, this);
+  }
+}
+
+IOThreadPool::~IOThreadPool() {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void IOThreadPool::Post(std::function<void()> task) {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    tasks_.push_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+void IOThreadPool::Run() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+    if (tasks_.empty()) {
+      break;
+    }
+    auto task = std::move(tasks_.front());
+    tasks_.pop_front();
+    lock.unlock();
+    task();
+    lock.lock();
+  }
+}
+
+namespace {
+
+void TransferPage(DiskManager *disk_manager, PageIORequest *request) {
+  if (request->type_ == PageIORequest::READ) {
+    disk_manager->ReadPage(request->page_id_, request->data_);
+  } else {
+    disk_manager->WritePage(request->page_id_, request->data_);
+  }
+}
+
+/** The SYNC backend, every transfer is done in Submit. */
+class SyncPageIOQueue : public PageIOQueue {
+ public:
+  SyncPageIOQueue(DiskManager *disk_manager, size_t depth) : PageIOQueue(depth), disk_manager_(disk_manager) {}
+
+  void Submit(const std::vector<PageIORequest *> &requests) override {
+    for (auto request : requests) {
+      TransferPage(disk_manager_, request);
+      done_.push_back(request);
+    }
+    in_flight_ += requests.size();
+  }
+
+  size_t Reap(std::vector<PageIORequest *> *completed, size_t /* min_complete */) override {
+    size_t count = done_.size();
+    completed->insert(completed->end(), done_.begin(), done_.end());
+    done_.clear();
+    in_flight_ -= count;
+    return count;
+  }
+
+  IOBackend GetBackend() const override { return IOBackend::SYNC; }
+
+ private:
+  DiskManager *disk_manager_;
+  std::vector<PageIORequest *> done_;
+};
+
+/** The THREAD_POOL backend, every transfer is a blocking task of the shared I/O thread pool. */
+class ThreadPoolPageIOQueue : public PageIOQueue {
+ public:
+  ThreadPoolPageIOQueue(DiskManager *disk_manager, IOThreadPool *pool, size_t depth)
+      : PageIOQueue(depth), disk_manager_(disk_manager), pool_(pool) {}
+
+  ~ThreadPoolPageIOQueue() override {
+    std::vector<PageIORequest *> completed;
+    Reap(&completed, in_flight_);
+  }
+
+  void Submit(const std::vector<PageIORequest *> &requests) override {
+    for (auto request : requests) {
+      in_flight_++;
+      pool_->Post([this, request] {
+        TransferPage(disk_manager_, request);
+        // Notify under the latch, the queue may be destroyed as soon as its owner sees the request done.
+        std::scoped_lock<std::mutex> lock(latch_);
+        done_.push_back(request);
+        cv_.notify_one();
+      });
+    }
+  }
+
+  size_t Reap(std::vector<PageIORequest *> *completed, size_t min_complete) override {
+    min_complete = std::min(min_complete, in_flight_);
+    std::unique_lock<std::mutex> lock(latch_);
+    cv_.wait(lock, [this, min_complete] { return done_.size() >= min_complete; });
+    size_t count = done_.size();
+    completed->insert(completed->end(), done_.begin(), done_.end());
+    done_.clear();
+    in_flight_ -= count;
+    return count;
+  }
+
+  IOBackend GetBackend() const override { return IOBackend::THREAD_POOL; }
+
+ private:
+  DiskManager *disk_manager_;
+  IOThreadPool *pool_;
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::vector<PageIORequest *> done_;
+};
+
+int IoUringSetup(unsigned entries, struct io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int IoUringRegister(int ring_fd, unsigned opcode, void *arg, unsigned nr_args) {
+  return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+}  // namespace
+
+/**
+ * The IO_URING backend. It talks to the kernel through the raw system calls and the shared rings, so it needs no
+ * liburing. Requests that the ring cannot take as they are, see DiskManager::PrepareTransfer, are done synchronously
+ * in Submit, short transfers are finished synchronously when they are reaped. If io_uring_enter fails in a way that
+ * retrying cannot fix, the requests in the ring are finished synchronously and the queue works like the SYNC backend
+ * from then on.
+ */
+class IoUringPageIOQueue : public PageIOQueue {
+ public:
+  /** @return nullptr if the kernel does not support io_uring or the read and write operations */
+  static std::unique_ptr<PageIOQueue> Open(DiskManager *disk_manager, size_t depth) {
+    std::unique_ptr<IoUringPageIOQueue> queue(new IoUringPageIOQueue(disk_manager, depth));
+    if (!queue->Setup()) {
+      return nullptr;
+    }
+    return queue;
+  }
+
+  ~IoUringPageIOQueue() override {
+    if (ring_fd_ >= 0) {
+      std::vector<PageIORequest *> completed;
+      Reap(&completed, in_flight_);
+    }
+    if (sqes_ != nullptr) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ptr_ != nullptr && cq_ptr_ != sq_ptr_) {
+      munmap(cq_ptr_, cq_size_);
+    }
+    if (sq_ptr_ != nullptr) {
+      munmap(sq_ptr_, sq_size_);
+    }
+    if (ring_fd_ >= 0) {
+      close(ring_fd_);
+    }
+  }
+
+  void Submit(const std::vector<PageIORequest *> &requests) override {
+    for (auto request : requests) {
+      in_flight_++;
+      if (!fallen_back_ && ring_in_flight_ + to_submit_ == entries_) {
+        // The ring is full, make room by moving completions aside until they are reaped.
+        SubmitPending();
+        WaitRing(1);
+      }
+      int fd;
+      off_t offset;
+      if (fallen_back_ || !disk_manager_->PrepareTransfer(request, &fd, &offset)) {
+        TransferPage(disk_manager_, request);
+        done_.push_back(request);
+        continue;
+      }
+      unsigned slot = free_slots_.back();
+      free_slots_.pop_back();
+      ring_requests_[slot] = request;
+      unsigned tail = *sq_tail_;
+      unsigned index = tail & *sq_mask_;
+      struct io_uring_sqe *sqe = &sqes_[index];
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = request->type_ == PageIORequest::READ ? IORING_OP_READ : IORING_OP_WRITE;
+      sqe->fd = fd;
+      sqe->off = offset;
+      sqe->addr = reinterpret_cast<uintptr_t>(request->data_);
+      sqe->len = PAGE_SIZE;
+      sqe->user_data = slot;
+      sq_array_[index] = index;
+      // The kernel reads the entry once it sees the new tail.
+      __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+      to_submit_++;
+    }
+    SubmitPending();
+  }
+
+  size_t Reap(std::vector<PageIORequest *> *completed, size_t min_complete) override {
+    min_complete = std::min(min_complete, in_flight_);
+    if (done_.size() < min_complete) {
+      WaitRing(min_complete - done_.size());
+    } else {
+      WaitRing(0);
+    }
+    size_t count = done_.size();
+    completed->insert(completed->end(), done_.begin(), done_.end());
+    done_.clear();
+    in_flight_ -= count;
+    return count;
+  }
+
+  IOBackend GetBackend() const override { return fallen_back_ ? IOBackend::SYNC : IOBackend::IO_URING; }
+
+ private:
+  IoUringPageIOQueue(DiskManager *disk_manager, size_t depth) : PageIOQueue(depth), disk_manager_(disk_manager) {}
+
+  bool Setup() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = IoUringSetup(static_cast<unsigned>(depth_), &params);
+    if (ring_fd_ < 0) {
+      return false;
+    }
+    entries_ = params.sq_entries;
+    ring_requests_.assign(entries_, nullptr);
+    for (unsigned slot = entries_; slot > 0; slot--) {
+      free_slots_.push_back(slot - 1);
+    }
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+    sq_ptr_ = Map(sq_size_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == nullptr) {
+      return false;
+    }
+    cq_ptr_ = single_mmap ? sq_ptr_ : Map(cq_size_, IORING_OFF_CQ_RING);
+    if (cq_ptr_ == nullptr) {
+      return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = static_cast<struct io_uring_sqe *>(Map(sqes_size_, IORING_OFF_SQES));
+    if (sqes_ == nullptr) {
+      return false;
+    }
+    auto *sq = static_cast<char *>(sq_ptr_);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    auto *cq = static_cast<char *>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+    return SupportsReadWrite();
+  }
+
+  void *Map(size_t size, off_t offset) {
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+  }
+
+  /** IORING_OP_READ and IORING_OP_WRITE came after io_uring itself, so did the probe that tells whether they exist. */
+  bool SupportsReadWrite() {
+    size_t size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    auto buffer = std::make_unique<char[]>(size);
+    memset(buffer.get(), 0, size);
+    auto *probe = reinterpret_cast<struct io_uring_probe *>(buffer.get());
+    if (IoUringRegister(ring_fd_, IORING_REGISTER_PROBE, probe, 256) < 0) {
+      return false;
+    }
+    for (auto op : {IORING_OP_READ, IORING_OP_WRITE}) {
+      if (op > probe->last_op || (probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void SubmitPending() {
+    while (to_submit_ > 0) {
+      int submitted = IoUringEnter(ring_fd_, to_submit_, 0, 0);
+      if (submitted < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if ((errno == EAGAIN || errno == EBUSY) && ring_in_flight_ > 0) {
+          WaitRing(1);
+          continue;
+        }
+        FallBack(errno);
+        return;
+      }
+      to_submit_ -= submitted;
+      ring_in_flight_ += submitted;
+    }
+  }
+
+  /** Move the completions of the ring to done_, waiting for at least min_complete of them. */
+  void WaitRing(size_t min_complete) {
+    size_t reaped = 0;
+    while (true) {
+      reaped += ReapRing();
+      if (reaped >= min_complete || ring_in_flight_ == 0) {
+        return;
+      }
+      if (IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+        FallBack(errno);
+        return;
+      }
+    }
+  }
+
+  /** Move the completions already posted to the ring to done_, without waiting. @return the number moved */
+  size_t ReapRing() {
+    size_t reaped = 0;
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+      struct io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+      auto slot = static_cast<unsigned>(cqe->user_data);
+      PageIORequest *request = ring_requests_[slot];
+      ring_requests_[slot] = nullptr;
+      free_slots_.push_back(slot);
+      if (cqe->res != PAGE_SIZE) {
+        if (cqe->res < 0) {
+          LOG(ERROR) << "I/O error while " << (request->type_ == PageIORequest::READ ? "reading" : "writing")
+                     << " page " << request->page_id_ << ": " << strerror(-cqe->res);
+        }
+        // Short transfers only happen at the end of the file, finish them the synchronous way.
+        TransferPage(disk_manager_, request);
+      } else {
+        disk_manager_->FinishTransfer(request);
+      }
+      done_.push_back(request);
+      ring_in_flight_--;
+      reaped++;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return reaped;
+  }
+
+  /**
+   * io_uring_enter failed with an error other than EINTR, EAGAIN or EBUSY, the ring cannot be trusted any more. Take
+   * the completions already posted, finish every other request of the ring synchronously and stop using the ring.
+   */
+  void FallBack(int error) {
+    LOG(ERROR) << "io_uring_enter failed: " << strerror(error) << ", doing the transfers of the queue synchronously";
+    ReapRing();
+    for (auto &request : ring_requests_) {
+      if (request != nullptr) {
+        TransferPage(disk_manager_, request);
+        done_.push_back(request);
+        request = nullptr;
+      }
+    }
+    ring_in_flight_ = 0;
+    to_submit_ = 0;
+    fallen_back_ = true;
+  }
+
+  DiskManager *disk_manager_;
+  int ring_fd_{-1};
+  unsigned entries_{0};
+  size_t ring_in_flight_{0};  // submitted to the kernel, completion not seen yet
+  unsigned to_submit_{0};     // queued in the submission ring, not submitted yet
+  bool fallen_back_{false};   // the ring failed, every transfer is done synchronously
+  // The request in each slot of the ring, the slot is the user_data of its submission and completion entries.
+  std::vector<PageIORequest *> ring_requests_;
+  std::vector<unsigned> free_slots_;
+  std::vector<PageIORequest *> done_;
+  void *sq_ptr_{nullptr};
+  void *cq_ptr_{nullptr};
+  size_t sq_size_{0};
+  size_t cq_size_{0};
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  struct io_uring_sqe *sqes_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  struct io_uring_cqe *cqes_{nullptr};
+};
+
+std::unique_ptr<PageIOQueue> PageIOQueue::Create(DiskManager *disk_manager, size_t depth, IOBackend backend) {
+  depth = std::max<size_t>(depth, 1);
+  if (backend == IOBackend::IO_URING && !disk_manager->io_uring_unsupported_.load(std::memory_order_relaxed)) {
+    auto queue = IoUringPageIOQueue::Open(disk_manager, depth);
+    if (queue != nullptr) {
+      return queue;
+    }
+    if (!disk_manager->io_uring_unsupported_.exchange(true)) {
+      LOG(WARNING) << "io_uring is not available, using " << DEFAULT_IO_THREADS << " I/O threads instead";
+    }
+  }
+  if (backend != IOBackend::SYNC && DEFAULT_IO_THREADS > 0) {
+    return std::make_unique<ThreadPoolPageIOQueue>(disk_manager, disk_manager->GetIOThreadPool(), depth);
+  }
+  return std::make_unique<SyncPageIOQueue>(disk_manager, depth);
+}
@@ -8,50 +8,61 @@ bool TableHeap::InsertTuple(Row &row, Txn *txn) {
   if (tuple_size > TablePage::SIZE_MAX_ROW) {
     return false;
   }
-
-  page_id_t insert_page_id = (last_page_id != INVALID_PAGE_ID) ? last_page_id : first_page_id_;
-  TablePage *page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(insert_page_id));
-
-  // 如果 page 是空的，新建一个
-  if (page == nullptr || buffer_pool_manager_->IsPageFree(insert_page_id)) {
-    insert_page_id = INVALID_PAGE_ID;
+  FreeSpaceMap *free_space_map = GetFreeSpaceMap();
+  if (free_space_map == nullptr) {
+    return false;
   }
 
-  // 从最后页开始试图插入
+  // 先试上次插入的页，放不下就把它剩余的空间记入空闲空间表，再从表中找一个放得下的页
+  page_id_t insert_page_id = (last_page_id != INVALID_PAGE_ID) ? last_page_id : free_space_map->GetLastHeapPageId();
   while (insert_page_id != INVALID_PAGE_ID) {
-    page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(insert_page_id));
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(insert_page_id));
     if (page == nullptr) {
       return false;
     }
-
-    if (page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)) {
-      buffer_pool_manager_->UnpinPage(insert_page_id, true);
+    page->WLatch();
+    bool inserted = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+    uint32_t free_space = page->GetFreeSpaceRemaining();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(insert_page_id, inserted);
+    if (inserted) {
       last_page_id = insert_page_id;
       return true;
     }
-
-    page_id_t next_page_id = page->GetNextPageId();
-    buffer_pool_manager_->UnpinPage(insert_page_id, false);
-
-    insert_page_id = next_page_id;
+    // 记下真实的剩余空间后，这一页不会再被找到
+    free_space_map->Update(insert_page_id, free_space);
+    insert_page_id = free_space_map->FindPage(TablePage::GetSpaceNeeded(tuple_size));
   }
 
-  // 如果没有空页可插入，创建新页
+  // 没有放得下的页，在页链表末尾追加新页。先取到尾页再分配，取不到尾页就接不上新页
+  page_id_t tail_page_id = free_space_map->GetLastHeapPageId();
+  TablePage *tail_page = nullptr;
+  if (tail_page_id != INVALID_PAGE_ID) {
+    tail_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(tail_page_id));
+    if (tail_page == nullptr) {
+      return false;
+    }
+  } else if (first_page_id_ != INVALID_PAGE_ID) {
+    return false;
+  }
   page_id_t new_page_id;
-  TablePage *new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id));
+  TablePage *new_page =
+      reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id, TableHeapSegmentId(first_page_id_)));
   if (new_page == nullptr) {
+    if (tail_page != nullptr) {
+      buffer_pool_manager_->UnpinPage(tail_page_id, false);
+    }
     return false;
   }
 
-  new_page->Init(new_page_id, last_page_id, log_manager_, txn);
-
-  if (last_page_id != INVALID_PAGE_ID) {
-    TablePage *last_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id));
-    if (last_page != nullptr) {
-      last_page->SetNextPageId(new_page_id);
-      buffer_pool_manager_->UnpinPage(last_page_id, true);
-    }
+  new_page->Init(new_page_id, tail_page_id, log_manager_, txn);
+  if (tail_page != nullptr) {
+    tail_page->WLatch();
+    tail_page->SetNextPageId(new_page_id);
+    tail_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(tail_page_id, true);
   }
+  free_space_map->SetLastHeapPageId(new_page_id);
 
   if (first_page_id_ == INVALID_PAGE_ID) {
     first_page_id_ = new_page_id;
@@ -62,11 +73,10 @@ bool TableHeap::InsertTuple(Row &row, Txn *txn) {
 
   // 插入新页
   bool inserted = new_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
-  buffer_pool_manager_->UnpinPage(new_page_id, inserted);
+  buffer_pool_manager_->UnpinPage(new_page_id, true);
   return inserted;
 }
 
-
 bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
   // Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
@@ -76,9 +86,12 @@ bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
   }
   // Otherwise, mark the tuple as deleted.
   page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
+  bool marked = page->MarkDelete(rid, txn, lock_manager_, log_manager_);
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  if (marked) {
+    dead_tuples_++;
+  }
   return true;
 }
 
@@ -141,8 +154,15 @@ void TableHeap::ApplyDelete(const RowId &rid, Txn *txn) {
 
   page->WLatch();
   page->ApplyDelete(rid, txn, log_manager_); // 调用 TablePage 的物理删除逻辑
+  uint32_t free_space = page->GetFreeSpaceRemaining();
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true); // 标记脏页
+
+  // 腾出的空间记入空闲空间表，之后的插入可以找到这一页
+  FreeSpaceMap *free_space_map = GetFreeSpaceMap();
+  if (free_space_map != nullptr) {
+    free_space_map->Update(rid.GetPageId(), free_space);
+  }
 }
 
 void TableHeap::RollbackDelete(const RowId &rid, Txn *txn) {
@@ -187,7 +207,203 @@ void TableHeap::DeleteTable(page_id_t page_id) {
     buffer_pool_manager_->DeletePage(page_id);
   } else {
     DeleteTable(first_page_id_);
+    buffer_pool_manager_->ReleaseSegment(TableHeapSegmentId(first_page_id_));
+    if (free_space_map_ != nullptr) {
+      free_space_map_->Destroy();
+    }
+  }
+}
+
+TableHeap::VacuumStats TableHeap::Vacuum(double merge_fill, const RelocateCallback &relocate, Txn *txn) {
+  VacuumStats stats;
+  FreeSpaceMap *free_space_map = GetFreeSpaceMap();
+  if (free_space_map == nullptr) {
+    return stats;
+  }
+  dead_tuples_ = 0;
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  page_id_t page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      break;
+    }
+    page->WLatch();
+    // 1. 执行还没执行的删除，再把页压实
+    uint32_t live_bytes = 0;
+    for (uint32_t slot = 0; slot < page->GetTupleCount(); slot++) {
+      uint32_t tuple_size = page->GetTupleSize(slot);
+      if (tuple_size != 0 && TablePage::IsDeleted(tuple_size)) {
+        page->ApplyDelete(RowId(page_id, slot), txn, log_manager_);
+        stats.applied_deletes++;
+      } else if (tuple_size != 0) {
+        live_bytes += TablePage::GetSpaceNeeded(tuple_size);
+      }
+    }
+    page->Compact();
+
+    // 2. 太空的页整页搬到前一页，前一页放得下才搬
+    if (prev_page_id != INVALID_PAGE_ID && live_bytes > 0 && live_bytes < merge_fill * PAGE_SIZE) {
+      auto prev_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(prev_page_id));
+      if (prev_page != nullptr) {
+        prev_page->WLatch();
+        if (prev_page->GetFreeSpaceRemaining() >= live_bytes) {
+          for (uint32_t slot = 0; slot < page->GetTupleCount(); slot++) {
+            RowId old_rid(page_id, slot);
+            Row row(old_rid);
+            if (!page->GetTuple(&row, schema_, txn, lock_manager_)) {
+              continue;
+            }
+            if (!prev_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)) {
+              break;
+            }
+            page->ApplyDelete(old_rid, txn, log_manager_);
+            live_bytes -= TablePage::GetSpaceNeeded(row.GetSerializedSize(schema_));
+            if (relocate) {
+              relocate(row, old_rid);
+            }
+            stats.moved_tuples++;
+          }
+        }
+        uint32_t prev_free_space = prev_page->GetFreeSpaceRemaining();
+        prev_page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(prev_page_id, true);
+        free_space_map->Update(prev_page_id, prev_free_space);
+      }
+    }
+
+    // 3. 空页从页链表中摘下并释放，第一页留着
+    page_id_t next_page_id = page->GetNextPageId();
+    // 前后页都取到了才摘，否则这一页先留着，下次 vacuum 再摘
+    TablePage *prev_page = nullptr;
+    TablePage *next_page = nullptr;
+    if (prev_page_id != INVALID_PAGE_ID && live_bytes == 0) {
+      prev_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(prev_page_id));
+      if (prev_page != nullptr && next_page_id != INVALID_PAGE_ID) {
+        next_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
+        if (next_page == nullptr) {
+          buffer_pool_manager_->UnpinPage(prev_page_id, false);
+          prev_page = nullptr;
+        }
+      }
+    }
+    if (prev_page != nullptr) {
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page_id, true);
+      prev_page->WLatch();
+      prev_page->SetNextPageId(next_page_id);
+      prev_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(prev_page_id, true);
+      if (next_page != nullptr) {
+        next_page->WLatch();
+        next_page->SetPrevPageId(prev_page_id);
+        next_page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(next_page_id, true);
+      } else {
+        free_space_map->SetLastHeapPageId(prev_page_id);
+      }
+      if (last_page_id == page_id) {
+        last_page_id = INVALID_PAGE_ID;
+      }
+      free_space_map->Remove(page_id);
+      buffer_pool_manager_->DeletePage(page_id);
+      stats.freed_pages++;
+      page_id = next_page_id;
+      continue;
+    }
+    uint32_t free_space = page->GetFreeSpaceRemaining();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    free_space_map->Update(page_id, free_space);
+    prev_page_id = page_id;
+    page_id = next_page_id;
+  }
+  return stats;
+}
+
+bool TableHeap::Appender::Append(Row &row) {
+  uint32_t tuple_size = row.GetSerializedSize(table_heap_->schema_);
+  if (tuple_size > TablePage::SIZE_MAX_ROW) {
+    return false;
+  }
+  FreeSpaceMap *free_space_map = table_heap_->GetFreeSpaceMap();
+  if (free_space_map == nullptr) {
+    return false;
+  }
+  BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+  if (page_ == nullptr) {
+    page_id_t tail_page_id = free_space_map->GetLastHeapPageId();
+    if (tail_page_id == INVALID_PAGE_ID) {
+      return false;
+    }
+    page_ = reinterpret_cast<TablePage *>(buffer_pool_manager->FetchPage(tail_page_id));
+    if (page_ == nullptr) {
+      return false;
+    }
+    dirty_ = false;
+  }
+  page_->WLatch();
+  bool inserted =
+      page_->InsertTuple(row, table_heap_->schema_, txn_, table_heap_->lock_manager_, table_heap_->log_manager_);
+  if (inserted) {
+    page_->WUnlatch();
+    dirty_ = true;
+    return true;
+  }
+
+  // 尾页满了，记下它的剩余空间，在它后面接一个新页继续填
+  page_id_t new_page_id;
+  auto new_page = reinterpret_cast<TablePage *>(
+      buffer_pool_manager->NewPage(new_page_id, TableHeapSegmentId(table_heap_->first_page_id_)));
+  if (new_page == nullptr) {
+    page_->WUnlatch();
+    return false;
+  }
+  page_id_t page_id = page_->GetTablePageId();
+  new_page->Init(new_page_id, page_id, table_heap_->log_manager_, txn_);
+  page_->SetNextPageId(new_page_id);
+  uint32_t free_space = page_->GetFreeSpaceRemaining();
+  page_->WUnlatch();
+  buffer_pool_manager->UnpinPage(page_id, true);
+  free_space_map->Update(page_id, free_space);
+  free_space_map->SetLastHeapPageId(new_page_id);
+  table_heap_->total_page++;
+
+  page_ = new_page;
+  dirty_ = true;
+  page_->WLatch();
+  inserted =
+      page_->InsertTuple(row, table_heap_->schema_, txn_, table_heap_->lock_manager_, table_heap_->log_manager_);
+  page_->WUnlatch();
+  return inserted;
+}
+
+void TableHeap::Appender::Finish() {
+  if (page_ == nullptr) {
+    return;
+  }
+  page_->RLatch();
+  page_id_t page_id = page_->GetTablePageId();
+  uint32_t free_space = page_->GetFreeSpaceRemaining();
+  page_->RUnlatch();
+  table_heap_->buffer_pool_manager_->UnpinPage(page_id, dirty_);
+  page_ = nullptr;
+  if (dirty_) {
+    table_heap_->GetFreeSpaceMap()->Update(page_id, free_space);
+  }
+  // 之后的单行插入接着从尾页开始
+  table_heap_->last_page_id = page_id;
+}
+
+FreeSpaceMap *TableHeap::GetFreeSpaceMap() {
+  if (free_space_map_ == nullptr || free_space_map_->GetFirstPageId() == INVALID_PAGE_ID) {
+    page_id_t page_id = FreeSpaceMap::Build(buffer_pool_manager_, first_page_id_);
+    if (page_id == INVALID_PAGE_ID) {
+      return nullptr;
+    }
+    free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_, page_id);
   }
+  return free_space_map_.get();
 }
 
 /**
@@ -202,6 +418,7 @@ TableIterator TableHeap::Begin(Txn *txn) {
   TablePage *first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
   RowId first_rid;
   first_page->GetFirstTupleRid(&first_rid);
+  buffer_pool_manager_->ReadAhead(first_page->GetNextPageId(), TablePage::ReadNextPageId);
   buffer_pool_manager_->UnpinPage(first_page_id_, false); // 只读，不脏页
 
   return TableIterator(this, first_rid, txn);
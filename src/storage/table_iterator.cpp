@@ -72,7 +72,10 @@ TableIterator &TableIterator::operator++() {
         auto next_page=reinterpret_cast<TablePage *>(this->table_heap_->buffer_pool_manager_->FetchPage(next_page_id));
         next_page->RLatch();
         next_page->GetFirstTupleRid(&new_rid);
+        auto read_ahead_page_id = next_page->GetNextPageId();
         next_page->RUnlatch();
+        // 预读后续的页
+        table_heap_->buffer_pool_manager_->ReadAhead(read_ahead_page_id, TablePage::ReadNextPageId);
         delete this->row;
         row=new Row(new_rid);
         this->table_heap_->GetTuple(row, nullptr);
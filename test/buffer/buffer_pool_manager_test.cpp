@@ -1,8 +1,12 @@
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/page_table.h"
 
+#include <atomic>
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -71,4 +75,597 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   delete bpm;
   delete disk_manager;
-}
\ No newline at end of file
+}
+TEST(BufferPoolManagerTest, ParallelInstancesTest) {
+  const std::string db_name = "bpm_parallel_test.db";
+  const size_t buffer_pool_size = 64;
+  const size_t num_instances = 4;
+  const int num_threads = 4;
+  const int pages_per_thread = 32;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, num_instances);
+  EXPECT_EQ(num_instances, bpm->GetNumInstances());
+  EXPECT_EQ(buffer_pool_size, bpm->GetPoolSize());
+
+  // Scenario: every instance only holds a share of the frames, but consecutive page ids are spread over all of them,
+  // so the whole pool can still be filled with new pages.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    page_ids.push_back(page_id);
+  }
+  page_id_t page_id_temp;
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+  for (auto page_id : page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: concurrent threads create, write, evict and re-read pages through different instances.
+  std::vector<std::thread> threads;
+  std::vector<std::vector<page_id_t>> thread_pages(num_threads);
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < pages_per_thread; ++i) {
+        page_id_t page_id;
+        auto *page = bpm->NewPage(page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+        thread_pages[t].push_back(page_id);
+        bpm->UnpinPage(page_id, true);
+      }
+      for (auto page_id : thread_pages[t]) {
+        auto *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ("page-" + std::to_string(page_id), std::string(page->GetData()));
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page-" + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // Scenario: deleting a page returns its id to the disk manager.
+  EXPECT_TRUE(bpm->DeletePage(page_ids[0]));
+  EXPECT_TRUE(bpm->IsPageFree(page_ids[0]));
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+static void ConcurrentHitAndEvict(ReplacerType replacer_type) {
+  const std::string db_name = "bpm_hit_evict_test.db";
+  const size_t buffer_pool_size = 16;
+  const int num_pages = 64;
+  const int num_threads = 8;
+  const int rounds = 2000;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1, replacer_type);
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ(i, page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+
+  // Scenario: a few hot pages are hit lock-free all the time while cold pages keep evicting the remaining frames.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      std::default_random_engine rng(t);
+      std::uniform_int_distribution<int> dist(0, num_pages - 1);
+      for (int i = 0; i < rounds; ++i) {
+        page_id_t page_id = (i % 2 == 0) ? i % 4 : dist(rng);
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;  // every frame is pinned by the other threads
+        }
+        EXPECT_EQ(page_id, page->GetPageId());
+        EXPECT_EQ("page-" + std::to_string(page_id), std::string(page->GetData()));
+        EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ConcurrentHitAndEvictTest) { ConcurrentHitAndEvict(ReplacerType::LRU); }
+
+TEST(BufferPoolManagerTest, ConcurrentHitAndEvictClockTest) { ConcurrentHitAndEvict(ReplacerType::CLOCK); }
+
+TEST(BufferPoolManagerTest, ConcurrentHitAndEvictLRUKTest) { ConcurrentHitAndEvict(ReplacerType::LRU_K); }
+
+TEST(BufferPoolManagerTest, ConcurrentDirtyEvictTest) {
+  const std::string db_name = "bpm_dirty_evict_test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_threads = 4;
+  const int pages_per_thread = 8;
+  const int rounds = 512;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  for (int i = 0; i < num_threads * pages_per_thread; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    bpm->UnpinPage(page_id, true);
+  }
+
+  // Scenario: every fetch dirties its page, so almost every miss writes a victim back while other threads read the
+  // same pages in. Updates must survive the write-back/read-in round trips.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < rounds; ++i) {
+        page_id_t page_id = t * pages_per_thread + i % pages_per_thread;
+        Page *page = nullptr;
+        while ((page = bpm->FetchPage(page_id)) == nullptr) {
+          std::this_thread::yield();
+        }
+        ++*reinterpret_cast<int *>(page->GetData());
+        EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < num_threads * pages_per_thread; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(rounds / pages_per_thread, *reinterpret_cast<int *>(page->GetData()));
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, BackgroundFlushTest) {
+  const std::string db_name = "bpm_bg_flush_test.db";
+  const size_t buffer_pool_size = 10;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  std::vector<Page *> pages;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    pages.push_back(page);
+  }
+  auto count_dirty = [&]() {
+    size_t dirty = 0;
+    for (auto page : pages) {
+      dirty += page->IsDirty() ? 1 : 0;
+    }
+    return dirty;
+  };
+
+  // Scenario: pinned pages are never written ahead.
+  bpm->EnableBackgroundFlush(0.5, std::chrono::hours(1));
+  EXPECT_EQ(0, bpm->FlushAhead());
+  for (auto page : pages) {
+    bpm->UnpinPage(page->GetPageId(), true);
+  }
+  EXPECT_EQ(buffer_pool_size, count_dirty());
+
+  // Scenario: one round writes just enough pages to get half of the frames clean.
+  EXPECT_EQ(5, bpm->FlushAhead());
+  EXPECT_EQ(5, count_dirty());
+  EXPECT_EQ(0, bpm->FlushAhead());
+
+  // Scenario: the background writer cleans everything, and the data survives eviction.
+  bpm->EnableBackgroundFlush(1.0, std::chrono::milliseconds(1));
+  for (int i = 0; i < 1000 && count_dirty() > 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(0, count_dirty());
+  bpm->DisableBackgroundFlush();
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page-" + std::to_string(i), std::string(page->GetData()));
+    bpm->UnpinPage(i, false);
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  const std::string db_name = "bpm_prefetch_test.db";
+  const size_t buffer_pool_size = 32;
+  const int num_pages = 20;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  // Scenario: every page starts with the id of the next one, like a table heap.
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<page_id_t *>(page->GetData()) = (i + 1 < num_pages) ? i + 1 : INVALID_PAGE_ID;
+    bpm->UnpinPage(page_id, true);
+  }
+  delete bpm;
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  auto wait_resident = [&](page_id_t page_id) {
+    bpm->WaitForPrefetches();
+    return bpm->IsResident(page_id);
+  };
+
+  // Scenario: a chain prefetch reads exactly count pages along the links.
+  NextPageIdReader next_page = [](const char *data) { return *reinterpret_cast<const page_id_t *>(data); };
+  bpm->PrefetchChain(0, 5, next_page);
+  EXPECT_TRUE(wait_resident(4));
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(bpm->IsResident(i));
+  }
+  EXPECT_FALSE(bpm->IsResident(5));
+
+  // Scenario: a range prefetch skips unallocated pages, prefetched pages stay unpinned.
+  bpm->PrefetchRange(10, 20);
+  EXPECT_TRUE(wait_resident(num_pages - 1));
+  EXPECT_TRUE(bpm->IsResident(10));
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  auto *page = bpm->FetchPage(12);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(13, *reinterpret_cast<page_id_t *>(page->GetData()));
+  bpm->UnpinPage(12, false);
+  EXPECT_FALSE(bpm->IsResident(num_pages));
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, AlignedFramesTest) {
+  const std::string db_name = "bpm_aligned_test.db";
+  const size_t buffer_pool_size = 16;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  // Scenario: frames are page aligned and keep their data across eviction, with or without huge pages.
+  for (bool use_huge_pages : {false, true}) {
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2, DEFAULT_REPLACER_TYPE, use_huge_pages);
+    std::vector<page_id_t> page_ids;
+    for (size_t i = 0; i < buffer_pool_size * 2; ++i) {
+      page_id_t page_id;
+      auto *page = bpm->NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+      snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+      bpm->UnpinPage(page_id, true);
+      page_ids.push_back(page_id);
+    }
+    for (auto page_id : page_ids) {
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page-" + std::to_string(page_id), std::string(page->GetData()));
+      bpm->UnpinPage(page_id, false);
+    }
+    delete bpm;
+  }
+
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, StatsTest) {
+  const std::string db_name = "bpm_stats_test.db";
+  const size_t buffer_pool_size = 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: fill the pool with dirty pages, then create two more so that two dirty victims are written back.
+  for (size_t i = 0; i < buffer_pool_size + 2; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    bpm->UnpinPage(page_id, true);
+  }
+  BufferPoolCounters stats = bpm->GetStats();
+  EXPECT_EQ(buffer_pool_size + 2, stats.new_pages_);
+  EXPECT_EQ(2, stats.evictions_);
+  EXPECT_EQ(2, stats.dirty_writebacks_);
+  EXPECT_EQ(2, stats.disk_writes_);
+  EXPECT_EQ(0, stats.hits_ + stats.misses_);
+
+  // Scenario: a resident page is a hit, an evicted one a miss that is read from disk.
+  ASSERT_NE(nullptr, bpm->FetchPage(2));
+  bpm->UnpinPage(2, false);
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  bpm->UnpinPage(0, false);
+  stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.hits_);
+  EXPECT_EQ(1, stats.misses_);
+  EXPECT_EQ(1, stats.disk_reads_);
+  EXPECT_EQ(3, stats.evictions_);
+  EXPECT_DOUBLE_EQ(0.5, stats.HitRate());
+
+  EXPECT_TRUE(bpm->FlushPage(0));
+  EXPECT_TRUE(bpm->DeletePage(0));
+  stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.flushes_);
+  EXPECT_EQ(1, stats.deleted_pages_);
+  EXPECT_EQ(stats.dirty_writebacks_ + stats.flushes_, stats.disk_writes_);
+
+  bpm->ResetStats();
+  stats = bpm->GetStats();
+  EXPECT_EQ(0, stats.new_pages_ + stats.evictions_ + stats.hits_ + stats.misses_ + stats.disk_writes_);
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "bpm_resize_test.db";
+  const size_t buffer_pool_size = 8;
+  const size_t max_pool_size = 32;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2, DEFAULT_REPLACER_TYPE, DEFAULT_USE_HUGE_PAGES,
+                                    max_pool_size);
+  EXPECT_EQ(buffer_pool_size, bpm->GetPoolSize());
+  EXPECT_EQ(max_pool_size, bpm->GetMaxPoolSize());
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+
+  // Scenario: shrinking evicts and writes back unpinned pages, but keeps the frames of pinned ones.
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  EXPECT_EQ(2, bpm->Resize(0));
+  EXPECT_EQ(buffer_pool_size - 2, bpm->GetStats().dirty_writebacks_);
+  EXPECT_TRUE(bpm->IsResident(0));
+  EXPECT_TRUE(bpm->IsResident(1));
+  EXPECT_FALSE(bpm->IsResident(2));
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id));
+  bpm->UnpinPage(0, false);
+  bpm->UnpinPage(1, false);
+
+  // Scenario: growing makes room again, up to the limit, and the evicted pages come back from disk.
+  EXPECT_EQ(max_pool_size, bpm->Resize(max_pool_size * 2));
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page-" + std::to_string(i), std::string(page->GetData()));
+  }
+  uint64_t evictions = bpm->GetStats().evictions_;
+  for (size_t i = buffer_pool_size; i < max_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  }
+  EXPECT_EQ(evictions, bpm->GetStats().evictions_);
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id));
+  for (page_id_t i = 0; i < static_cast<page_id_t>(max_pool_size); ++i) {
+    bpm->UnpinPage(i, false);
+  }
+  EXPECT_EQ(16, bpm->Resize(16));
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ConcurrentResizeTest) {
+  const std::string db_name = "bpm_concurrent_resize_test.db";
+  const size_t buffer_pool_size = 32;
+  const int num_threads = 4;
+  const int pages_per_thread = 16;
+  const int rounds = 2000;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2, DEFAULT_REPLACER_TYPE, DEFAULT_USE_HUGE_PAGES,
+                                    buffer_pool_size * 4);
+  for (int i = 0; i < num_threads * pages_per_thread; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    bpm->UnpinPage(page_id, true);
+  }
+
+  // Scenario: every thread keeps counters in its own pages while the pool is shrunk and grown underneath.
+  std::atomic<bool> done{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      std::default_random_engine rng(t);
+      std::uniform_int_distribution<int> dist(0, pages_per_thread - 1);
+      std::vector<uint32_t> expected(pages_per_thread, 0);
+      for (int i = 0; i < rounds; ++i) {
+        int slot = dist(rng);
+        page_id_t page_id = t * pages_per_thread + slot;
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;  // the pool is at its smallest and every frame is pinned
+        }
+        auto *counter = reinterpret_cast<uint32_t *>(page->GetData());
+        EXPECT_EQ(expected[slot], *counter);
+        *counter = ++expected[slot];
+        EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+      }
+    });
+  }
+  std::thread resizer([&]() {
+    for (size_t size = 2; !done; size = (size * 3) % (buffer_pool_size * 4)) {
+      bpm->Resize(size);
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  done = true;
+  resizer.join();
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+  const std::string db_name = "bpm_flush_all_test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_pages = 48;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 4);
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    // Every third page stays clean, and is never written.
+    bpm->UnpinPage(page_id, i % 3 != 0);
+  }
+
+  // Scenario: only dirty pages are written, a pinned page is written too and stays pinned.
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  EXPECT_EQ(num_pages - num_pages / 3, bpm->FlushAllPages());
+  EXPECT_EQ(0, bpm->FlushAllPages());
+  EXPECT_FALSE(bpm->CheckAllUnpinned());
+  bpm->UnpinPage(1, false);
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  BufferPoolCounters stats = bpm->GetStats();
+  EXPECT_EQ(num_pages - num_pages / 3, stats.flushes_);
+  EXPECT_EQ(stats.flushes_, stats.disk_writes_);
+  delete bpm;
+  delete disk_manager;
+
+  disk_manager = new DiskManager(db_name);
+  char buffer[PAGE_SIZE];
+  for (int i = 0; i < num_pages; ++i) {
+    disk_manager->ReadPage(i, buffer);
+    EXPECT_EQ(i % 3 == 0 ? "" : "page-" + std::to_string(i), std::string(buffer));
+  }
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, PageTableTombstoneTest) {
+  PageTable table(8);
+  // 127 and INVALID_PAGE_ID hash to the same slot, the erased entry leaves a tombstone on the probe path of -1
+  table.Insert(127, 3);
+  table.Erase(127);
+  EXPECT_EQ(INVALID_FRAME_ID, table.Find(INVALID_PAGE_ID));
+  table.Erase(INVALID_PAGE_ID);
+  EXPECT_EQ(0, table.Size());
+  table.Insert(127, 5);
+  EXPECT_EQ(5, table.Find(127));
+  EXPECT_EQ(1, table.Size());
+
+  const std::string db_name = "bpm_invalid_page_test.db";
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(8, disk_manager);
+  for (int i = 0; i < 4; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    bpm->UnpinPage(page_id, false);
+    EXPECT_TRUE(bpm->DeletePage(page_id));
+  }
+  // Scenario: lookups of INVALID_PAGE_ID never reach a frame, even after pages were erased from the page table.
+  EXPECT_EQ(nullptr, bpm->FetchPage(INVALID_PAGE_ID));
+  EXPECT_FALSE(bpm->UnpinPage(INVALID_PAGE_ID, false));
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, WarmStartTest) {
+  const std::string db_name = "bpm_warm_start_test.db";
+  const std::string hot_pages_file = "bpm_warm_start_test.db.hot";
+  const size_t buffer_pool_size = 16;
+  const int num_pages = 64;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+  // Scenario: the last pages touched are the hot set, saved hottest first.
+  for (page_id_t page_id : {7, 4, 11, 2}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+  ASSERT_TRUE(bpm->SaveHotPages(hot_pages_file));
+  delete bpm;
+
+  // Scenario: a smaller pool loads only the hottest pages that fit, in the background.
+  bpm = new BufferPoolManager(4, disk_manager, 2);
+  ASSERT_TRUE(bpm->LoadHotPages(hot_pages_file));
+  bpm->WaitForWarmUp();
+  WarmUpProgress progress = bpm->GetWarmUpProgress();
+  EXPECT_FALSE(progress.running_);
+  EXPECT_EQ(4, progress.total_);
+  EXPECT_EQ(4, progress.loaded_);
+  for (page_id_t page_id : {7, 4, 11, 2}) {
+    EXPECT_TRUE(bpm->IsResident(page_id));
+  }
+  EXPECT_EQ(4, bpm->GetStats().disk_reads_);
+  EXPECT_EQ(0, bpm->GetStats().misses_);
+  auto *page = bpm->FetchPage(11);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ("page-11", std::string(page->GetData()));
+  bpm->UnpinPage(11, false);
+  EXPECT_FALSE(bpm->LoadHotPages(db_name));
+  delete bpm;
+
+  delete disk_manager;
+  remove(db_name.c_str());
+  remove(hot_pages_file.c_str());
+}
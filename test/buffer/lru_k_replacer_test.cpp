@@ -0,0 +1,190 @@
+#include "buffer/lru_k_replacer.h"
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+  int value;
+
+  // Scenario: frames 4-6 are loaded, then frames 1-3 are loaded, then frames 4-6 are touched again.
+  for (int i : {4, 5, 6, 1, 2, 3, 4, 5, 6}) {
+    lru_k_replacer.Pin(i);
+  }
+  for (int i = 6; i >= 1; i--) {
+    lru_k_replacer.Unpin(i);
+  }
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: once-touched frames are evicted first, in LRU order, even though they were unpinned last.
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+
+  // Scenario: frame 1 is touched again after frames 2 and 3 were loaded, which makes it hot as well.
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+
+  // Scenario: repeated pins of a newly loaded frame without a load in between count as a single access.
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Unpin(2);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+
+  // Scenario: a removed frame forgets its history.
+  lru_k_replacer.Remove(4);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+  lru_k_replacer.Unpin(4);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+
+  // Scenario: hot frames go in LRU order.
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+}
+
+TEST(LRUKReplacerTest, HotFramesTest) {
+  // Scenario: every policy lists its frames in the order opposite to the one it evicts them in.
+  std::vector<std::unique_ptr<Replacer>> replacers;
+  replacers.emplace_back(new LRUReplacer(8));
+  replacers.emplace_back(new CLOCKReplacer(8));
+  replacers.emplace_back(new LRUKReplacer(8, 2));
+  for (auto &replacer : replacers) {
+    for (int i : {0, 1, 2, 3, 4, 2, 3}) {
+      replacer->Pin(i);
+    }
+    for (int i : {3, 2, 1, 4, 0}) {
+      replacer->Unpin(i);
+    }
+    int value;
+    ASSERT_TRUE(replacer->Victim(&value));
+    std::vector<frame_id_t> frames;
+    replacer->GetHotFrames(&frames);
+    ASSERT_EQ(4, frames.size());
+    std::vector<frame_id_t> victims;
+    while (replacer->Victim(&value)) {
+      victims.push_back(value);
+    }
+    EXPECT_EQ(std::vector<frame_id_t>(frames.rbegin(), frames.rend()), victims);
+  }
+}
+
+/**
+ * Drives a replacer the way a buffer pool instance does (pin on every access, unpin on release, victim on a miss) and
+ * counts hits, without any disk I/O.
+ */
+class SimulatedPool {
+ public:
+  SimulatedPool(Replacer *replacer, size_t pool_size) : replacer_(replacer), frame_page_(pool_size, INVALID_PAGE_ID) {
+    for (size_t i = 0; i < pool_size; i++) {
+      free_frames_.push_back(static_cast<frame_id_t>(i));
+    }
+  }
+
+  bool Access(page_id_t page_id) {
+    auto it = page_table_.find(page_id);
+    bool hit = it != page_table_.end();
+    frame_id_t frame_id;
+    if (hit) {
+      frame_id = it->second;
+    } else {
+      if (!free_frames_.empty()) {
+        frame_id = free_frames_.back();
+        free_frames_.pop_back();
+      } else {
+        EXPECT_TRUE(replacer_->Victim(&frame_id));
+        page_table_.erase(frame_page_[frame_id]);
+      }
+      frame_page_[frame_id] = page_id;
+      page_table_[page_id] = frame_id;
+    }
+    replacer_->Pin(frame_id);
+    replacer_->Unpin(frame_id);
+    return hit;
+  }
+
+ private:
+  Replacer *replacer_;
+  std::vector<page_id_t> frame_page_;
+  std::vector<frame_id_t> free_frames_;
+  std::unordered_map<page_id_t, frame_id_t> page_table_;
+};
+
+/**
+ * Benchmark: point lookups on a B+ tree (root, internal, leaf) run next to a full scan of a table much larger than the
+ * pool. Prints the index hit rate during the scan for every policy.
+ */
+static double IndexHitRateUnderScan(ReplacerType replacer_type) {
+  const size_t pool_size = 1024;
+  const int num_internals = 16;
+  const int num_leaves = 768;
+  const int scan_pages = 50000;
+  const int tuples_per_page = 10;
+  const page_id_t table_first_page = 1 + num_internals + num_leaves;
+
+  std::unique_ptr<Replacer> replacer;
+  switch (replacer_type) {
+    case ReplacerType::LRU:
+      replacer.reset(new LRUReplacer(pool_size));
+      break;
+    case ReplacerType::CLOCK:
+      replacer.reset(new CLOCKReplacer(pool_size));
+      break;
+    case ReplacerType::LRU_K:
+      replacer.reset(new LRUKReplacer(pool_size));
+      break;
+  }
+  SimulatedPool pool(replacer.get(), pool_size);
+  std::default_random_engine rng(0);
+  std::uniform_int_distribution<int> leaf_dist(0, num_leaves - 1);
+
+  auto lookup = [&]() {
+    int leaf = leaf_dist(rng);
+    int hits = pool.Access(0);
+    hits += pool.Access(1 + leaf % num_internals);
+    hits += pool.Access(1 + num_internals + leaf);
+    return hits;
+  };
+
+  // Warm up the index.
+  for (int i = 0; i < 20000; i++) {
+    lookup();
+  }
+
+  // One lookup per scanned page, while the scan walks every tuple of every page.
+  int index_hits = 0;
+  int index_accesses = 0;
+  for (int p = 0; p < scan_pages; p++) {
+    for (int t = 0; t < tuples_per_page; t++) {
+      pool.Access(table_first_page + p);
+    }
+    index_hits += lookup();
+    index_accesses += 3;
+  }
+  return static_cast<double>(index_hits) / index_accesses;
+}
+
+TEST(LRUKReplacerTest, ScanResistanceBenchmark) {
+  double lru = IndexHitRateUnderScan(ReplacerType::LRU);
+  double clock = IndexHitRateUnderScan(ReplacerType::CLOCK);
+  double lru_k = IndexHitRateUnderScan(ReplacerType::LRU_K);
+  printf("index hit rate during a full scan: LRU %.3f, CLOCK %.3f, LRU-K %.3f\n", lru, clock, lru_k);
+  EXPECT_GT(lru_k, 0.99);
+  EXPECT_GT(lru_k, lru);
+  EXPECT_GT(lru_k, clock);
+}
@@ -40,4 +40,30 @@ TEST(LRUReplacerTest, SampleTest) {
   EXPECT_EQ(6, value);
   lru_replacer.Victim(&value);
   EXPECT_EQ(4, value);
-}
\ No newline at end of file
+}
+TEST(LRUReplacerTest, RemoveTest) {
+  LRUReplacer lru_replacer(7);
+  int value;
+
+  // Scenario: removing a frame that is not in the replacer changes nothing.
+  lru_replacer.Unpin(0);
+  lru_replacer.Remove(1);
+  EXPECT_EQ(1, lru_replacer.Size());
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  lru_replacer.Remove(0);
+  EXPECT_EQ(0, lru_replacer.Size());
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+
+  // Scenario: a removed frame is never victimized, the others keep their order.
+  lru_replacer.Unpin(2);
+  lru_replacer.Unpin(3);
+  lru_replacer.Unpin(4);
+  lru_replacer.Remove(3);
+  EXPECT_EQ(2, lru_replacer.Size());
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+}
@@ -1,5 +1,8 @@
 #include "catalog/catalog.h"
 
+#include <fstream>
+#include <iterator>
+
 #include "common/instance.h"
 #include "gtest/gtest.h"
 #include "utils/utils.h"
@@ -126,4 +129,80 @@ TEST(CatalogTest, CatalogIndexTest) {
     ASSERT_EQ(rid.Get(), ret_02[i].Get());
   }
   delete db_02;
-}
\ No newline at end of file
+}
+static std::string ReadFile(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+TEST(CatalogTest, ReadOnlyMappedTest) {
+  auto db_01 = new DBStorageEngine(db_file_name, true);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  Txn txn;
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, db_01->catalog_mgr_->CreateTable("table-1", schema.get(), &txn, table_info));
+  IndexInfo *index_info = nullptr;
+  std::vector<std::string> index_keys{"id"};
+  ASSERT_EQ(DB_SUCCESS, db_01->catalog_mgr_->CreateIndex("table-1", "index-1", index_keys, &txn, index_info, "bptree"));
+  const int row_nums = 2000;
+  for (int i = 0; i < row_nums; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i),
+                              Field(TypeId::kTypeChar, const_cast<char *>("minisql"), 7, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_info->GetTableHeap()->InsertTuple(row, &txn));
+    std::vector<Field> key_fields{Field(TypeId::kTypeInt, i)};
+    Row key(key_fields);
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->InsertEntry(key, row.GetRowId(), &txn));
+  }
+  delete db_01;
+  std::string db_path = "./databases/" + db_file_name;
+  std::string image = ReadFile(db_path);
+
+  auto db_02 = new DBStorageEngine(db_file_name, false, DEFAULT_BUFFER_POOL_SIZE, DEFAULT_BUFFER_POOL_INSTANCES,
+                                   DEFAULT_REPLACER_TYPE, DEFAULT_DURABILITY_MODE, DEFAULT_PAGE_COMPRESSION, true);
+  ASSERT_TRUE(db_02->IsReadOnly());
+  ASSERT_TRUE(db_02->disk_mgr_->IsMapped());
+  auto *bpm = db_02->bpm_;
+  ASSERT_EQ(DB_SUCCESS, db_02->catalog_mgr_->GetTable("table-1", table_info));
+  ASSERT_EQ(DB_SUCCESS, db_02->catalog_mgr_->GetIndex("table-1", "index-1", index_info));
+  // Scenario: scans and index lookups read the mapped pages.
+  int count = 0;
+  for (auto it = table_info->GetTableHeap()->Begin(&txn); it != table_info->GetTableHeap()->End(); ++it) {
+    ASSERT_EQ(std::to_string(count), it->GetField(0)->toString());
+    count++;
+  }
+  EXPECT_EQ(row_nums, count);
+  for (int i = 0; i < row_nums; i += 97) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    Row key(fields);
+    std::vector<RowId> result;
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(key, result, &txn));
+    ASSERT_EQ(1, result.size());
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  // Scenario: a fetched page is the page in the mapping, not a copy.
+  page_id_t page_id = table_info->GetRootPageId();
+  Page *page = bpm->FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(db_02->disk_mgr_->GetPageView(page_id), page->GetData());
+  EXPECT_EQ(page, bpm->FetchPage(page_id));
+  EXPECT_EQ(2, page->GetPinCount());
+  char copy[PAGE_SIZE];
+  db_02->disk_mgr_->ReadPage(page_id, copy);
+  EXPECT_EQ(0, memcmp(copy, page->GetData(), PAGE_SIZE));
+  bpm->PrefetchRange(page_id, 16);
+  // Scenario: writes are refused.
+  EXPECT_FALSE(bpm->UnpinPage(page_id, true));
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  EXPECT_FALSE(bpm->UnpinPage(page_id, false));
+  page_id_t new_page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(new_page_id));
+  EXPECT_FALSE(bpm->DeletePage(page_id));
+  db_02->disk_mgr_->WritePage(page_id, copy);
+  EXPECT_EQ(0, bpm->FlushAllPages());
+  delete db_02;
+  // Scenario: the db file is left exactly as it was.
+  EXPECT_EQ(image, ReadFile(db_path));
+}
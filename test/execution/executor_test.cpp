@@ -8,6 +8,14 @@
 #include "executor/plans/values_plan.h"
 #include "executor_test_util.h"  // NOLINT
 
+#include <fstream>
+#include <map>
+
+extern "C" {
+int yyparse(void);
+#include "parser/minisql_lex.h"
+}
+
 // SELECT id FROM table-1 WHERE id < 500
 TEST_F(ExecutorTest, SimpleSeqScanTest) {
   // Construct query plan
@@ -155,3 +163,176 @@ TEST_F(ExecutorTest, SimpleUpdateTest) {
     ASSERT_TRUE(row.GetField(1)->CompareEquals(Field(kTypeChar, const_cast<char *>("minisql"), 7, false)));
   }
 }
+
+/** Parse and run one statement the way the shell does. */
+static dberr_t ExecuteSql(ExecuteEngine *engine, const std::string &sql) {
+  YY_BUFFER_STATE bp = yy_scan_string(sql.c_str());
+  yy_switch_to_buffer(bp);
+  MinisqlParserInit();
+  yyparse();
+  dberr_t result = MinisqlParserGetError() ? DB_FAILED : engine->Execute(MinisqlGetParserRootNode());
+  MinisqlParserFinish();
+  yy_delete_buffer(bp);
+  yylex_destroy();
+  return result;
+}
+
+static dberr_t LoadCsv(ExecuteEngine *engine, const std::string &text) {
+  const std::string csv_name = "load_data_test.csv";
+  std::ofstream(csv_name, std::ios::binary | std::ios::trunc) << text;
+  dberr_t result = ExecuteSql(engine, "load data infile \"" + csv_name + "\" into table t;");
+  remove(csv_name.c_str());
+  return result;
+}
+
+/**
+ * Create and use database db_name with table t(id int, name char(16) unique, score float, primary key(id)), where id
+ * and name are not null, each with an index.
+ */
+static void CreateLoadTable(ExecuteEngine *engine, const std::string &db_name) {
+  std::string db_file_name = "./databases/" + db_name + ".db";
+  remove(db_file_name.c_str());
+  ASSERT_EQ(DB_SUCCESS, ExecuteSql(engine, "create database " + db_name + ";"));
+  ASSERT_EQ(DB_SUCCESS, ExecuteSql(engine, "use " + db_name + ";"));
+  ASSERT_EQ(DB_SUCCESS,
+            ExecuteSql(engine, "create table t(id int, name char(16) unique, score float, primary key(id));"));
+}
+
+static void RemoveLoadDatabase(const std::string &db_name) {
+  std::string db_file_name = "./databases/" + db_name + ".db";
+  remove(db_file_name.c_str());
+  remove(DBStorageEngine::GetHotPagesFileName(db_file_name).c_str());
+  remove(DiskManager::GetSlotFileName(db_file_name).c_str());
+}
+
+/** The rows of t by id, read back after the engine closed the database. */
+static std::map<int32_t, Row> ScanLoadTable(DBStorageEngine *db) {
+  TableInfo *table_info = nullptr;
+  EXPECT_EQ(DB_SUCCESS, db->catalog_mgr_->GetTable("t", table_info));
+  std::map<int32_t, Row> rows;
+  TableHeap *table_heap = table_info->GetTableHeap();
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    EXPECT_TRUE(rows.emplace(it->GetField(0)->GetInt(), *it).second);
+  }
+  return rows;
+}
+
+static std::vector<RowId> ScanIndex(DBStorageEngine *db, const std::string &index_name, const Field &key) {
+  IndexInfo *index_info = nullptr;
+  EXPECT_EQ(DB_SUCCESS, db->catalog_mgr_->GetIndex("t", index_name, index_info));
+  Fields fields;
+  fields.emplace_back(key);
+  std::vector<RowId> rids;
+  index_info->GetIndex()->ScanKey(Row(fields), rids, nullptr);
+  return rids;
+}
+
+static std::vector<RowId> ScanIdIndex(DBStorageEngine *db, int32_t id) {
+  return ScanIndex(db, "PRIMARY_KEY_", Field(kTypeInt, id));
+}
+
+static std::vector<RowId> ScanNameIndex(DBStorageEngine *db, const std::string &name) {
+  return ScanIndex(db, "__Unique0", Field(kTypeChar, const_cast<char *>(name.c_str()), name.size(), true));
+}
+
+/** Every row of t is found through both indexes. */
+static void ExpectIndexed(DBStorageEngine *db, const std::map<int32_t, Row> &rows) {
+  for (auto &it : rows) {
+    std::vector<RowId> expected{it.second.GetRowId()};
+    EXPECT_EQ(expected, ScanIdIndex(db, it.first));
+    EXPECT_EQ(expected, ScanNameIndex(db, it.second.GetField(1)->toString()));
+  }
+}
+
+// LOAD DATA INFILE "load_data_test.csv" INTO TABLE t;
+TEST_F(ExecutorTest, LoadDataParseTest) {
+  const std::string db_name = "load_parse_test";
+  auto engine = std::make_unique<ExecuteEngine>();
+  CreateLoadTable(engine.get(), db_name);
+  ASSERT_EQ(DB_SUCCESS, LoadCsv(engine.get(),
+                                "1,\"a,b\",1.5\n"
+                                "2,\"say \"\"hi\"\"\",\n"
+                                "3,\"two\r\nlines\",-2\r\n"
+                                "4,\"\",3\n"
+                                "5,plain,\n"));
+  // Scenario: an unquoted empty field is null, a column that is not nullable rejects it and stops the load.
+  ASSERT_EQ(DB_FAILED, LoadCsv(engine.get(), "6,,1\n"));
+  ASSERT_EQ(DB_FAILED, LoadCsv(engine.get(), ",x,1\n"));
+  engine.reset();
+
+  auto db = std::make_unique<DBStorageEngine>(db_name + ".db", false);
+  auto rows = ScanLoadTable(db.get());
+  ASSERT_EQ(5, rows.size());
+  EXPECT_EQ("a,b", rows[1].GetField(1)->toString());
+  EXPECT_EQ(CmpBool::kTrue, rows[1].GetField(2)->CompareEquals(Field(kTypeFloat, 1.5f)));
+  EXPECT_EQ("say \"hi\"", rows[2].GetField(1)->toString());
+  EXPECT_TRUE(rows[2].GetField(2)->IsNull());
+  EXPECT_EQ("two\nlines", rows[3].GetField(1)->toString());
+  EXPECT_EQ(CmpBool::kTrue, rows[3].GetField(2)->CompareEquals(Field(kTypeFloat, -2.0f)));
+  // Scenario: a quoted empty field is an empty string, not null.
+  EXPECT_FALSE(rows[4].GetField(1)->IsNull());
+  EXPECT_EQ("", rows[4].GetField(1)->toString());
+  EXPECT_EQ("plain", rows[5].GetField(1)->toString());
+  EXPECT_TRUE(rows[5].GetField(2)->IsNull());
+  ExpectIndexed(db.get(), rows);
+  db.reset();
+  RemoveLoadDatabase(db_name);
+}
+
+TEST_F(ExecutorTest, LoadDataDuplicateKeyTest) {
+  const std::string db_name = "load_duplicate_test";
+  auto engine = std::make_unique<ExecuteEngine>();
+  CreateLoadTable(engine.get(), db_name);
+  ASSERT_EQ(DB_SUCCESS, LoadCsv(engine.get(), "1,a,1\n2,b,2\n"));
+  // Scenario: rows whose keys are already indexed, or repeat a key of the same batch, are left out of the heap and of
+  // every index. 1,d and 4,b clash with the first load, 5,e/5,f and 6,g/7,g with each other.
+  ASSERT_EQ(DB_SUCCESS, LoadCsv(engine.get(),
+                                "3,c,3\n"
+                                "1,d,4\n"
+                                "4,b,5\n"
+                                "5,e,6\n"
+                                "5,f,7\n"
+                                "6,g,8\n"
+                                "7,g,9\n"));
+  engine.reset();
+
+  auto db = std::make_unique<DBStorageEngine>(db_name + ".db", false);
+  auto rows = ScanLoadTable(db.get());
+  ASSERT_EQ(5, rows.size());
+  EXPECT_EQ("a", rows[1].GetField(1)->toString());
+  EXPECT_EQ("b", rows[2].GetField(1)->toString());
+  EXPECT_EQ(1, rows.count(3));
+  EXPECT_EQ(0, rows.count(4));
+  EXPECT_EQ(1, rows.count(5));
+  EXPECT_EQ(1, rows.count(6) + rows.count(7));
+  ExpectIndexed(db.get(), rows);
+  EXPECT_TRUE(ScanIdIndex(db.get(), 4).empty());
+  EXPECT_TRUE(ScanNameIndex(db.get(), "d").empty());
+  std::string lost_name = rows[5].GetField(1)->toString() == "e" ? "f" : "e";
+  EXPECT_TRUE(ScanNameIndex(db.get(), lost_name).empty());
+  EXPECT_TRUE(ScanIdIndex(db.get(), rows.count(6) ? 7 : 6).empty());
+  db.reset();
+  RemoveLoadDatabase(db_name);
+}
+
+TEST_F(ExecutorTest, LoadDataMalformedLineTest) {
+  const std::string db_name = "load_malformed_test";
+  auto engine = std::make_unique<ExecuteEngine>();
+  CreateLoadTable(engine.get(), db_name);
+  // Scenario: a malformed line stops the load, the rows before it stay in the table and in the indexes.
+  ASSERT_EQ(DB_FAILED, LoadCsv(engine.get(), "1,a,1\n2,b,2\n3,c,oops\n4,d,4\n"));
+  ASSERT_EQ(DB_FAILED, LoadCsv(engine.get(), "5,e,5\n6,\"f\n"));
+  engine.reset();
+
+  auto db = std::make_unique<DBStorageEngine>(db_name + ".db", false);
+  auto rows = ScanLoadTable(db.get());
+  ASSERT_EQ(3, rows.size());
+  EXPECT_EQ(1, rows.count(1));
+  EXPECT_EQ(1, rows.count(2));
+  EXPECT_EQ(1, rows.count(5));
+  ExpectIndexed(db.get(), rows);
+  EXPECT_TRUE(ScanIdIndex(db.get(), 3).empty());
+  EXPECT_TRUE(ScanNameIndex(db.get(), "c").empty());
+  db.reset();
+  RemoveLoadDatabase(db_name);
+}
@@ -0,0 +1,128 @@
+#include "page/table_page.h"
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/field.h"
+#include "record/schema.h"
+
+using Fields = std::vector<Field>;
+
+static RowId InsertRow(TablePage *page, Schema *schema, int id, uint32_t name_length = 9) {
+  char name[16];
+  memset(name, 'n', sizeof(name));
+  Fields fields{Field(TypeId::kTypeInt, id), Field(TypeId::kTypeChar, name, name_length, false)};
+  Row row(fields);
+  if (!page->InsertTuple(row, schema, nullptr, nullptr, nullptr)) {
+    return RowId();
+  }
+  return row.GetRowId();
+}
+
+static void ExpectRow(TablePage *page, Schema *schema, const RowId &rid, int id) {
+  Row row(rid);
+  ASSERT_TRUE(page->GetTuple(&row, schema, nullptr, nullptr));
+  ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, id)));
+}
+
+TEST(PageTests, TablePageFreeSlotTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 16, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  Page raw_page;
+  auto *page = reinterpret_cast<TablePage *>(&raw_page);
+  page->Init(0, INVALID_PAGE_ID, nullptr, nullptr);
+  ASSERT_TRUE(page->IsCurrentFormat());
+  std::vector<RowId> rids;
+  for (RowId rid = InsertRow(page, schema.get(), 0); rid.GetPageId() != INVALID_PAGE_ID;
+       rid = InsertRow(page, schema.get(), rids.size())) {
+    rids.push_back(rid);
+  }
+  uint32_t tuple_count = page->GetTupleCount();
+  ASSERT_EQ(rids.size(), tuple_count);
+
+  // Scenario: slots emptied by deletes are reused by inserts, last emptied first, without adding slots.
+  for (uint32_t slot : {3, 7, 11}) {
+    page->ApplyDelete(rids[slot], nullptr, nullptr);
+  }
+  for (uint32_t slot : {11, 7, 3}) {
+    RowId rid = InsertRow(page, schema.get(), 1000 + slot);
+    ASSERT_EQ(slot, rid.GetSlotNum());
+    ExpectRow(page, schema.get(), rid, 1000 + slot);
+  }
+  ASSERT_EQ(tuple_count, page->GetTupleCount());
+  ASSERT_EQ(INVALID_PAGE_ID, InsertRow(page, schema.get(), 0).GetPageId());
+
+  // Scenario: a page of the first format, whose slot array starts 12 bytes earlier, is read as it is and upgraded
+  // by the first delete, which makes room for the larger header.
+  page->Compact();
+  Page old_raw_page;
+  auto *old_page = reinterpret_cast<TablePage *>(&old_raw_page);
+  memcpy(old_page->GetData(), page->GetData(), PAGE_SIZE);
+  memmove(old_page->GetData() + 24, old_page->GetData() + 36, 8 * tuple_count);
+  ASSERT_FALSE(old_page->IsCurrentFormat());
+  for (uint32_t slot = 0; slot < tuple_count; slot++) {
+    ExpectRow(old_page, schema.get(), rids[slot], slot == 3 || slot == 7 || slot == 11 ? 1000 + slot : slot);
+  }
+  old_page->ApplyDelete(rids[5], nullptr, nullptr);
+  ASSERT_TRUE(old_page->IsCurrentFormat());
+  for (uint32_t slot = 0; slot < tuple_count; slot++) {
+    if (slot != 5) {
+      ExpectRow(old_page, schema.get(), rids[slot], slot == 3 || slot == 7 || slot == 11 ? 1000 + slot : slot);
+    }
+  }
+  RowId rid = InsertRow(old_page, schema.get(), 2000);
+  ASSERT_EQ(5, rid.GetSlotNum());
+  ExpectRow(old_page, schema.get(), rid, 2000);
+  ASSERT_EQ(tuple_count, old_page->GetTupleCount());
+}
+
+TEST(PageTests, TablePageLazyCompactionTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 16, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  Page raw_page;
+  auto *page = reinterpret_cast<TablePage *>(&raw_page);
+  page->Init(0, INVALID_PAGE_ID, nullptr, nullptr);
+  std::vector<RowId> rids;
+  for (RowId rid = InsertRow(page, schema.get(), 0); rid.GetPageId() != INVALID_PAGE_ID;
+       rid = InsertRow(page, schema.get(), rids.size())) {
+    rids.push_back(rid);
+  }
+
+  // Scenario: deletes leave the tuple bytes in place and only count them, the lowest tuple gives its bytes back.
+  uint32_t free_space = page->GetFreeSpaceRemaining();
+  Row row(rids[0]);
+  ASSERT_TRUE(page->GetTuple(&row, schema.get(), nullptr, nullptr));
+  uint32_t tuple_size = row.GetSerializedSize(schema.get());
+  for (uint32_t slot = 0; slot < rids.size(); slot += 2) {
+    page->ApplyDelete(rids[slot], nullptr, nullptr);
+  }
+  uint32_t deleted = (rids.size() + 1) / 2;
+  ASSERT_EQ(free_space + deleted * tuple_size, page->GetFreeSpaceRemaining());
+  ASSERT_EQ((deleted - (rids.size() % 2 == 1 ? 1 : 0)) * tuple_size, page->GetFragmentedBytes());
+  for (uint32_t slot = 1; slot < rids.size(); slot += 2) {
+    ExpectRow(page, schema.get(), rids[slot], slot);
+  }
+
+  // Scenario: an update that grows a tuple moves the tuples below it, deleted bytes included.
+  Fields fields{Field(TypeId::kTypeInt, 5000), Field(TypeId::kTypeChar, const_cast<char *>("grown to 16 char"), 16,
+                                                     false)};
+  Row grown(fields);
+  Row old_row(rids[1]);
+  ASSERT_EQ(1, page->UpdateTuple(grown, &old_row, schema.get(), nullptr, nullptr, nullptr));
+  ExpectRow(page, schema.get(), rids[1], 5000);
+
+  // Scenario: inserts pack the page once they run out of contiguous space and fill the reclaimed space.
+  uint32_t inserted = 0;
+  while (InsertRow(page, schema.get(), 1000 + inserted).GetPageId() != INVALID_PAGE_ID) {
+    inserted++;
+  }
+  ASSERT_GE(inserted, deleted - 1);
+  ASSERT_EQ(0, page->GetFragmentedBytes());
+  ExpectRow(page, schema.get(), rids[1], 5000);
+  for (uint32_t slot = 3; slot < rids.size(); slot += 2) {
+    ExpectRow(page, schema.get(), rids[slot], slot);
+  }
+}
@@ -1,6 +1,11 @@
 #include "storage/disk_manager.h"
 
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -34,6 +39,42 @@ TEST(DiskManagerTest, BitMapPageTest) {
   ASSERT_FALSE(bitmap->AllocatePage(ofs));
 }
 
+TEST(DiskManagerTest, BitmapRunTest) {
+  const size_t size = 512;
+  char buf[size];
+  memset(buf, 0, size);
+  BitmapPage<size> *bitmap = reinterpret_cast<BitmapPage<size> *>(buf);
+  uint32_t ofs;
+  ASSERT_TRUE(bitmap->AllocateRun(64, ofs));
+  ASSERT_EQ(0, ofs);
+  ASSERT_TRUE(bitmap->AllocatePage(ofs));
+  ASSERT_EQ(64, ofs);
+  for (uint32_t i = 5; i < 15; i++) {
+    ASSERT_TRUE(bitmap->DeAllocatePage(i));
+  }
+  // Scenario: a run skips the holes that are too short and takes the lowest one that is long enough.
+  ASSERT_TRUE(bitmap->AllocateRun(20, ofs));
+  ASSERT_EQ(65, ofs);
+  ASSERT_TRUE(bitmap->AllocateRun(10, ofs));
+  ASSERT_EQ(5, ofs);
+  ASSERT_TRUE(bitmap->AllocatePage(ofs));
+  ASSERT_EQ(85, ofs);
+  // Scenario: a run at a given page stops at the next allocated page.
+  ASSERT_EQ(8, bitmap->AllocateRunAt(100, 8));
+  ASSERT_EQ(0, bitmap->AllocateRunAt(100, 8));
+  ASSERT_EQ(14, bitmap->AllocateRunAt(86, 64));
+  ASSERT_TRUE(bitmap->IsPageFree(108));
+  ASSERT_EQ(108, bitmap->GetAllocatedPages());
+  ASSERT_EQ(108, bitmap->CountAllocated());
+  // Scenario: runs crossing word boundaries up to the very end of the bitmap.
+  uint32_t num_free = bitmap->GetMaxSupportedSize() - 108;
+  ASSERT_FALSE(bitmap->AllocateRun(num_free + 1, ofs));
+  ASSERT_TRUE(bitmap->AllocateRun(num_free, ofs));
+  ASSERT_EQ(108, ofs);
+  ASSERT_FALSE(bitmap->AllocatePage(ofs));
+  ASSERT_EQ(bitmap->GetMaxSupportedSize(), bitmap->CountAllocated());
+}
+
 TEST(DiskManagerTest, FreePageAllocationTest) {
   std::string db_name = "disk_test.db";
   remove(db_name.c_str());
@@ -56,4 +97,401 @@ TEST(DiskManagerTest, FreePageAllocationTest) {
   EXPECT_EQ(extent_nums * DiskManager::BITMAP_SIZE - 5, meta_page->GetAllocatedPages());
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 2, meta_page->GetExtentUsedPage(0));
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 3, meta_page->GetExtentUsedPage(1));
-}
\ No newline at end of file
+}
+
+TEST(DiskManagerTest, DirectIOTest) {
+  std::string db_name = "disk_direct_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name, true);
+  // Scenario: aligned buffers are transferred directly, unaligned ones through the bounce buffer.
+  alignas(PAGE_SIZE) static char aligned[PAGE_SIZE + 1];
+  char *unaligned = aligned + 1;
+  for (int i = 0; i < 8; i++) {
+    page_id_t page_id = disk_mgr->AllocatePage();
+    char *buffer = (i % 2 == 0) ? aligned : unaligned;
+    memset(buffer, 'a' + i, PAGE_SIZE);
+    disk_mgr->WritePage(page_id, buffer);
+  }
+  delete disk_mgr;
+
+  disk_mgr = new DiskManager(db_name, true);
+  for (int i = 0; i < 8; i++) {
+    char *buffer = (i % 2 == 0) ? unaligned : aligned;
+    disk_mgr->ReadPage(i, buffer);
+    EXPECT_EQ(std::string(PAGE_SIZE, 'a' + i), std::string(buffer, PAGE_SIZE));
+    EXPECT_FALSE(disk_mgr->IsPageFree(i));
+  }
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, WritePagesTest) {
+  std::string db_name = "disk_write_pages_test.db";
+  // Pages around the end of the first extent, the bitmap page of the second extent sits between two of them.
+  const page_id_t first = DiskManager::BITMAP_SIZE - 64;
+  const page_id_t num_pages = 128;
+  for (bool direct_io : {false, true}) {
+    remove(db_name.c_str());
+    auto *disk_mgr = new DiskManager(db_name, direct_io);
+    while (disk_mgr->AllocatePage() < first + num_pages - 1) {
+    }
+    // Scenario: a batch in random order, with holes and buffers of any alignment.
+    auto *buffers = static_cast<char *>(std::aligned_alloc(PAGE_SIZE, (num_pages + 1) * PAGE_SIZE));
+    std::vector<std::pair<page_id_t, const char *>> pages;
+    for (page_id_t i = 0; i < num_pages; i++) {
+      if (i % 7 == 3) {
+        continue;
+      }
+      char *buffer = buffers + i * PAGE_SIZE + (i % 5 == 0 ? 1 : 0);
+      snprintf(buffer, PAGE_SIZE, "page-%d", first + i);
+      pages.emplace_back(first + i, buffer);
+    }
+    std::shuffle(pages.begin(), pages.end(), std::default_random_engine(0));
+    disk_mgr->WritePages(pages);
+    disk_mgr->Sync();
+    delete disk_mgr;
+
+    disk_mgr = new DiskManager(db_name, direct_io);
+    char buffer[PAGE_SIZE];
+    for (page_id_t i = 0; i < num_pages; i++) {
+      disk_mgr->ReadPage(first + i, buffer);
+      EXPECT_EQ(i % 7 == 3 ? "" : "page-" + std::to_string(first + i), std::string(buffer)) << i;
+    }
+    EXPECT_FALSE(disk_mgr->IsPageFree(DiskManager::BITMAP_SIZE));
+    delete disk_mgr;
+    std::free(buffers);
+  }
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, ParallelIOTest) {
+  std::string db_name = "disk_parallel_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  const int num_threads = 8;
+  const int pages_per_thread = 64;
+  for (int i = 0; i < num_threads * pages_per_thread; i++) {
+    disk_mgr->AllocatePage();
+  }
+  // Scenario: pages past the end of the file read as zeros.
+  char buffer[PAGE_SIZE];
+  memset(buffer, 'x', PAGE_SIZE);
+  disk_mgr->ReadPage(num_threads * pages_per_thread - 1, buffer);
+  EXPECT_EQ(std::string(PAGE_SIZE, '\0'), std::string(buffer, PAGE_SIZE));
+
+  // Scenario: threads write and read back their own pages at the same time.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      char data[PAGE_SIZE];
+      for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < pages_per_thread; i++) {
+          page_id_t page_id = i * num_threads + t;
+          memset(data, 'a' + (page_id + round) % 26, PAGE_SIZE);
+          disk_mgr->WritePage(page_id, data);
+        }
+        for (int i = 0; i < pages_per_thread; i++) {
+          page_id_t page_id = i * num_threads + t;
+          disk_mgr->ReadPage(page_id, data);
+          EXPECT_EQ(std::string(PAGE_SIZE, 'a' + (page_id + round) % 26), std::string(data, PAGE_SIZE));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, CachedBitmapTest) {
+  std::string db_name = "disk_bitmap_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  const page_id_t num_pages = DiskManager::BITMAP_SIZE * 2 + 10;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+  }
+  // Scenario: freed pages are handed out again, lowest extent first.
+  disk_mgr->DeAllocatePage(DiskManager::BITMAP_SIZE + 5);
+  disk_mgr->DeAllocatePage(7);
+  EXPECT_TRUE(disk_mgr->IsPageFree(7));
+  EXPECT_EQ(7, disk_mgr->AllocatePage());
+  EXPECT_EQ(DiskManager::BITMAP_SIZE + 5, disk_mgr->AllocatePage());
+  EXPECT_EQ(num_pages, disk_mgr->AllocatePage());
+  disk_mgr->DeAllocatePage(3);
+  delete disk_mgr;
+
+  // Scenario: the lazily written bitmaps and counters survive a restart.
+  disk_mgr = new DiskManager(db_name);
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(3, meta_page->GetExtentNums());
+  EXPECT_EQ(num_pages, meta_page->GetAllocatedPages());
+  EXPECT_EQ(DiskManager::BITMAP_SIZE - 1, meta_page->GetExtentUsedPage(0));
+  EXPECT_TRUE(disk_mgr->IsPageFree(3));
+  EXPECT_FALSE(disk_mgr->IsPageFree(DiskManager::BITMAP_SIZE + 5));
+  EXPECT_FALSE(disk_mgr->IsPageFree(num_pages));
+  EXPECT_TRUE(disk_mgr->IsPageFree(num_pages + 1));
+  EXPECT_TRUE(disk_mgr->IsPageFree(DiskManager::BITMAP_SIZE * 5));
+  EXPECT_EQ(3, disk_mgr->AllocatePage());
+  EXPECT_EQ(num_pages + 1, disk_mgr->AllocatePage());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, SegmentAllocationTest) {
+  std::string db_name = "disk_segment_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  // Scenario: a segment growing alone continues its runs and gets contiguous pages.
+  for (page_id_t i = 0; i < SEGMENT_RUN_PAGES * 2 + 2; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage(TableHeapSegmentId(0)));
+  }
+  // Scenario: segments growing at the same time get a run of their own each, lone pages are not taken from runs.
+  page_id_t lone = disk_mgr->AllocatePage();
+  EXPECT_EQ(SEGMENT_RUN_PAGES * 3, lone);
+  std::vector<page_id_t> table_pages;
+  std::vector<page_id_t> index_pages;
+  for (int i = 0; i < SEGMENT_RUN_PAGES + 10; i++) {
+    table_pages.push_back(disk_mgr->AllocatePage(TableHeapSegmentId(1000)));
+    index_pages.push_back(disk_mgr->AllocatePage(IndexSegmentId(0)));
+  }
+  std::unordered_set<page_id_t> page_set;
+  for (auto *pages : {&table_pages, &index_pages}) {
+    for (size_t i = 0; i < pages->size(); i++) {
+      ASSERT_TRUE(page_set.insert((*pages)[i]).second);
+      ASSERT_FALSE(disk_mgr->IsPageFree((*pages)[i]));
+      if (i % SEGMENT_RUN_PAGES != 0) {
+        ASSERT_EQ((*pages)[i - 1] + 1, (*pages)[i]);
+      }
+    }
+  }
+  // the unused rest of a run is free but counts as allocated
+  page_id_t reserved = table_pages.back() + 1;
+  EXPECT_TRUE(disk_mgr->IsPageFree(reserved));
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(SEGMENT_RUN_PAGES * 7 + 1, meta_page->GetAllocatedPages());
+  EXPECT_NE(reserved, disk_mgr->AllocatePage());
+  // Scenario: releasing a segment gives its reserved pages back.
+  disk_mgr->ReleaseSegment(TableHeapSegmentId(1000));
+  EXPECT_EQ(SEGMENT_RUN_PAGES * 7 + 2 - (SEGMENT_RUN_PAGES - 10), meta_page->GetAllocatedPages());
+  delete disk_mgr;
+
+  // Scenario: closing gives back the reserved pages of every segment.
+  disk_mgr = new DiskManager(db_name);
+  meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(SEGMENT_RUN_PAGES * 2 + 2 + 1 + 2 * (SEGMENT_RUN_PAGES + 10) + 1, meta_page->GetAllocatedPages());
+  EXPECT_TRUE(disk_mgr->IsPageFree(index_pages.back() + 1));
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, CompressedPagesTest) {
+  std::string db_name = "disk_compressed_test.db";
+  std::string slot_file = DiskManager::GetSlotFileName(db_name);
+  remove(db_name.c_str());
+  auto *disk_mgr =
+      new DiskManager(db_name, false, DurabilityMode::NONE, std::chrono::milliseconds(DEFAULT_SYNC_INTERVAL_MS), true);
+  ASSERT_TRUE(disk_mgr->IsCompressed());
+  std::mt19937 rng(7);
+  char compressible[PAGE_SIZE];
+  char random[PAGE_SIZE];
+  memset(compressible, 0, PAGE_SIZE);
+  snprintf(compressible, PAGE_SIZE, "A page that is mostly zeros");
+  for (auto &c : random) {
+    c = static_cast<char>(rng());
+  }
+  page_id_t small = disk_mgr->AllocatePage();
+  page_id_t large = disk_mgr->AllocatePage();
+  page_id_t unwritten = disk_mgr->AllocatePage();
+  disk_mgr->WritePage(small, compressible);
+  disk_mgr->WritePage(large, random);
+  // Scenario: compressible pages move fewer bytes, incompressible ones are stored as they are.
+  EXPECT_LT(disk_mgr->GetDataBytesWritten(), PAGE_SIZE + DiskManager::SLOT_UNIT_SIZE);
+  EXPECT_EQ(PAGE_SIZE + DiskManager::SLOT_UNIT_SIZE, std::filesystem::file_size(slot_file));
+  char buf[PAGE_SIZE];
+  disk_mgr->ReadPage(small, buf);
+  EXPECT_EQ(0, memcmp(buf, compressible, PAGE_SIZE));
+  disk_mgr->ReadPage(large, buf);
+  EXPECT_EQ(0, memcmp(buf, random, PAGE_SIZE));
+  EXPECT_LT(disk_mgr->GetDataBytesRead(), PAGE_SIZE + DiskManager::SLOT_UNIT_SIZE);
+  disk_mgr->ReadPage(unwritten, buf);
+  EXPECT_EQ(PAGE_SIZE, std::count(buf, buf + PAGE_SIZE, 0));
+  // Scenario: a page that outgrows its slot moves, the slot it left is only reused once the page map is on disk.
+  disk_mgr->WritePage(small, random);
+  EXPECT_EQ(2 * PAGE_SIZE + DiskManager::SLOT_UNIT_SIZE, std::filesystem::file_size(slot_file));
+  disk_mgr->WritePage(unwritten, compressible);
+  size_t slot_file_size = std::filesystem::file_size(slot_file);
+  EXPECT_GT(slot_file_size, 2 * PAGE_SIZE + DiskManager::SLOT_UNIT_SIZE);
+  disk_mgr->Checkpoint();
+  page_id_t reused = disk_mgr->AllocatePage();
+  disk_mgr->WritePage(reused, compressible);
+  EXPECT_EQ(slot_file_size, std::filesystem::file_size(slot_file));
+  disk_mgr->ReadPage(reused, buf);
+  EXPECT_EQ(0, memcmp(buf, compressible, PAGE_SIZE));
+  disk_mgr->DeAllocatePage(large);
+  delete disk_mgr;
+
+  // Scenario: the page map survives a restart, the free slot of the de-allocated page is reused.
+  disk_mgr = new DiskManager(db_name);
+  ASSERT_TRUE(disk_mgr->IsCompressed());
+  disk_mgr->ReadPage(small, buf);
+  EXPECT_EQ(0, memcmp(buf, random, PAGE_SIZE));
+  disk_mgr->ReadPage(unwritten, buf);
+  EXPECT_EQ(0, memcmp(buf, compressible, PAGE_SIZE));
+  page_id_t page_id = disk_mgr->AllocatePage();
+  disk_mgr->WritePage(page_id, random);
+  EXPECT_EQ(slot_file_size, std::filesystem::file_size(slot_file));
+  delete disk_mgr;
+  remove(db_name.c_str());
+  remove(slot_file.c_str());
+
+  // Scenario: a db file created uncompressed stays uncompressed.
+  disk_mgr = new DiskManager(db_name);
+  disk_mgr->WritePage(disk_mgr->AllocatePage(), random);
+  delete disk_mgr;
+  disk_mgr =
+      new DiskManager(db_name, false, DurabilityMode::NONE, std::chrono::milliseconds(DEFAULT_SYNC_INTERVAL_MS), true);
+  EXPECT_FALSE(disk_mgr->IsCompressed());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, DurabilityTest) {
+  std::string db_name = "disk_durability_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  char data[PAGE_SIZE];
+  memset(data, 'a', PAGE_SIZE);
+  page_id_t page_id = disk_mgr->AllocatePage();
+  // Scenario: with no durability the writes stay unsynced, a checkpoint only writes back the metadata.
+  ASSERT_EQ(DurabilityMode::NONE, disk_mgr->GetDurability());
+  disk_mgr->WritePage(page_id, data);
+  disk_mgr->Checkpoint();
+  EXPECT_TRUE(disk_mgr->HasUnsyncedWrites());
+  // Scenario: strict durability syncs at the checkpoint.
+  disk_mgr->SetDurability(DurabilityMode::STRICT);
+  disk_mgr->Checkpoint();
+  EXPECT_FALSE(disk_mgr->HasUnsyncedWrites());
+  // Scenario: periodic durability syncs in the background.
+  disk_mgr->SetDurability(DurabilityMode::PERIODIC, std::chrono::milliseconds(10));
+  disk_mgr->WritePage(page_id, data);
+  for (int i = 0; i < 500 && disk_mgr->HasUnsyncedWrites(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_FALSE(disk_mgr->HasUnsyncedWrites());
+  delete disk_mgr;
+
+  disk_mgr = new DiskManager(db_name);
+  disk_mgr->ReadPage(page_id, data);
+  EXPECT_EQ(std::string(PAGE_SIZE, 'a'), std::string(data, PAGE_SIZE));
+  EXPECT_FALSE(disk_mgr->IsPageFree(page_id));
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, IOQueueTest) {
+  std::string db_name = "disk_io_queue_test.db";
+  const page_id_t num_pages = 200;
+  for (auto backend : {IOBackend::IO_URING, IOBackend::THREAD_POOL, IOBackend::SYNC}) {
+    for (bool direct_io : {false, true}) {
+      remove(db_name.c_str());
+      auto *disk_mgr = new DiskManager(db_name, direct_io);
+      for (page_id_t i = 0; i < num_pages; i++) {
+        disk_mgr->AllocatePage();
+      }
+      auto io = disk_mgr->CreateIOQueue(16, backend);
+      EXPECT_TRUE(io->GetBackend() == backend || backend == IOBackend::IO_URING);
+      // Scenario: a batch deeper than the queue, some buffers unaligned, every page written once.
+      auto *buffers = static_cast<char *>(std::aligned_alloc(PAGE_SIZE, 2 * num_pages * PAGE_SIZE));
+      std::vector<PageIORequest> requests(num_pages);
+      std::vector<PageIORequest *> batch;
+      for (page_id_t i = 0; i < num_pages; i++) {
+        char *buffer = buffers + 2 * i * PAGE_SIZE + (i % 9 == 0 ? 1 : 0);
+        memset(buffer, 'a' + i % 26, PAGE_SIZE);
+        requests[i] = {PageIORequest::WRITE, i, buffer, nullptr};
+        batch.push_back(&requests[i]);
+      }
+      std::vector<PageIORequest *> completed;
+      io->Submit(batch);
+      while (io->InFlight() > 0) {
+        io->Reap(&completed, 1);
+      }
+      EXPECT_EQ(num_pages, completed.size());
+
+      // Scenario: read them back along with pages past the end of the file, which read as zeros.
+      memset(buffers, 'x', 2 * num_pages * PAGE_SIZE);
+      batch.clear();
+      for (page_id_t i = 0; i < num_pages; i++) {
+        requests[i].type_ = PageIORequest::READ;
+        requests[i].page_id_ = (i % 10 == 5) ? num_pages + i : i;
+        batch.push_back(&requests[i]);
+      }
+      completed.clear();
+      io->Submit(batch);
+      EXPECT_EQ(num_pages, io->Reap(&completed, num_pages));
+      EXPECT_EQ(0, io->InFlight());
+      for (page_id_t i = 0; i < num_pages; i++) {
+        char expected = (i % 10 == 5) ? '\0' : static_cast<char>('a' + i % 26);
+        EXPECT_EQ(std::string(PAGE_SIZE, expected), std::string(requests[i].data_, PAGE_SIZE)) << i;
+      }
+      io.reset();
+      delete disk_mgr;
+      std::free(buffers);
+    }
+  }
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, FileSpaceTest) {
+  std::string db_name = "disk_space_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  const int num_pages = 1000;
+  char data[PAGE_SIZE];
+  for (page_id_t i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+    memset(data, i % 256, PAGE_SIZE);
+    disk_mgr->WritePage(i, data);
+  }
+  disk_mgr->Checkpoint();
+  // Scenario: the file is grown in preallocated chunks, past its size.
+  const size_t chunk = static_cast<size_t>(FILE_PREALLOCATE_PAGES) * PAGE_SIZE;
+  size_t file_size = disk_mgr->GetDbFileSize();
+  EXPECT_EQ(static_cast<size_t>(num_pages + 2) * PAGE_SIZE, file_size);
+  EXPECT_EQ((file_size + chunk - 1) / chunk * chunk, disk_mgr->GetDiskUsage());
+  // Scenario: a long run of freed pages gives its space back at the next checkpoint, a short one does not.
+  size_t disk_usage = disk_mgr->GetDiskUsage();
+  for (page_id_t i = 100; i < 500; i++) {
+    disk_mgr->DeAllocatePage(i);
+  }
+  for (page_id_t i = 600; i < 600 + HOLE_PUNCH_MIN_PAGES - 1; i++) {
+    disk_mgr->DeAllocatePage(i);
+  }
+  disk_mgr->Checkpoint();
+  EXPECT_EQ(disk_usage - 400 * PAGE_SIZE, disk_mgr->GetDiskUsage());
+  // Scenario: vacuum cuts the free pages and the preallocated space at the end of the file off.
+  for (page_id_t i = 700; i < num_pages; i++) {
+    disk_mgr->DeAllocatePage(i);
+  }
+  ASSERT_TRUE(disk_mgr->Vacuum());
+  EXPECT_EQ(static_cast<size_t>(700 + 2) * PAGE_SIZE, disk_mgr->GetDbFileSize());
+  EXPECT_EQ(static_cast<size_t>(700 + 2 - 400) * PAGE_SIZE, disk_mgr->GetDiskUsage());
+  delete disk_mgr;
+
+  // the pages in use are left as they were
+  disk_mgr = new DiskManager(db_name);
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(700 - 400 - HOLE_PUNCH_MIN_PAGES + 1, meta_page->GetAllocatedPages());
+  for (page_id_t i = 0; i < 700; i++) {
+    bool in_use = i < 100 || (i >= 500 && i < 600) || i >= 600 + HOLE_PUNCH_MIN_PAGES - 1;
+    ASSERT_EQ(!in_use, disk_mgr->IsPageFree(i));
+    if (in_use) {
+      disk_mgr->ReadPage(i, data);
+      ASSERT_EQ(PAGE_SIZE, std::count(data, data + PAGE_SIZE, static_cast<char>(i % 256)));
+    }
+  }
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
@@ -0,0 +1,158 @@
+#include "storage/page_compressor.h"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "record/field.h"
+#include "record/schema.h"
+#include "storage/disk_manager.h"
+#include "storage/table_heap.h"
+
+using Fields = std::vector<Field>;
+
+static void ExpectRoundTrip(const std::vector<char> &data) {
+  // literals only is the worst case: a token, the literal length and the literals
+  std::vector<char> compressed(data.size() + data.size() / 255 + 16);
+  size_t length = PageCompressor::Compress(data.data(), data.size(), compressed.data(), compressed.size());
+  ASSERT_GT(length, 0);
+  std::vector<char> decompressed(data.size());
+  ASSERT_TRUE(PageCompressor::Decompress(compressed.data(), length, decompressed.data(), decompressed.size()));
+  ASSERT_EQ(data, decompressed);
+}
+
+TEST(PageCompressorTest, RoundTripTest) {
+  std::mt19937 rng(17);
+  std::vector<char> random(PAGE_SIZE);
+  for (auto &c : random) {
+    c = static_cast<char>(rng());
+  }
+  ExpectRoundTrip(random);
+  ExpectRoundTrip(std::vector<char>(PAGE_SIZE, 0));
+  ExpectRoundTrip(std::vector<char>(1, 'x'));
+  for (size_t size = 0; size < 20; size++) {
+    ExpectRoundTrip(std::vector<char>(random.begin(), random.begin() + size));
+  }
+  // long literal runs and long matches need length continuation bytes
+  std::vector<char> mixed(random.begin(), random.begin() + 1000);
+  mixed.resize(3000, 'z');
+  mixed.insert(mixed.end(), random.begin(), random.begin() + 600);
+  ExpectRoundTrip(mixed);
+  // short repeated patterns make matches that overlap the bytes they produce
+  std::vector<char> pattern;
+  for (int i = 0; i < PAGE_SIZE; i++) {
+    pattern.push_back("abcab"[i % 5]);
+  }
+  ExpectRoundTrip(pattern);
+}
+
+TEST(PageCompressorTest, IncompressibleAndCorruptTest) {
+  std::mt19937 rng(23);
+  std::vector<char> random(PAGE_SIZE);
+  for (auto &c : random) {
+    c = static_cast<char>(rng());
+  }
+  std::vector<char> compressed(PAGE_SIZE);
+  // Scenario: data that does not compress into the space given is refused.
+  ASSERT_EQ(0, PageCompressor::Compress(random.data(), PAGE_SIZE, compressed.data(), PAGE_SIZE - 512));
+  // Scenario: truncated or damaged data is rejected without reading or writing out of bounds.
+  std::vector<char> page(PAGE_SIZE, 0);
+  memcpy(page.data() + 100, random.data(), 300);
+  size_t length = PageCompressor::Compress(page.data(), PAGE_SIZE, compressed.data(), compressed.size());
+  ASSERT_GT(length, 0);
+  std::vector<char> decompressed(PAGE_SIZE);
+  // the data ends with a match, only the empty last sequence may be left out
+  for (size_t prefix = 0; prefix + 1 < length; prefix++) {
+    ASSERT_FALSE(PageCompressor::Decompress(compressed.data(), prefix, decompressed.data(), PAGE_SIZE));
+  }
+  for (int i = 0; i < 1000; i++) {
+    std::vector<char> damaged(compressed.begin(), compressed.begin() + length);
+    damaged[rng() % length] = static_cast<char>(rng());
+    PageCompressor::Decompress(damaged.data(), length, decompressed.data(), PAGE_SIZE);
+  }
+}
+
+/**
+ * Compression ratio and CPU cost on table pages of small ints, floats and short strings, the kind of rows the tables
+ * of this database mostly hold.
+ */
+TEST(PageCompressorTest, CompressionBenchmark) {
+  std::string db_name = "page_compressor_test.db";
+  remove(db_name.c_str());
+  remove(DiskManager::GetSlotFileName(db_name).c_str());
+  auto *disk_mgr = new DiskManager(db_name, false, DurabilityMode::NONE,
+                                   std::chrono::milliseconds(DEFAULT_SYNC_INTERVAL_MS), true);
+  ASSERT_TRUE(disk_mgr->IsCompressed());
+  auto *bpm = new BufferPoolManager(1024, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 16, 1, true, false),
+                                   new Column("price", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  const char *names[] = {"apple", "banana", "cherry", "durian", "elderberry", "fig", "grape", "honeydew"};
+  std::mt19937 rng(31);
+  const int row_nums = 50000;
+  for (int i = 0; i < row_nums; i++) {
+    const char *name = names[rng() % 8];
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, const_cast<char *>(name), strlen(name), true),
+                  Field(TypeId::kTypeFloat, static_cast<float>(rng() % 10000) / 100)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  bpm->FlushAllPages();
+  // read back the page images, through the compressed store
+  std::vector<page_id_t> page_ids;
+  for (page_id_t page_id = table_heap->GetFirstPageId(); page_id != INVALID_PAGE_ID;) {
+    page_ids.push_back(page_id);
+    auto *page = reinterpret_cast<TablePage *>(bpm->FetchPage(page_id));
+    page_id_t next_page_id = page->GetNextPageId();
+    bpm->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  size_t num_pages = page_ids.size();
+  std::vector<char> images(num_pages * PAGE_SIZE);
+  uint64_t bytes_read = disk_mgr->GetDataBytesRead();
+  for (size_t i = 0; i < num_pages; i++) {
+    disk_mgr->ReadPage(page_ids[i], &images[i * PAGE_SIZE]);
+  }
+  bytes_read = disk_mgr->GetDataBytesRead() - bytes_read;
+  size_t stored = disk_mgr->GetCompressedSize();
+  double ratio = static_cast<double>(num_pages * PAGE_SIZE) / stored;
+
+  // CPU cost of the codec alone, on the same pages
+  const int rounds = 20;
+  std::vector<char> compressed(num_pages * PAGE_SIZE);
+  std::vector<size_t> lengths(num_pages);
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    for (size_t i = 0; i < num_pages; i++) {
+      lengths[i] = PageCompressor::Compress(&images[i * PAGE_SIZE], PAGE_SIZE, &compressed[i * PAGE_SIZE], PAGE_SIZE);
+    }
+  }
+  double compress_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::vector<char> page(PAGE_SIZE);
+  start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    for (size_t i = 0; i < num_pages; i++) {
+      ASSERT_TRUE(PageCompressor::Decompress(&compressed[i * PAGE_SIZE], lengths[i], page.data(), PAGE_SIZE));
+    }
+  }
+  double decompress_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  double mb = static_cast<double>(num_pages) * PAGE_SIZE * rounds / (1 << 20);
+  printf("%zu table pages: stored %zu of %zu bytes, ratio %.2f, %zu bytes read for a full scan\n", num_pages, stored,
+         num_pages * PAGE_SIZE, ratio, static_cast<size_t>(bytes_read));
+  printf("compress %.0f ns/page (%.0f MB/s), decompress %.0f ns/page (%.0f MB/s)\n",
+         compress_ns / (num_pages * rounds), mb / (compress_ns / 1e9), decompress_ns / (num_pages * rounds),
+         mb / (decompress_ns / 1e9));
+  EXPECT_GT(ratio, 1.5);
+  EXPECT_LT(bytes_read, num_pages * PAGE_SIZE);
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(db_name.c_str());
+  remove(DiskManager::GetSlotFileName(db_name).c_str());
+}
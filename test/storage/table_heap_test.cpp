@@ -1,6 +1,8 @@
 #include "storage/table_heap.h"
 
+#include <algorithm>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "common/instance.h"
@@ -61,3 +63,231 @@ TEST(TableHeapTest, TableHeapSampleTest) {
   }
   ASSERT_EQ(size, 0);
 }
+
+static std::vector<page_id_t> GetHeapPages(BufferPoolManager *bpm, page_id_t first_page_id) {
+  std::vector<page_id_t> page_ids;
+  for (page_id_t page_id = first_page_id; page_id != INVALID_PAGE_ID;) {
+    page_ids.push_back(page_id);
+    auto *page = reinterpret_cast<TablePage *>(bpm->FetchPage(page_id));
+    page_id_t next_page_id = page->GetNextPageId();
+    bpm->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return page_ids;
+}
+
+static size_t CountRows(TableHeap *table_heap) {
+  size_t count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    count++;
+  }
+  return count;
+}
+
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr = new DiskManager(db_file_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char name[64];
+  memset(name, 'x', sizeof(name));
+  auto insert = [&](TableHeap *table_heap, int id) {
+    Fields fields{Field(TypeId::kTypeInt, id), Field(TypeId::kTypeChar, name, sizeof(name), false)};
+    Row row(fields);
+    EXPECT_TRUE(table_heap->InsertTuple(row, nullptr));
+    return row.GetRowId();
+  };
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  page_id_t fsm_page_id = table_heap->GetFreeSpaceMapPageId();
+  ASSERT_NE(INVALID_PAGE_ID, fsm_page_id);
+  const int row_nums = 1000;
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    rids.push_back(insert(table_heap, i));
+  }
+  auto pages = GetHeapPages(bpm, first_page_id);
+  ASSERT_GT(pages.size(), 10);
+
+  // Scenario: space freed on the first half of the heap is reused by later inserts instead of growing the heap.
+  std::unordered_set<page_id_t> emptied(pages.begin(), pages.begin() + pages.size() / 2);
+  int deleted = 0;
+  for (auto &rid : rids) {
+    if (emptied.count(rid.GetPageId())) {
+      ASSERT_TRUE(table_heap->MarkDelete(rid, nullptr));
+      table_heap->ApplyDelete(rid, nullptr);
+      deleted++;
+    }
+  }
+  for (int i = 0; i < deleted; i++) {
+    RowId rid = insert(table_heap, row_nums + i);
+    Row row(rid);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, row_nums + i)));
+  }
+  ASSERT_EQ(pages, GetHeapPages(bpm, first_page_id));
+  ASSERT_EQ(row_nums, CountRows(table_heap));
+
+  // Scenario: a reopened heap reads the map and the tail of the page chain back from the map pages.
+  delete table_heap;
+  table_heap = TableHeap::Create(bpm, first_page_id, schema.get(), nullptr, nullptr, fsm_page_id);
+  for (int i = 0; i < 200; i++) {
+    insert(table_heap, 2 * row_nums + i);
+  }
+  auto grown = GetHeapPages(bpm, first_page_id);
+  ASSERT_GT(grown.size(), pages.size());
+  ASSERT_TRUE(std::equal(pages.begin(), pages.end(), grown.begin()));
+  ASSERT_EQ(row_nums + 200, CountRows(table_heap));
+
+  // Scenario: a heap written without a map gets one built from its page chain on the first insert.
+  delete table_heap;
+  table_heap = TableHeap::Create(bpm, first_page_id, schema.get(), nullptr, nullptr);
+  ASSERT_EQ(INVALID_PAGE_ID, table_heap->GetFreeSpaceMapPageId());
+  insert(table_heap, 3 * row_nums);
+  ASSERT_NE(INVALID_PAGE_ID, table_heap->GetFreeSpaceMapPageId());
+  ASSERT_EQ(grown, GetHeapPages(bpm, first_page_id));
+  ASSERT_EQ(row_nums + 201, CountRows(table_heap));
+
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, VacuumTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr = new DiskManager(db_file_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char name[64];
+  memset(name, 'v', sizeof(name));
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  const int row_nums = 2000;
+  std::unordered_map<int, RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, sizeof(name), false)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids[i] = row.GetRowId();
+  }
+  auto pages = GetHeapPages(bpm, first_page_id);
+
+  // Scenario: deletes only marked by a statement are applied, sparse pages are merged and empty pages are freed.
+  // Rows are kept in runs of a few per page so that whole pages empty out and others end up sparse.
+  std::unordered_map<int, RowId> kept;
+  for (int i = 0; i < row_nums; i++) {
+    if (i % 100 < 5) {
+      kept[i] = rids[i];
+    } else {
+      ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+    }
+  }
+  ASSERT_EQ(row_nums - kept.size(), table_heap->GetDeadTupleCount());
+  std::unordered_map<int64_t, RowId> moves;
+  auto stats = table_heap->Vacuum(
+      VACUUM_MERGE_FILL, [&](Row &row, const RowId &old_rid) { moves[old_rid.Get()] = row.GetRowId(); }, nullptr);
+  ASSERT_EQ(row_nums - kept.size(), stats.applied_deletes);
+  ASSERT_EQ(moves.size(), stats.moved_tuples);
+  ASSERT_GT(stats.moved_tuples, 0);
+  auto vacuumed = GetHeapPages(bpm, first_page_id);
+  ASSERT_EQ(pages.size() - stats.freed_pages, vacuumed.size());
+  ASSERT_LT(vacuumed.size(), pages.size() / 4);
+  ASSERT_EQ(0, table_heap->GetDeadTupleCount());
+  for (auto &kv : kept) {
+    RowId rid = moves.count(kv.second.Get()) ? moves[kv.second.Get()] : kv.second;
+    Row row(rid);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, kv.first)));
+  }
+  ASSERT_EQ(kept.size(), CountRows(table_heap));
+  // the remaining pages are linked both ways
+  for (size_t i = 0; i < vacuumed.size(); i++) {
+    auto *page = reinterpret_cast<TablePage *>(bpm->FetchPage(vacuumed[i]));
+    ASSERT_EQ(i == 0 ? INVALID_PAGE_ID : vacuumed[i - 1], page->GetPrevPageId());
+    bpm->UnpinPage(vacuumed[i], false);
+  }
+
+  // Scenario: inserts after a vacuum fill the kept pages first and then grow the heap from its new tail.
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, row_nums + i), Field(TypeId::kTypeChar, name, sizeof(name), false)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  auto grown = GetHeapPages(bpm, first_page_id);
+  ASSERT_TRUE(std::equal(vacuumed.begin(), vacuumed.end(), grown.begin()));
+  ASSERT_EQ(kept.size() + row_nums, CountRows(table_heap));
+
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, AppenderTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr = new DiskManager(db_file_name);
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char name[64];
+  memset(name, 'a', sizeof(name));
+  TableHeap *table_heap = TableHeap::Create(bpm, schema.get(), nullptr, nullptr, nullptr);
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  const int row_nums = 2000;
+
+  // Scenario: appended rows fill the heap page after page in order, keeping only the page being filled pinned.
+  std::vector<RowId> rids;
+  {
+    TableHeap::Appender appender(table_heap, nullptr);
+    for (int i = 0; i < row_nums; i++) {
+      Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, sizeof(name), false)};
+      Row row(fields);
+      ASSERT_TRUE(appender.Append(row));
+      rids.push_back(row.GetRowId());
+    }
+    ASSERT_FALSE(bpm->CheckAllUnpinned());
+  }
+  ASSERT_TRUE(bpm->CheckAllUnpinned());
+  auto pages = GetHeapPages(bpm, first_page_id);
+  ASSERT_GT(pages.size(), 1);
+  for (int i = 1; i < row_nums; i++) {
+    auto position = [&](const RowId &rid) {
+      return std::make_pair(std::find(pages.begin(), pages.end(), rid.GetPageId()) - pages.begin(), rid.GetSlotNum());
+    };
+    ASSERT_LT(position(rids[i - 1]), position(rids[i]));
+  }
+  for (size_t i = 0; i < pages.size(); i++) {
+    auto *page = reinterpret_cast<TablePage *>(bpm->FetchPage(pages[i]));
+    ASSERT_EQ(i == 0 ? INVALID_PAGE_ID : pages[i - 1], page->GetPrevPageId());
+    bpm->UnpinPage(pages[i], false);
+  }
+  ASSERT_EQ(row_nums, CountRows(table_heap));
+
+  // Scenario: the appended pages are in the free space map, inserts go to the room freed in them once the tail is full.
+  for (int i = 0; i < row_nums; i++) {
+    if (rids[i].GetPageId() == pages[1]) {
+      ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+      table_heap->ApplyDelete(rids[i], nullptr);
+    }
+  }
+  page_id_t insert_page_id = pages.back();
+  for (int i = 0; i < row_nums && insert_page_id == pages.back(); i++) {
+    Fields fields{Field(TypeId::kTypeInt, row_nums + i), Field(TypeId::kTypeChar, name, sizeof(name), false)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    insert_page_id = row.GetRowId().GetPageId();
+  }
+  ASSERT_EQ(pages[1], insert_page_id);
+  ASSERT_EQ(pages.size(), GetHeapPages(bpm, first_page_id).size());
+
+  delete table_heap;
+  delete bpm;
+  delete disk_mgr;
+  remove(db_file_name.c_str());
+}